@@ -19,9 +19,11 @@ package com.android.inputmethod.latin;
 import android.text.TextUtils;
 import android.util.SparseArray;
 
+import com.android.inputmethod.annotations.UsedForTesting;
 import com.android.inputmethod.keyboard.ProximityInfo;
 import com.android.inputmethod.latin.SuggestedWords.SuggestedWordInfo;
 
+import java.nio.ByteBuffer;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Locale;
@@ -35,15 +37,10 @@ public final class BinaryDictionary extends Dictionary {
     // Must be equal to MAX_WORD_LENGTH in native/jni/src/defines.h
     private static final int MAX_WORD_LENGTH = Constants.Dictionary.MAX_WORD_LENGTH;
     // Must be equal to MAX_RESULTS in native/jni/src/defines.h
-    private static final int MAX_RESULTS = 18;
+    static final int MAX_RESULTS = 18;
 
     private long mNativeDict;
     private final Locale mLocale;
-    private final int[] mInputCodePoints = new int[MAX_WORD_LENGTH];
-    private final int[] mOutputCodePoints = new int[MAX_WORD_LENGTH * MAX_RESULTS];
-    private final int[] mSpaceIndices = new int[MAX_RESULTS];
-    private final int[] mOutputScores = new int[MAX_RESULTS];
-    private final int[] mOutputTypes = new int[MAX_RESULTS];
 
     private final boolean mUseFullEditDistance;
 
@@ -77,32 +74,66 @@ public final class BinaryDictionary extends Dictionary {
      */
     public BinaryDictionary(final String filename, final long offset, final long length,
             final boolean useFullEditDistance, final Locale locale, final String dictType) {
+        this(filename, offset, length, useFullEditDistance, locale, dictType,
+                false /* useDecodedTrie */);
+    }
+
+    /**
+     * Constructor for the binary dictionary that can traverse a decoded copy of the trie.
+     * @param filename the name of the file to read through native code.
+     * @param offset the offset of the dictionary data within the file.
+     * @param length the length of the binary data.
+     * @param useFullEditDistance whether to use the full edit distance in suggestions
+     * @param dictType the dictionary type, as a human-readable string
+     * @param useDecodedTrie whether to decode the char groups into arrays when opening the
+     * dictionary. This makes traversals faster but takes a few MB for a main dictionary.
+     */
+    public BinaryDictionary(final String filename, final long offset, final long length,
+            final boolean useFullEditDistance, final Locale locale, final String dictType,
+            final boolean useDecodedTrie) {
         super(dictType);
         mLocale = locale;
         mUseFullEditDistance = useFullEditDistance;
-        loadDictionary(filename, offset, length);
+        loadDictionary(filename, offset, length, useDecodedTrie);
     }
 
     static {
         JniUtils.loadNativeLibrary();
     }
 
-    private static native long openNative(String sourceDir, long dictOffset, long dictSize);
+    private static native long openNative(String sourceDir, long dictOffset, long dictSize,
+            boolean useDecodedTrie);
     private static native void closeNative(long dict);
     private static native int getProbabilityNative(long dict, int[] word);
     private static native boolean isValidBigramNative(long dict, int[] word1, int[] word2);
+    private static native void getProbabilitiesNative(long dict, int[] codePoints,
+            int[] wordSizes, int[] outputProbabilities);
+    private static native void isValidBigramsNative(long dict, int[] codePoints1,
+            int[] wordSizes1, int[] codePoints2, int[] wordSizes2, boolean[] outputResults);
     private static native int getSuggestionsNative(long dict, long proximityInfo,
             long traverseSession, int[] xCoordinates, int[] yCoordinates, int[] times,
             int[] pointerIds, int[] inputCodePoints, int inputSize, int commitPoint,
             boolean isGesture, int[] prevWordCodePointArray, boolean useFullEditDistance,
             int[] outputCodePoints, int[] outputScores, int[] outputIndices, int[] outputTypes);
+    private static native int getSuggestionsInSharedBufferNative(long dict, long proximityInfo,
+            long traverseSession, ByteBuffer sharedBuffer, int commitPoint, boolean isGesture,
+            boolean useFullEditDistance);
+    private static native int getSuggestionsForSessionInputNative(long dict, long proximityInfo,
+            long traverseSession, int commitPoint, boolean isGesture,
+            int[] prevWordCodePointArray, boolean useFullEditDistance, int[] outputCodePoints,
+            int[] outputScores, int[] outputIndices, int[] outputTypes);
+    private static native int getSuggestionsBatchNative(long dict, long proximityInfo,
+            long traverseSession, int[] inputCodePoints, int[] inputSizes, int[] xCoordinates,
+            int[] yCoordinates, int[] prevWordCodePoints, int[] prevWordSizes,
+            boolean useFullEditDistance, int[] outputCodePoints, int[] outputScores,
+            int[] outputTypes, int[] outputCounts);
     private static native float calcNormalizedScoreNative(int[] before, int[] after, int score);
     private static native int editDistanceNative(int[] before, int[] after);
 
     // TODO: Move native dict into session
     private final void loadDictionary(final String path, final long startOffset,
-            final long length) {
-        mNativeDict = openNative(path, startOffset, length);
+            final long length, final boolean useDecodedTrie) {
+        mNativeDict = openNative(path, startOffset, length, useDecodedTrie);
     }
 
     @Override
@@ -113,13 +144,114 @@ public final class BinaryDictionary extends Dictionary {
                 0 /* sessionId */);
     }
 
+    /**
+     * Bounds the time and the amount of work of the suggestion calls made with a session.
+     * @see DicTraverseSession#setSearchBudget(int, int)
+     */
+    public void setSearchBudget(final int sessionId, final int timeBudgetMicros,
+            final int maxExpandedDicNodeCount) {
+        getTraverseSession(sessionId).setSearchBudget(timeBudgetMicros, maxExpandedDicNodeCount);
+    }
+
+    /**
+     * Returns whether the last suggestion call made with a session ran out of budget, in which
+     * case its suggestions are the best ones found before that.
+     */
+    public boolean isLastSearchPartial(final int sessionId) {
+        return getTraverseSession(sessionId).isLastSearchPartial();
+    }
+
+    /**
+     * Gets the hit count and the miss count of the bigram maps of a session.
+     * @see DicTraverseSession#getBigramMapCounts()
+     */
+    public int[] getBigramMapCounts(final int sessionId) {
+        return getTraverseSession(sessionId).getBigramMapCounts();
+    }
+
+    /**
+     * Appends touch points to the input kept by a session.
+     * @see DicTraverseSession#appendTouchPoints(int[], int[], int[], int[], int[], int)
+     */
+    public void appendTouchPoints(final int sessionId, final int[] codePoints,
+            final int[] xCoordinates, final int[] yCoordinates, final int[] times,
+            final int[] pointerIds, final int count) {
+        getTraverseSession(sessionId).appendTouchPoints(codePoints, xCoordinates, yCoordinates,
+                times, pointerIds, count);
+    }
+
+    /**
+     * Removes the last input from the input kept by a session.
+     * @see DicTraverseSession#removeLastInput()
+     */
+    public void removeLastInput(final int sessionId) {
+        getTraverseSession(sessionId).removeLastInput();
+    }
+
+    /**
+     * Removes all the touch points of the input kept by a session.
+     * @see DicTraverseSession#resetInput()
+     */
+    public void resetInput(final int sessionId) {
+        getTraverseSession(sessionId).resetInput();
+    }
+
+    /**
+     * Same as {@link #getSuggestionsWithSessionId}, but the input is the touch points appended
+     * to the session since its input was last reset, instead of the whole input of a composer.
+     */
+    public ArrayList<SuggestedWordInfo> getSuggestionsForSessionInput(final int sessionId,
+            final String prevWord, final ProximityInfo proximityInfo, final boolean isGesture,
+            final boolean blockOffensiveWords) {
+        if (!isValidDictionary()) return null;
+
+        final DicTraverseSession session = getTraverseSession(sessionId);
+        // TODO: toLowerCase in the native code
+        final int[] prevWordCodePointArray = (null == prevWord)
+                ? null : StringUtils.toCodePointArray(prevWord);
+        final int count = getSuggestionsForSessionInputNative(mNativeDict,
+                proximityInfo.getNativeProximityInfo(), session.getSession(),
+                0 /* commitPoint */, isGesture, prevWordCodePointArray, mUseFullEditDistance,
+                session.mOutputCodePoints, session.mOutputScores, session.mSpaceIndices,
+                session.mOutputTypes);
+        return getSuggestedWordInfos(count, 0 /* resultIndex */, session.mOutputCodePoints,
+                session.mOutputScores, session.mOutputTypes, blockOffensiveWords);
+    }
+
+    // Calls with different session ids may run concurrently on different threads, but a session
+    // must not be used by two threads at the same time.
     @Override
     public ArrayList<SuggestedWordInfo> getSuggestionsWithSessionId(final WordComposer composer,
             final String prevWord, final ProximityInfo proximityInfo,
             final boolean blockOffensiveWords, final int sessionId) {
+        return getSuggestionsWithSessionId(composer, prevWord, proximityInfo, blockOffensiveWords,
+                sessionId, true /* useSharedBuffer */);
+    }
+
+    /**
+     * Same as {@link #getSuggestionsWithSessionId}, but the input is always passed to the native
+     * code in arrays instead of the shared buffer of the session.
+     */
+    @UsedForTesting
+    ArrayList<SuggestedWordInfo> getSuggestionsWithoutSharedBuffer(final WordComposer composer,
+            final String prevWord, final ProximityInfo proximityInfo,
+            final boolean blockOffensiveWords, final int sessionId) {
+        return getSuggestionsWithSessionId(composer, prevWord, proximityInfo, blockOffensiveWords,
+                sessionId, false /* useSharedBuffer */);
+    }
+
+    private ArrayList<SuggestedWordInfo> getSuggestionsWithSessionId(final WordComposer composer,
+            final String prevWord, final ProximityInfo proximityInfo,
+            final boolean blockOffensiveWords, final int sessionId,
+            final boolean useSharedBuffer) {
         if (!isValidDictionary()) return null;
 
-        Arrays.fill(mInputCodePoints, Constants.NOT_A_CODE);
+        final DicTraverseSession session = getTraverseSession(sessionId);
+        final int[] inputCodePoints = session.mInputCodePoints;
+        final int[] outputCodePoints = session.mOutputCodePoints;
+        final int[] outputScores = session.mOutputScores;
+        final int[] outputTypes = session.mOutputTypes;
+        Arrays.fill(inputCodePoints, Constants.NOT_A_CODE);
         // TODO: toLowerCase in the native code
         final int[] prevWordCodePointArray = (null == prevWord)
                 ? null : StringUtils.toCodePointArray(prevWord);
@@ -129,28 +261,123 @@ public final class BinaryDictionary extends Dictionary {
         if (composerSize <= 1 || !isGesture) {
             if (composerSize > MAX_WORD_LENGTH - 1) return null;
             for (int i = 0; i < composerSize; i++) {
-                mInputCodePoints[i] = composer.getCodeAt(i);
+                inputCodePoints[i] = composer.getCodeAt(i);
             }
         }
 
         final InputPointers ips = composer.getInputPointers();
         final int inputSize = isGesture ? ips.getPointerSize() : composerSize;
+        if (useSharedBuffer && session.putSharedInput(inputCodePoints, ips, inputSize,
+                prevWordCodePointArray)) {
+            final int count = getSuggestionsInSharedBufferNative(mNativeDict,
+                    proximityInfo.getNativeProximityInfo(), session.getSession(),
+                    session.mSharedBuffer, 0 /* commitPoint */, isGesture, mUseFullEditDistance);
+            session.getSharedOutput(count);
+            return getSuggestedWordInfos(count, 0 /* resultIndex */, outputCodePoints,
+                    outputScores, outputTypes, blockOffensiveWords);
+        }
         // proximityInfo and/or prevWordForBigrams may not be null.
         final int count = getSuggestionsNative(mNativeDict, proximityInfo.getNativeProximityInfo(),
-                getTraverseSession(sessionId).getSession(), ips.getXCoordinates(),
-                ips.getYCoordinates(), ips.getTimes(), ips.getPointerIds(), mInputCodePoints,
-                inputSize, 0 /* commitPoint */, isGesture, prevWordCodePointArray,
-                mUseFullEditDistance, mOutputCodePoints, mOutputScores, mSpaceIndices,
-                mOutputTypes);
+                session.getSession(), ips.getXCoordinates(), ips.getYCoordinates(),
+                ips.getTimes(), ips.getPointerIds(), inputCodePoints, inputSize,
+                0 /* commitPoint */, isGesture, prevWordCodePointArray, mUseFullEditDistance,
+                outputCodePoints, outputScores, session.mSpaceIndices, outputTypes);
+        return getSuggestedWordInfos(count, 0 /* resultIndex */, outputCodePoints, outputScores,
+                outputTypes, blockOffensiveWords);
+    }
+
+    // Typed words only: the coordinates of gestures are not passed to the native code, so a
+    // gesture would be searched as the keys of its code points. Gestures are rejected instead.
+    @Override
+    public ArrayList<ArrayList<SuggestedWordInfo>> getSuggestionsBatch(
+            final WordComposer[] composers, final String[] prevWords,
+            final ProximityInfo proximityInfo, final boolean blockOffensiveWords,
+            final int sessionId) {
+        if (!isValidDictionary()) return null;
+
+        final int itemCount = composers.length;
+        final int[] inputSizes = new int[itemCount];
+        final int[] prevWordSizes = new int[itemCount];
+        final int[][] prevWordCodePointArrays = new int[itemCount][];
+        int totalInputSize = 0;
+        int totalPrevWordSize = 0;
+        for (int i = 0; i < itemCount; ++i) {
+            if (composers[i].isBatchMode()) {
+                throw new IllegalArgumentException("Gesture in a batch of suggestions: " + i);
+            }
+            inputSizes[i] = composers[i].size();
+            totalInputSize += inputSizes[i];
+            // TODO: toLowerCase in the native code
+            prevWordCodePointArrays[i] = (null == prevWords[i])
+                    ? null : StringUtils.toCodePointArray(prevWords[i]);
+            prevWordSizes[i] = (null == prevWordCodePointArrays[i])
+                    ? 0 : prevWordCodePointArrays[i].length;
+            totalPrevWordSize += prevWordSizes[i];
+        }
+        final int[] inputCodePoints = new int[totalInputSize];
+        final int[] xCoordinates = new int[totalInputSize];
+        final int[] yCoordinates = new int[totalInputSize];
+        final int[] prevWordCodePoints = new int[totalPrevWordSize];
+        int inputStart = 0;
+        int prevWordStart = 0;
+        for (int i = 0; i < itemCount; ++i) {
+            final WordComposer composer = composers[i];
+            final InputPointers ips = composer.getInputPointers();
+            // The native code skips the words too long to be words, whose touch points the
+            // composer doesn't all keep.
+            if (!isTooLongForSuggestions(inputSizes[i])) {
+                for (int j = 0; j < inputSizes[i]; ++j) {
+                    inputCodePoints[inputStart + j] = composer.getCodeAt(j);
+                }
+                System.arraycopy(ips.getXCoordinates(), 0, xCoordinates, inputStart,
+                        inputSizes[i]);
+                System.arraycopy(ips.getYCoordinates(), 0, yCoordinates, inputStart,
+                        inputSizes[i]);
+            }
+            inputStart += inputSizes[i];
+            if (null != prevWordCodePointArrays[i]) {
+                System.arraycopy(prevWordCodePointArrays[i], 0, prevWordCodePoints,
+                        prevWordStart, prevWordSizes[i]);
+                prevWordStart += prevWordSizes[i];
+            }
+        }
+
+        final int[] outputCodePoints = new int[itemCount * MAX_WORD_LENGTH * MAX_RESULTS];
+        final int[] outputScores = new int[itemCount * MAX_RESULTS];
+        final int[] outputTypes = new int[itemCount * MAX_RESULTS];
+        final int[] outputCounts = new int[itemCount];
+        getSuggestionsBatchNative(mNativeDict, proximityInfo.getNativeProximityInfo(),
+                getTraverseSession(sessionId).getSession(), inputCodePoints, inputSizes,
+                xCoordinates, yCoordinates, prevWordCodePoints, prevWordSizes,
+                mUseFullEditDistance, outputCodePoints, outputScores, outputTypes, outputCounts);
+        final ArrayList<ArrayList<SuggestedWordInfo>> suggestionsList =
+                CollectionUtils.newArrayList(itemCount);
+        for (int i = 0; i < itemCount; ++i) {
+            // Same as getSuggestionsWithSessionId for the words too long to be words.
+            suggestionsList.add(isTooLongForSuggestions(inputSizes[i]) ? null
+                    : getSuggestedWordInfos(outputCounts[i], i * MAX_RESULTS, outputCodePoints,
+                            outputScores, outputTypes, blockOffensiveWords));
+        }
+        return suggestionsList;
+    }
+
+    private static boolean isTooLongForSuggestions(final int inputSize) {
+        return inputSize > MAX_WORD_LENGTH - 1;
+    }
+
+    // Converts the count results starting at resultIndex in the native output arrays.
+    private ArrayList<SuggestedWordInfo> getSuggestedWordInfos(final int count,
+            final int resultIndex, final int[] outputCodePoints, final int[] outputScores,
+            final int[] outputTypes, final boolean blockOffensiveWords) {
         final ArrayList<SuggestedWordInfo> suggestions = CollectionUtils.newArrayList();
-        for (int j = 0; j < count; ++j) {
+        for (int j = resultIndex; j < resultIndex + count; ++j) {
             final int start = j * MAX_WORD_LENGTH;
             int len = 0;
-            while (len < MAX_WORD_LENGTH && mOutputCodePoints[start + len] != 0) {
+            while (len < MAX_WORD_LENGTH && outputCodePoints[start + len] != 0) {
                 ++len;
             }
             if (len > 0) {
-                final int flags = mOutputTypes[j] & SuggestedWordInfo.KIND_MASK_FLAGS;
+                final int flags = outputTypes[j] & SuggestedWordInfo.KIND_MASK_FLAGS;
                 if (blockOffensiveWords
                         && 0 != (flags & SuggestedWordInfo.KIND_FLAG_POSSIBLY_OFFENSIVE)
                         && 0 == (flags & SuggestedWordInfo.KIND_FLAG_EXACT_MATCH)) {
@@ -158,12 +385,12 @@ public final class BinaryDictionary extends Dictionary {
                     // offensive, then we don't output it unless it's also an exact match.
                     continue;
                 }
-                final int kind = mOutputTypes[j] & SuggestedWordInfo.KIND_MASK_KIND;
+                final int kind = outputTypes[j] & SuggestedWordInfo.KIND_MASK_KIND;
                 final int score = SuggestedWordInfo.KIND_WHITELIST == kind
-                        ? SuggestedWordInfo.MAX_SCORE : mOutputScores[j];
+                        ? SuggestedWordInfo.MAX_SCORE : outputScores[j];
                 // TODO: check that all users of the `kind' parameter are ready to accept
-                // flags too and pass mOutputTypes[j] instead of kind
-                suggestions.add(new SuggestedWordInfo(new String(mOutputCodePoints, start, len),
+                // flags too and pass outputTypes[j] instead of kind
+                suggestions.add(new SuggestedWordInfo(new String(outputCodePoints, start, len),
                         score, kind, mDictType));
             }
         }
@@ -200,8 +427,15 @@ public final class BinaryDictionary extends Dictionary {
         return getProbabilityNative(mNativeDict, codePoints);
     }
 
-    // TODO: Add a batch process version (isValidBigramMultiple?) to avoid excessive numbers of jni
-    // calls when checking for changes in an entire dictionary.
+    @Override
+    public int[] getFrequencies(final String[] words) {
+        final int[] wordSizes = new int[words.length];
+        final int[] codePoints = toPackedCodePoints(words, wordSizes);
+        final int[] frequencies = new int[words.length];
+        getProbabilitiesNative(mNativeDict, codePoints, wordSizes, frequencies);
+        return frequencies;
+    }
+
     public boolean isValidBigram(final String word1, final String word2) {
         if (TextUtils.isEmpty(word1) || TextUtils.isEmpty(word2)) return false;
         final int[] codePoints1 = StringUtils.toCodePointArray(word1);
@@ -209,6 +443,48 @@ public final class BinaryDictionary extends Dictionary {
         return isValidBigramNative(mNativeDict, codePoints1, codePoints2);
     }
 
+    /**
+     * Checks several bigrams at once, to avoid a JNI call per bigram.
+     * @param words1 the first word of each bigram
+     * @param words2 the second word of each bigram
+     * @return whether each bigram is valid, as returned by {@link #isValidBigram(String, String)}
+     */
+    public boolean[] isValidBigrams(final String[] words1, final String[] words2) {
+        if (words1.length != words2.length) {
+            throw new IllegalArgumentException();
+        }
+        final int[] wordSizes1 = new int[words1.length];
+        final int[] wordSizes2 = new int[words2.length];
+        final int[] codePoints1 = toPackedCodePoints(words1, wordSizes1);
+        final int[] codePoints2 = toPackedCodePoints(words2, wordSizes2);
+        final boolean[] results = new boolean[words1.length];
+        isValidBigramsNative(mNativeDict, codePoints1, wordSizes1, codePoints2, wordSizes2,
+                results);
+        return results;
+    }
+
+    // Packs the code points of the words one after the other, and writes their lengths to
+    // outWordSizes. A null word is packed as an empty word.
+    private static int[] toPackedCodePoints(final String[] words, final int[] outWordSizes) {
+        final int[][] codePointArrays = new int[words.length][];
+        int totalSize = 0;
+        for (int i = 0; i < words.length; ++i) {
+            codePointArrays[i] = (null == words[i])
+                    ? null : StringUtils.toCodePointArray(words[i]);
+            outWordSizes[i] = (null == codePointArrays[i]) ? 0 : codePointArrays[i].length;
+            totalSize += outWordSizes[i];
+        }
+        final int[] codePoints = new int[totalSize];
+        int start = 0;
+        for (int i = 0; i < words.length; ++i) {
+            if (null != codePointArrays[i]) {
+                System.arraycopy(codePointArrays[i], 0, codePoints, start, outWordSizes[i]);
+                start += outWordSizes[i];
+            }
+        }
+        return codePoints;
+    }
+
     @Override
     public void close() {
         synchronized (mDicTraverseSessions) {
@@ -16,6 +16,9 @@
 
 package com.android.inputmethod.latin;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.IntBuffer;
 import java.util.Locale;
 
 public final class DicTraverseSession {
@@ -27,6 +30,58 @@ public final class DicTraverseSession {
     private static native void initDicTraverseSessionNative(long nativeDicTraverseSession,
             long dictionary, int[] previousWord, int previousWordLength);
     private static native void releaseDicTraverseSessionNative(long nativeDicTraverseSession);
+    private static native void setSearchBudgetNative(long nativeDicTraverseSession,
+            int timeBudgetMicros, int maxExpandedDicNodeCount);
+    private static native boolean isLastSearchPartialNative(long nativeDicTraverseSession);
+    private static native void getBigramMapCountsNative(long nativeDicTraverseSession,
+            int[] outputCounts);
+    private static native void appendTouchPointsNative(long nativeDicTraverseSession,
+            int[] codePoints, int[] xCoordinates, int[] yCoordinates, int[] times,
+            int[] pointerIds, int count);
+    private static native void removeLastInputNative(long nativeDicTraverseSession);
+    private static native void resetInputNative(long nativeDicTraverseSession);
+
+    // Buffers of a suggestion call, so that calls on different sessions of a dictionary can run
+    // concurrently.
+    public final int[] mInputCodePoints = new int[Constants.Dictionary.MAX_WORD_LENGTH];
+    public final int[] mOutputCodePoints =
+            new int[Constants.Dictionary.MAX_WORD_LENGTH * BinaryDictionary.MAX_RESULTS];
+    public final int[] mSpaceIndices = new int[BinaryDictionary.MAX_RESULTS];
+    public final int[] mOutputScores = new int[BinaryDictionary.MAX_RESULTS];
+    public final int[] mOutputTypes = new int[BinaryDictionary.MAX_RESULTS];
+
+    // Must be equal to MAX_SHARED_INPUT_POINT_COUNT in
+    // native/jni/com_android_inputmethod_latin_BinaryDictionary.cpp
+    public static final int MAX_SHARED_INPUT_POINT_COUNT = 512;
+    // Layout of the shared buffer, in ints. Must be equal to the layout of SharedSuggestionBuffer
+    // in native/jni/com_android_inputmethod_latin_BinaryDictionary.cpp
+    private static final int MAX_WORD_LENGTH = Constants.Dictionary.MAX_WORD_LENGTH;
+    private static final int INPUT_SIZE_INDEX = 0;
+    private static final int PREV_WORD_LENGTH_INDEX = INPUT_SIZE_INDEX + 1;
+    private static final int INPUT_CODE_POINTS_INDEX = PREV_WORD_LENGTH_INDEX + 1;
+    private static final int X_COORDINATES_INDEX = INPUT_CODE_POINTS_INDEX + MAX_WORD_LENGTH;
+    private static final int Y_COORDINATES_INDEX =
+            X_COORDINATES_INDEX + MAX_SHARED_INPUT_POINT_COUNT;
+    private static final int TIMES_INDEX = Y_COORDINATES_INDEX + MAX_SHARED_INPUT_POINT_COUNT;
+    private static final int POINTER_IDS_INDEX = TIMES_INDEX + MAX_SHARED_INPUT_POINT_COUNT;
+    private static final int PREV_WORD_CODE_POINTS_INDEX =
+            POINTER_IDS_INDEX + MAX_SHARED_INPUT_POINT_COUNT;
+    private static final int OUTPUT_CODE_POINTS_INDEX =
+            PREV_WORD_CODE_POINTS_INDEX + MAX_WORD_LENGTH;
+    private static final int OUTPUT_SCORES_INDEX =
+            OUTPUT_CODE_POINTS_INDEX + MAX_WORD_LENGTH * BinaryDictionary.MAX_RESULTS;
+    private static final int SPACE_INDICES_INDEX =
+            OUTPUT_SCORES_INDEX + BinaryDictionary.MAX_RESULTS;
+    private static final int OUTPUT_TYPES_INDEX =
+            SPACE_INDICES_INDEX + BinaryDictionary.MAX_RESULTS;
+    private static final int SHARED_BUFFER_INT_COUNT =
+            OUTPUT_TYPES_INDEX + BinaryDictionary.MAX_RESULTS;
+
+    // Direct buffer that the native code reads the input of a suggestion call from and writes
+    // the suggestions to in place, instead of copying them from and to the arrays above.
+    public final ByteBuffer mSharedBuffer = ByteBuffer.allocateDirect(
+            SHARED_BUFFER_INT_COUNT * (Integer.SIZE / Byte.SIZE)).order(ByteOrder.nativeOrder());
+    private final IntBuffer mSharedInts = mSharedBuffer.asIntBuffer();
 
     private long mNativeDicTraverseSession;
 
@@ -49,6 +104,119 @@ public final class DicTraverseSession {
                 mNativeDicTraverseSession, dictionary, previousWord, previousWordLength);
     }
 
+    /**
+     * Bounds the time and the amount of work of each suggestion call made with this session.
+     * A call that runs out of budget returns the best suggestions found so far, and
+     * {@link #isLastSearchPartial()} returns true until the next call.
+     * @param timeBudgetMicros the time budget in microseconds, or 0 for no limit.
+     * @param maxExpandedDicNodeCount the maximum number of search nodes to expand, or 0 for no
+     * limit.
+     */
+    public void setSearchBudget(int timeBudgetMicros, int maxExpandedDicNodeCount) {
+        setSearchBudgetNative(mNativeDicTraverseSession, timeBudgetMicros,
+                maxExpandedDicNodeCount);
+    }
+
+    public boolean isLastSearchPartial() {
+        return isLastSearchPartialNative(mNativeDicTraverseSession);
+    }
+
+    /**
+     * Gets how many lookups of the bigrams of a previous word found them in the bigram maps of
+     * the session, and how many had to read them from the dictionary, since its creation. The
+     * ratio tells whether the maps cache enough previous words for the input.
+     * @return the hit count and the miss count
+     */
+    public int[] getBigramMapCounts() {
+        final int[] counts = new int[2];
+        getBigramMapCountsNative(mNativeDicTraverseSession, counts);
+        return counts;
+    }
+
+    /**
+     * Appends touch points to the input kept by the session, as one input: a key press or a new
+     * part of a gesture. The suggestion calls on this input only redo the work for the touch
+     * points that changed since the previous call.
+     * @param codePoints the code points of the touch points, or null for gestures
+     * @param xCoordinates the x coordinates of the touch points
+     * @param yCoordinates the y coordinates of the touch points
+     * @param times the times of the touch points
+     * @param pointerIds the pointer ids of the touch points
+     * @param count the number of touch points to append
+     */
+    public void appendTouchPoints(final int[] codePoints, final int[] xCoordinates,
+            final int[] yCoordinates, final int[] times, final int[] pointerIds,
+            final int count) {
+        appendTouchPointsNative(mNativeDicTraverseSession, codePoints, xCoordinates,
+                yCoordinates, times, pointerIds, count);
+    }
+
+    /**
+     * Removes the touch points appended by the last {@link #appendTouchPoints} call still in the
+     * input kept by the session, as for a backspace.
+     */
+    public void removeLastInput() {
+        removeLastInputNative(mNativeDicTraverseSession);
+    }
+
+    /**
+     * Removes all the touch points of the input kept by the session, as for a new word.
+     */
+    public void resetInput() {
+        resetInputNative(mNativeDicTraverseSession);
+    }
+
+    /**
+     * Writes the input of a suggestion call to the shared buffer.
+     * @param inputCodePoints the code points of the input, MAX_WORD_LENGTH of them
+     * @param inputPointers the coordinates, the times and the pointer ids of the input
+     * @param inputSize the number of input points
+     * @param prevWord the code points of the previous word, or null if none
+     * @return false if the input doesn't fit in the shared buffer
+     */
+    public boolean putSharedInput(final int[] inputCodePoints, final InputPointers inputPointers,
+            final int inputSize, final int[] prevWord) {
+        final int prevWordLength = (null == prevWord) ? 0 : prevWord.length;
+        if (inputSize > MAX_SHARED_INPUT_POINT_COUNT || prevWordLength > MAX_WORD_LENGTH) {
+            return false;
+        }
+        final IntBuffer ints = mSharedInts;
+        ints.put(INPUT_SIZE_INDEX, inputSize);
+        ints.put(PREV_WORD_LENGTH_INDEX, prevWordLength);
+        ints.position(INPUT_CODE_POINTS_INDEX);
+        ints.put(inputCodePoints, 0, MAX_WORD_LENGTH);
+        ints.position(X_COORDINATES_INDEX);
+        ints.put(inputPointers.getXCoordinates(), 0, inputSize);
+        ints.position(Y_COORDINATES_INDEX);
+        ints.put(inputPointers.getYCoordinates(), 0, inputSize);
+        ints.position(TIMES_INDEX);
+        ints.put(inputPointers.getTimes(), 0, inputSize);
+        ints.position(POINTER_IDS_INDEX);
+        ints.put(inputPointers.getPointerIds(), 0, inputSize);
+        if (prevWordLength > 0) {
+            ints.position(PREV_WORD_CODE_POINTS_INDEX);
+            ints.put(prevWord, 0, prevWordLength);
+        }
+        return true;
+    }
+
+    /**
+     * Reads the first suggestions written by the native code to the shared buffer into the
+     * output arrays.
+     * @param count the number of suggestions to read
+     */
+    public void getSharedOutput(final int count) {
+        final IntBuffer ints = mSharedInts;
+        ints.position(OUTPUT_CODE_POINTS_INDEX);
+        ints.get(mOutputCodePoints, 0, count * MAX_WORD_LENGTH);
+        ints.position(OUTPUT_SCORES_INDEX);
+        ints.get(mOutputScores, 0, count);
+        ints.position(SPACE_INDICES_INDEX);
+        ints.get(mSpaceIndices, 0, count);
+        ints.position(OUTPUT_TYPES_INDEX);
+        ints.get(mOutputTypes, 0, count);
+    }
+
     private final long createNativeDicTraverseSession(String locale) {
         return setDicTraverseSessionNative(locale);
     }
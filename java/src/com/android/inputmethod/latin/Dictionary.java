@@ -68,6 +68,30 @@ public abstract class Dictionary {
         return getSuggestions(composer, prevWord, proximityInfo, blockOffensiveWords);
     }
 
+    /**
+     * Searches for suggestions for several words at once.
+     * @param composers the key sequences to match, which must not be gestures
+     * @param prevWords the previous word of each key sequence, or null if none
+     * @param proximityInfo the object for key proximity. May be ignored by some implementations.
+     * @param blockOffensiveWords whether to block potentially offensive words
+     * @param sessionId the session to search with
+     * @return the list of suggestions of each key sequence (each possibly null if none)
+     */
+    // The default implementation of this method gets the suggestions of each word separately.
+    // Subclasses that can search for several words faster need to override this method.
+    public ArrayList<ArrayList<SuggestedWordInfo>> getSuggestionsBatch(
+            final WordComposer[] composers, final String[] prevWords,
+            final ProximityInfo proximityInfo, final boolean blockOffensiveWords,
+            final int sessionId) {
+        final ArrayList<ArrayList<SuggestedWordInfo>> suggestionsList =
+                CollectionUtils.newArrayList(composers.length);
+        for (int i = 0; i < composers.length; ++i) {
+            suggestionsList.add(getSuggestionsWithSessionId(composers[i], prevWords[i],
+                    proximityInfo, blockOffensiveWords, sessionId));
+        }
+        return suggestionsList;
+    }
+
     /**
      * Checks if the given word occurs in the dictionary
      * @param word the word to search for. The search should be case-insensitive.
@@ -79,6 +103,21 @@ public abstract class Dictionary {
         return NOT_A_PROBABILITY;
     }
 
+    /**
+     * Gets the frequencies of several words at once.
+     * @param words the words to search for
+     * @return the frequency of each word, as returned by {@link #getFrequency(String)}
+     */
+    // The default implementation of this method gets the frequency of each word separately.
+    // Subclasses that can look up several words faster need to override this method.
+    public int[] getFrequencies(final String[] words) {
+        final int[] frequencies = new int[words.length];
+        for (int i = 0; i < words.length; ++i) {
+            frequencies[i] = getFrequency(words[i]);
+        }
+        return frequencies;
+    }
+
     /**
      * Compares the contents of the character array with the typed word and returns true if they
      * are the same.
@@ -22,6 +22,7 @@ import com.android.inputmethod.latin.SuggestedWords.SuggestedWordInfo;
 import android.util.Log;
 
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.Collection;
 import java.util.Collections;
 import java.util.concurrent.CopyOnWriteArrayList;
@@ -93,6 +94,21 @@ public final class DictionaryCollection extends Dictionary {
         return maxFreq;
     }
 
+    @Override
+    public int[] getFrequencies(final String[] words) {
+        final int[] maxFreqs = new int[words.length];
+        Arrays.fill(maxFreqs, -1);
+        for (int i = mDictionaries.size() - 1; i >= 0; --i) {
+            final int[] tempFreqs = mDictionaries.get(i).getFrequencies(words);
+            for (int j = 0; j < words.length; ++j) {
+                if (tempFreqs[j] >= maxFreqs[j]) {
+                    maxFreqs[j] = tempFreqs[j];
+                }
+            }
+        }
+        return maxFreqs;
+    }
+
     @Override
     public boolean isInitialized() {
         return !mDictionaries.isEmpty();
@@ -331,6 +331,60 @@ public final class BinaryDictInputOutput {
         return getGroupCountSize(node.mData.size());
     }
 
+    /**
+     * Compute the binary size of the max frequency written before a node, if any.
+     * @param dict the dictionary the node is a part of.
+     * @param node the node
+     * @param options file format options.
+     * @return the size of the max frequency, 0 or 1 byte.
+     */
+    private static int getNodeMaxFrequencySize(final FusionDictionary dict, final Node node,
+            final FormatOptions options) {
+        // The root node is at the start of the dictionary: it is found without reading any
+        // children address, so it doesn't have one.
+        if (!options.mContainsSubtreeMaxFrequencies || dict.mRoot == node) return 0;
+        return FormatSpec.NODE_MAX_FREQUENCY_SIZE;
+    }
+
+    /**
+     * Compute the binary size of the child table written before a node, if any.
+     * @param dict the dictionary the node is a part of.
+     * @param node the node
+     * @param options file format options.
+     * @return the size of the child table, 0 if the node doesn't have one.
+     */
+    private static int getNodeChildTableSize(final FusionDictionary dict, final Node node,
+            final FormatOptions options) {
+        // Like the max frequency, the root node doesn't have one.
+        final int groupCount = node.mData.size();
+        if (!options.mContainsChildTables || dict.mRoot == node
+                || groupCount < FormatSpec.MIN_GROUP_COUNT_FOR_CHILD_TABLE) {
+            return 0;
+        }
+        return (FormatSpec.CHILD_TABLE_CODE_POINT_SIZE + FormatSpec.CHILD_TABLE_OFFSET_SIZE)
+                * groupCount;
+    }
+
+    /**
+     * Compute the highest frequency of the terminals of a node and of its children, and caches
+     * it in the 'mCachedMaxFrequency' member of each node.
+     *
+     * @param node the node to compute the max frequency of.
+     * @return the max frequency, or -1 if there are no terminals.
+     */
+    private static int computeMaxFrequencies(final Node node) {
+        int maxFrequency = -1;
+        for (CharGroup group : node.mData) {
+            if (group.mFrequency > maxFrequency) maxFrequency = group.mFrequency;
+            if (null != group.mChildren) {
+                final int childrenMaxFrequency = computeMaxFrequencies(group.mChildren);
+                if (childrenMaxFrequency > maxFrequency) maxFrequency = childrenMaxFrequency;
+            }
+        }
+        node.mCachedMaxFrequency = maxFrequency;
+        return maxFrequency;
+    }
+
     /**
      * Compute the size of a shortcut in bytes.
      */
@@ -594,14 +648,17 @@ public final class BinaryDictInputOutput {
     /**
      * Computes the byte size of a list of nodes and updates each node cached position.
      *
+     * @param dict the dictionary
      * @param flatNodes the array of nodes.
      * @param formatOptions file format options.
      * @return the byte size of the entire stack.
      */
-    private static int stackNodes(final ArrayList<Node> flatNodes,
+    private static int stackNodes(final FusionDictionary dict, final ArrayList<Node> flatNodes,
             final FormatOptions formatOptions) {
         int nodeOffset = 0;
         for (Node n : flatNodes) {
+            nodeOffset += getNodeChildTableSize(dict, n, formatOptions)
+                    + getNodeMaxFrequencySize(dict, n, formatOptions);
             n.mCachedAddress = nodeOffset;
             int groupCountSize = getGroupCountSize(n);
             int groupOffset = 0;
@@ -639,7 +696,7 @@ public final class BinaryDictInputOutput {
             final ArrayList<Node> flatNodes, final FormatOptions formatOptions) {
         // First get the worst sizes and offsets
         for (Node n : flatNodes) setNodeMaximumSize(n, formatOptions);
-        final int offset = stackNodes(flatNodes, formatOptions);
+        final int offset = stackNodes(dict, flatNodes, formatOptions);
 
         MakedictLog.i("Compressing the array addresses. Original size : " + offset);
         MakedictLog.i("(Recursively seen size : " + offset + ")");
@@ -655,7 +712,7 @@ public final class BinaryDictInputOutput {
                 if (oldNodeSize < newNodeSize) throw new RuntimeException("Increased size ?!");
                 changesDone |= changed;
             }
-            stackNodes(flatNodes, formatOptions);
+            stackNodes(dict, flatNodes, formatOptions);
             ++passes;
             if (passes > MAX_PASSES) throw new RuntimeException("Too many passes - probably a bug");
         } while (changesDone);
@@ -673,15 +730,21 @@ public final class BinaryDictInputOutput {
      *
      * This method checks an array of node for juxtaposition, that is, it will do
      * nothing if each node's cached address is actually the previous node's address
-     * plus the previous node's size.
+     * plus the previous node's size, plus the size of its child table and of its max
+     * frequency if any.
      * If this is not the case, it will throw an exception.
      *
+     * @param dict the dictionary
      * @param array the array node to check
+     * @param formatOptions file format options.
      */
-    private static void checkFlatNodeArray(final ArrayList<Node> array) {
+    private static void checkFlatNodeArray(final FusionDictionary dict,
+            final ArrayList<Node> array, final FormatOptions formatOptions) {
         int offset = 0;
         int index = 0;
         for (Node n : array) {
+            offset += getNodeChildTableSize(dict, n, formatOptions)
+                    + getNodeMaxFrequencySize(dict, n, formatOptions);
             if (n.mCachedAddress != offset) {
                 throw new RuntimeException("Wrong address for node " + index
                         + " : expected " + offset + ", got " + n.mCachedAddress);
@@ -876,7 +939,10 @@ public final class BinaryDictInputOutput {
         return (options.mFrenchLigatureProcessing ? FormatSpec.FRENCH_LIGATURE_PROCESSING_FLAG : 0)
                 + (options.mGermanUmlautProcessing ? FormatSpec.GERMAN_UMLAUT_PROCESSING_FLAG : 0)
                 + (hasBigrams ? FormatSpec.CONTAINS_BIGRAMS_FLAG : 0)
-                + (formatOptions.mSupportsDynamicUpdate ? FormatSpec.SUPPORTS_DYNAMIC_UPDATE : 0);
+                + (formatOptions.mSupportsDynamicUpdate ? FormatSpec.SUPPORTS_DYNAMIC_UPDATE : 0)
+                + (formatOptions.mContainsSubtreeMaxFrequencies
+                        ? FormatSpec.CONTAINS_SUBTREE_MAX_FREQUENCIES_FLAG : 0)
+                + (formatOptions.mContainsChildTables ? FormatSpec.CONTAINS_CHILD_TABLES_FLAG : 0);
     }
 
     /**
@@ -910,6 +976,35 @@ public final class BinaryDictInputOutput {
         }
     }
 
+    /**
+     * Write the child table of a node right before the given end index. The groups of the node
+     * are expected to have their final position cached.
+     *
+     * @param buffer the memory buffer to write to.
+     * @param endIndex the index in the buffer right after the end of the table.
+     * @param node the node to write the child table of.
+     * @param countSize the size of the group count of the node.
+     */
+    private static void writeChildTable(final byte[] buffer, final int endIndex,
+            final Node node, final int countSize) {
+        final int groupCount = node.mData.size();
+        int codePointIndex = endIndex
+                - (FormatSpec.CHILD_TABLE_CODE_POINT_SIZE + FormatSpec.CHILD_TABLE_OFFSET_SIZE)
+                        * groupCount;
+        int offsetIndex = codePointIndex + FormatSpec.CHILD_TABLE_CODE_POINT_SIZE * groupCount;
+        final int firstGroupAddress = node.mCachedAddress + countSize;
+        for (final CharGroup group : node.mData) {
+            final int codePoint = group.mChars[0];
+            buffer[codePointIndex++] = (byte)((codePoint >> 16) & 0xFF);
+            buffer[codePointIndex++] = (byte)((codePoint >> 8) & 0xFF);
+            buffer[codePointIndex++] = (byte)(codePoint & 0xFF);
+            final int offset = group.mCachedAddress - firstGroupAddress;
+            buffer[offsetIndex++] = (byte)((offset >> 16) & 0xFF);
+            buffer[offsetIndex++] = (byte)((offset >> 8) & 0xFF);
+            buffer[offsetIndex++] = (byte)(offset & 0xFF);
+        }
+    }
+
     /**
      * Write a node to memory. The node is expected to have its final position cached.
      *
@@ -931,6 +1026,13 @@ public final class BinaryDictInputOutput {
         final int groupCount = node.mData.size();
         final int countSize = getGroupCountSize(node);
         final int parentAddress = node.mCachedParentAddress;
+        if (0 != getNodeMaxFrequencySize(dict, node, formatOptions)) {
+            buffer[index - FormatSpec.NODE_MAX_FREQUENCY_SIZE] = (byte)node.mCachedMaxFrequency;
+        }
+        if (0 != getNodeChildTableSize(dict, node, formatOptions)) {
+            writeChildTable(buffer, index - getNodeMaxFrequencySize(dict, node, formatOptions),
+                    node, countSize);
+        }
         if (1 == countSize) {
             buffer[index++] = (byte)groupCount;
         } else if (2 == countSize) {
@@ -1178,10 +1280,15 @@ public final class BinaryDictInputOutput {
         MakedictLog.i("Flattening the tree...");
         ArrayList<Node> flatNodes = flattenTree(dict.mRoot);
 
+        if (formatOptions.mContainsSubtreeMaxFrequencies) {
+            MakedictLog.i("Computing max frequencies...");
+            computeMaxFrequencies(dict.mRoot);
+        }
+
         MakedictLog.i("Computing addresses...");
         computeAddresses(dict, flatNodes, formatOptions);
         MakedictLog.i("Checking array...");
-        if (DBG) checkFlatNodeArray(flatNodes);
+        if (DBG) checkFlatNodeArray(dict, flatNodes, formatOptions);
 
         // Create a buffer that matches the final dictionary size.
         final Node lastNode = flatNodes.get(flatNodes.size() - 1);
@@ -1629,7 +1736,9 @@ public final class BinaryDictInputOutput {
                         0 != (optionsFlags & FormatSpec.GERMAN_UMLAUT_PROCESSING_FLAG),
                         0 != (optionsFlags & FormatSpec.FRENCH_LIGATURE_PROCESSING_FLAG)),
                 new FormatOptions(version,
-                        0 != (optionsFlags & FormatSpec.SUPPORTS_DYNAMIC_UPDATE)));
+                        0 != (optionsFlags & FormatSpec.SUPPORTS_DYNAMIC_UPDATE),
+                        0 != (optionsFlags & FormatSpec.CONTAINS_SUBTREE_MAX_FREQUENCIES_FLAG),
+                        0 != (optionsFlags & FormatSpec.CONTAINS_CHILD_TABLES_FLAG)));
         return header;
     }
 
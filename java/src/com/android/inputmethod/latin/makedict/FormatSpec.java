@@ -27,6 +27,27 @@ public final class FormatSpec {
     /*
      * Array of Node(FusionDictionary.Node) layout is as follows:
      *
+     * c | IF CONTAINS_CHILD_TABLES_FLAG (defined in the file header)
+     * h |   AND this is not the root node
+     * i |   AND there are at least MIN_GROUP_COUNT_FOR_CHILD_TABLE groups
+     * l |     the first code point of each group, 3 bytes each, in the order of the groups,
+     * d |     then the offset of each group from the end of the group count, 3 bytes each.
+     *   |     This lets readers look up the groups starting with a code point without decoding
+     * t |     the groups in between. Like the max frequency below, it is before the group count,
+     * a |     where readers that don't know about it never read it.
+     * b |
+     * l |
+     * e |
+     * s |
+     *
+     * m | IF CONTAINS_SUBTREE_MAX_FREQUENCIES_FLAG (defined in the file header)
+     * a |   AND this is not the root node
+     * x |     the highest frequency of the terminals of this node and of its children, 1 byte.
+     *   |     The children address of a group points past this byte, so readers that don't
+     * f |     know about it never read it.
+     * r |
+     * eq
+     *
      * g |
      * r | the number of groups, 1 or 2 bytes.
      * o | 1 byte = bbbbbbbb match
@@ -164,6 +185,8 @@ public final class FormatSpec {
     static final int SUPPORTS_DYNAMIC_UPDATE = 0x2;
     static final int FRENCH_LIGATURE_PROCESSING_FLAG = 0x4;
     static final int CONTAINS_BIGRAMS_FLAG = 0x8;
+    static final int CONTAINS_SUBTREE_MAX_FREQUENCIES_FLAG = 0x10;
+    static final int CONTAINS_CHILD_TABLES_FLAG = 0x20;
 
     // TODO: Make this value adaptative to content data, store it in the header, and
     // use it in the reading code.
@@ -211,6 +234,11 @@ public final class FormatSpec {
     static final int GROUP_ATTRIBUTE_FLAGS_SIZE = 1;
     static final int GROUP_ATTRIBUTE_MAX_ADDRESS_SIZE = 3;
     static final int GROUP_SHORTCUT_LIST_SIZE_SIZE = 2;
+    static final int NODE_MAX_FREQUENCY_SIZE = 1;
+    static final int CHILD_TABLE_CODE_POINT_SIZE = 3;
+    static final int CHILD_TABLE_OFFSET_SIZE = 3;
+    // This needs to be the same numeric value as the one in binary_format.h.
+    static final int MIN_GROUP_COUNT_FOR_CHILD_TABLE = 16;
 
     static final int NO_CHILDREN_ADDRESS = Integer.MIN_VALUE;
     static final int NO_PARENT_ADDRESS = 0;
@@ -236,16 +264,45 @@ public final class FormatSpec {
     public static final class FormatOptions {
         public final int mVersion;
         public final boolean mSupportsDynamicUpdate;
+        public final boolean mContainsSubtreeMaxFrequencies;
+        public final boolean mContainsChildTables;
         public FormatOptions(final int version) {
             this(version, false);
         }
         public FormatOptions(final int version, final boolean supportsDynamicUpdate) {
+            this(version, supportsDynamicUpdate, false);
+        }
+        public FormatOptions(final int version, final boolean supportsDynamicUpdate,
+                final boolean containsSubtreeMaxFrequencies) {
+            this(version, supportsDynamicUpdate, containsSubtreeMaxFrequencies, false);
+        }
+        public FormatOptions(final int version, final boolean supportsDynamicUpdate,
+                final boolean containsSubtreeMaxFrequencies, final boolean containsChildTables) {
             mVersion = version;
             if (version < FIRST_VERSION_WITH_DYNAMIC_UPDATE && supportsDynamicUpdate) {
                 throw new RuntimeException("Dynamic updates are only supported with versions "
                         + FIRST_VERSION_WITH_DYNAMIC_UPDATE + " and ulterior.");
             }
+            if (version < FIRST_VERSION_WITH_HEADER_SIZE && containsSubtreeMaxFrequencies) {
+                throw new RuntimeException("Subtree max frequencies are only supported with"
+                        + " versions " + FIRST_VERSION_WITH_HEADER_SIZE + " and ulterior.");
+            }
+            if (supportsDynamicUpdate && containsSubtreeMaxFrequencies) {
+                // Updating a word would have to update the max frequencies of its parents.
+                throw new RuntimeException("Subtree max frequencies are not supported with"
+                        + " dynamic updates.");
+            }
+            if (version < FIRST_VERSION_WITH_HEADER_SIZE && containsChildTables) {
+                throw new RuntimeException("Child tables are only supported with versions "
+                        + FIRST_VERSION_WITH_HEADER_SIZE + " and ulterior.");
+            }
+            if (supportsDynamicUpdate && containsChildTables) {
+                // Adding or moving a group would have to rewrite the table of its node.
+                throw new RuntimeException("Child tables are not supported with dynamic updates.");
+            }
             mSupportsDynamicUpdate = supportsDynamicUpdate;
+            mContainsSubtreeMaxFrequencies = containsSubtreeMaxFrequencies;
+            mContainsChildTables = containsChildTables;
         }
     }
 
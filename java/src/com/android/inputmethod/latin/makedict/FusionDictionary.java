@@ -48,6 +48,7 @@ public final class FusionDictionary implements Iterable<Word> {
         int mCachedSize = Integer.MIN_VALUE;
         int mCachedAddress = Integer.MIN_VALUE;
         int mCachedParentAddress = 0;
+        int mCachedMaxFrequency = Integer.MIN_VALUE;
 
         public Node() {
             mData = new ArrayList<CharGroup>();
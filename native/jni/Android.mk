@@ -48,8 +48,11 @@ LATIN_IME_JNI_SRC_FILES := \
 LATIN_IME_CORE_SRC_FILES := \
     additional_proximity_chars.cpp \
     bigram_dictionary.cpp \
+    bigram_index.cpp \
+    char_group_jump_table.cpp \
     char_utils.cpp \
     correction.cpp \
+    decoded_trie.cpp \
     dictionary.cpp \
     dic_traverse_wrapper.cpp \
     digraph_utils.cpp \
@@ -58,6 +61,7 @@ LATIN_IME_CORE_SRC_FILES := \
     proximity_info_state.cpp \
     proximity_info_state_utils.cpp \
     unigram_dictionary.cpp \
+    word_position_index.cpp \
     words_priority_queue.cpp \
     suggest/core/suggest.cpp \
     $(addprefix suggest/core/dicnode/, \
@@ -65,7 +69,9 @@ LATIN_IME_CORE_SRC_FILES := \
         dic_node_utils.cpp \
         dic_nodes_cache.cpp) \
     suggest/core/policy/weighting.cpp \
-    suggest/core/session/dic_traverse_session.cpp \
+    $(addprefix suggest/core/session/, \
+        dic_traverse_session.cpp \
+        dic_traverse_thread_pool.cpp) \
     suggest/policyimpl/gesture/gesture_suggest_policy_factory.cpp \
     $(addprefix suggest/policyimpl/typing/, \
         scoring_params.cpp \
@@ -32,18 +32,41 @@
 #include "binary_format.h"
 #include "com_android_inputmethod_latin_BinaryDictionary.h"
 #include "correction.h"
+#include "dic_traverse_wrapper.h"
 #include "dictionary.h"
 #include "jni.h"
 #include "jni_common.h"
+#include "suggest/core/session/streamed_input.h"
 
 namespace latinime {
 
 class ProximityInfo;
 
+// Must be equal to DicTraverseSession.MAX_SHARED_INPUT_POINT_COUNT in Java
+static const int MAX_SHARED_INPUT_POINT_COUNT = 512;
+
+// Layout of the direct buffer that a DicTraverseSession shares with the native code for the
+// suggestion calls. Must be equal to the layout in DicTraverseSession.java.
+struct SharedSuggestionBuffer {
+    int mInputSize;
+    // 0 when there is no previous word
+    int mPrevWordLength;
+    int mInputCodePoints[MAX_WORD_LENGTH];
+    int mXCoordinates[MAX_SHARED_INPUT_POINT_COUNT];
+    int mYCoordinates[MAX_SHARED_INPUT_POINT_COUNT];
+    int mTimes[MAX_SHARED_INPUT_POINT_COUNT];
+    int mPointerIds[MAX_SHARED_INPUT_POINT_COUNT];
+    int mPrevWordCodePoints[MAX_WORD_LENGTH];
+    int mOutputCodePoints[MAX_WORD_LENGTH * MAX_RESULTS];
+    int mScores[MAX_RESULTS];
+    int mSpaceIndices[MAX_RESULTS];
+    int mOutputTypes[MAX_RESULTS];
+};
+
 static void releaseDictBuf(const void *dictBuf, const size_t length, const int fd);
 
 static jlong latinime_BinaryDictionary_open(JNIEnv *env, jclass clazz, jstring sourceDir,
-        jlong dictOffset, jlong dictSize) {
+        jlong dictOffset, jlong dictSize, jboolean useDecodedTrie) {
     PROF_OPEN;
     PROF_START(66);
     const jsize sourceDirUtf8Length = env->GetStringUTFLength(sourceDir);
@@ -118,7 +141,8 @@ static jlong latinime_BinaryDictionary_open(JNIEnv *env, jclass clazz, jstring s
         releaseDictBuf(dictBuf, 0, 0);
 #endif // USE_MMAP_FOR_DICTIONARY
     } else {
-        dictionary = new Dictionary(dictBuf, static_cast<int>(dictSize), fd, adjust);
+        dictionary = new Dictionary(dictBuf, static_cast<int>(dictSize), fd, adjust,
+                useDecodedTrie);
     }
     PROF_END(66);
     PROF_CLOSE;
@@ -204,6 +228,219 @@ static int latinime_BinaryDictionary_getSuggestions(JNIEnv *env, jclass clazz, j
     return count;
 }
 
+// Same as getSuggestions, but the input is read from and the suggestions are written to the shared
+// buffer of the session in place, instead of being copied from and to Java arrays. Returns the
+// number of suggestions.
+static jint latinime_BinaryDictionary_getSuggestionsInSharedBuffer(JNIEnv *env, jclass clazz,
+        jlong dict, jlong proximityInfo, jlong dicTraverseSession, jobject sharedBuffer,
+        jint commitPoint, jboolean isGesture, jboolean useFullEditDistance) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    if (!dictionary) return 0;
+    ProximityInfo *pInfo = reinterpret_cast<ProximityInfo *>(proximityInfo);
+    void *traverseSession = reinterpret_cast<void *>(dicTraverseSession);
+    SharedSuggestionBuffer *const buffer =
+            static_cast<SharedSuggestionBuffer *>(env->GetDirectBufferAddress(sharedBuffer));
+    if (!buffer || env->GetDirectBufferCapacity(sharedBuffer)
+            < static_cast<jlong>(sizeof(SharedSuggestionBuffer))) {
+        AKLOGE("Invalid shared buffer");
+        ASSERT(false);
+        return 0;
+    }
+    const int inputSize = buffer->mInputSize;
+    const int prevWordLength = buffer->mPrevWordLength;
+    if (inputSize < 0 || inputSize > MAX_SHARED_INPUT_POINT_COUNT || prevWordLength < 0
+            || prevWordLength > MAX_WORD_LENGTH) {
+        AKLOGE("Invalid shared buffer input: inputSize=%d prevWordLength=%d", inputSize,
+                prevWordLength);
+        ASSERT(false);
+        return 0;
+    }
+    int *const prevWordCodePoints = prevWordLength > 0 ? buffer->mPrevWordCodePoints : 0;
+
+    // The bigram suggestions are inserted among the previous ones, which must start empty.
+    memset(buffer->mOutputCodePoints, 0, sizeof(buffer->mOutputCodePoints));
+    memset(buffer->mScores, 0, sizeof(buffer->mScores));
+    memset(buffer->mSpaceIndices, 0, sizeof(buffer->mSpaceIndices));
+    memset(buffer->mOutputTypes, 0, sizeof(buffer->mOutputTypes));
+    if (isGesture || inputSize > 0) {
+        return dictionary->getSuggestions(pInfo, traverseSession, buffer->mXCoordinates,
+                buffer->mYCoordinates, buffer->mTimes, buffer->mPointerIds,
+                buffer->mInputCodePoints, inputSize, prevWordCodePoints, prevWordLength,
+                commitPoint, isGesture, useFullEditDistance, buffer->mOutputCodePoints,
+                buffer->mScores, buffer->mSpaceIndices, buffer->mOutputTypes);
+    }
+    return dictionary->getBigrams(prevWordCodePoints, prevWordLength, buffer->mInputCodePoints,
+            inputSize, buffer->mOutputCodePoints, buffer->mScores, buffer->mOutputTypes);
+}
+
+// Same as getSuggestions, but the input is the touch points streamed to the session, which the
+// search reads in place.
+static jint latinime_BinaryDictionary_getSuggestionsForSessionInput(JNIEnv *env, jclass clazz,
+        jlong dict, jlong proximityInfo, jlong dicTraverseSession, jint commitPoint,
+        jboolean isGesture, jintArray prevWordCodePointsForBigrams, jboolean useFullEditDistance,
+        jintArray outputCodePointsArray, jintArray scoresArray, jintArray spaceIndicesArray,
+        jintArray outputTypesArray) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    if (!dictionary) return 0;
+    ProximityInfo *pInfo = reinterpret_cast<ProximityInfo *>(proximityInfo);
+    void *traverseSession = reinterpret_cast<void *>(dicTraverseSession);
+    StreamedInput *const input = DicTraverseWrapper::getStreamedInput(traverseSession);
+    if (!input) return 0;
+    const int inputSize = input->getSize();
+    if (!isGesture && inputSize > MAX_WORD_LENGTH - 1) return 0;
+
+    const jsize prevWordCodePointsLength =
+            prevWordCodePointsForBigrams ? env->GetArrayLength(prevWordCodePointsForBigrams) : 0;
+    int prevWordCodePointsInternal[prevWordCodePointsLength];
+    int *prevWordCodePoints = 0;
+    if (prevWordCodePointsForBigrams) {
+        env->GetIntArrayRegion(prevWordCodePointsForBigrams, 0, prevWordCodePointsLength,
+                prevWordCodePointsInternal);
+        prevWordCodePoints = prevWordCodePointsInternal;
+    }
+
+    const jsize outputCodePointsLength = env->GetArrayLength(outputCodePointsArray);
+    const jsize scoresLength = env->GetArrayLength(scoresArray);
+    if (outputCodePointsLength != (MAX_WORD_LENGTH * MAX_RESULTS)
+            || scoresLength != MAX_RESULTS) {
+        AKLOGE("Invalid output lengths: %d %d", outputCodePointsLength, scoresLength);
+        ASSERT(false);
+        return 0;
+    }
+    int outputCodePoints[outputCodePointsLength];
+    int scores[scoresLength];
+    const jsize spaceIndicesLength = env->GetArrayLength(spaceIndicesArray);
+    int spaceIndices[spaceIndicesLength];
+    const jsize outputTypesLength = env->GetArrayLength(outputTypesArray);
+    int outputTypes[outputTypesLength];
+    memset(outputCodePoints, 0, sizeof(outputCodePoints));
+    memset(scores, 0, sizeof(scores));
+    memset(spaceIndices, 0, sizeof(spaceIndices));
+    memset(outputTypes, 0, sizeof(outputTypes));
+
+    int count;
+    if (isGesture || inputSize > 0) {
+        count = dictionary->getSuggestions(pInfo, traverseSession, input->getXCoordinates(),
+                input->getYCoordinates(), input->getTimes(), input->getPointerIds(),
+                input->getCodePoints(), inputSize, prevWordCodePoints, prevWordCodePointsLength,
+                commitPoint, isGesture, useFullEditDistance, outputCodePoints, scores,
+                spaceIndices, outputTypes);
+    } else {
+        count = dictionary->getBigrams(prevWordCodePoints, prevWordCodePointsLength,
+                input->getCodePoints(), inputSize, outputCodePoints, scores, outputTypes);
+    }
+
+    env->SetIntArrayRegion(outputCodePointsArray, 0, outputCodePointsLength, outputCodePoints);
+    env->SetIntArrayRegion(scoresArray, 0, scoresLength, scores);
+    env->SetIntArrayRegion(spaceIndicesArray, 0, spaceIndicesLength, spaceIndices);
+    env->SetIntArrayRegion(outputTypesArray, 0, outputTypesLength, outputTypes);
+    return count;
+}
+
+// Gets the suggestions for several typed words in one call. The code points, the coordinates and
+// the previous words of the words are packed one after the other, and inputSizes and
+// prevWordSizes give their lengths. A previous word of length 0 means there is none. Missing
+// coordinates are passed as null arrays. The results of the i-th word are written at
+// i * MAX_RESULTS, and their count at outputCounts[i]. The same session is used for all the
+// words, so its caches stay warm from one word to the next.
+static jint latinime_BinaryDictionary_getSuggestionsBatch(JNIEnv *env, jclass clazz, jlong dict,
+        jlong proximityInfo, jlong dicTraverseSession, jintArray inputCodePointsArray,
+        jintArray inputSizesArray, jintArray xCoordinatesArray, jintArray yCoordinatesArray,
+        jintArray prevWordCodePointsArray, jintArray prevWordSizesArray,
+        jboolean useFullEditDistance, jintArray outputCodePointsArray, jintArray scoresArray,
+        jintArray outputTypesArray, jintArray outputCountsArray) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    if (!dictionary) return 0;
+    ProximityInfo *pInfo = reinterpret_cast<ProximityInfo *>(proximityInfo);
+    void *traverseSession = reinterpret_cast<void *>(dicTraverseSession);
+
+    const jsize itemCount = env->GetArrayLength(inputSizesArray);
+    if (env->GetArrayLength(prevWordSizesArray) != itemCount
+            || env->GetArrayLength(outputCountsArray) != itemCount
+            || env->GetArrayLength(outputCodePointsArray)
+                    != itemCount * MAX_WORD_LENGTH * MAX_RESULTS
+            || env->GetArrayLength(scoresArray) != itemCount * MAX_RESULTS
+            || env->GetArrayLength(outputTypesArray) != itemCount * MAX_RESULTS) {
+        AKLOGE("Invalid batch array lengths for %d items", itemCount);
+        ASSERT(false);
+        return 0;
+    }
+    int inputSizes[itemCount];
+    int prevWordSizes[itemCount];
+    int outputCounts[itemCount];
+    env->GetIntArrayRegion(inputSizesArray, 0, itemCount, inputSizes);
+    env->GetIntArrayRegion(prevWordSizesArray, 0, itemCount, prevWordSizes);
+
+    int times[MAX_WORD_LENGTH];
+    int pointerIds[MAX_WORD_LENGTH];
+    memset(times, 0, sizeof(times));
+    memset(pointerIds, 0, sizeof(pointerIds));
+    int inputStart = 0;
+    int prevWordStart = 0;
+    for (int i = 0; i < itemCount; ++i) {
+        outputCounts[i] = 0;
+    }
+    for (int i = 0; i < itemCount; ++i) {
+        const int inputSize = inputSizes[i];
+        const int prevWordSize = prevWordSizes[i];
+        if (inputSize < 0 || prevWordSize < 0) {
+            AKLOGE("Invalid batch item %d: inputSize=%d prevWordSize=%d", i, inputSize,
+                    prevWordSize);
+            ASSERT(false);
+            break;
+        }
+        if (inputSize > MAX_WORD_LENGTH - 1 || prevWordSize > MAX_WORD_LENGTH) {
+            // Too long to be a word: no suggestions, like for a single word.
+            inputStart += inputSize;
+            prevWordStart += prevWordSize;
+            continue;
+        }
+        int inputCodePoints[MAX_WORD_LENGTH];
+        int xCoordinates[MAX_WORD_LENGTH];
+        int yCoordinates[MAX_WORD_LENGTH];
+        int prevWordCodePoints[MAX_WORD_LENGTH];
+        for (int j = 0; j < MAX_WORD_LENGTH; ++j) {
+            inputCodePoints[j] = NOT_A_CODE_POINT;
+            xCoordinates[j] = NOT_A_COORDINATE;
+            yCoordinates[j] = NOT_A_COORDINATE;
+        }
+        env->GetIntArrayRegion(inputCodePointsArray, inputStart, inputSize, inputCodePoints);
+        if (xCoordinatesArray && yCoordinatesArray) {
+            env->GetIntArrayRegion(xCoordinatesArray, inputStart, inputSize, xCoordinates);
+            env->GetIntArrayRegion(yCoordinatesArray, inputStart, inputSize, yCoordinates);
+        }
+        env->GetIntArrayRegion(prevWordCodePointsArray, prevWordStart, prevWordSize,
+                prevWordCodePoints);
+        inputStart += inputSize;
+        prevWordStart += prevWordSize;
+
+        int outputCodePoints[MAX_WORD_LENGTH * MAX_RESULTS];
+        int scores[MAX_RESULTS];
+        int spaceIndices[MAX_RESULTS];
+        int outputTypes[MAX_RESULTS];
+        memset(outputCodePoints, 0, sizeof(outputCodePoints));
+        memset(scores, 0, sizeof(scores));
+        memset(spaceIndices, 0, sizeof(spaceIndices));
+        memset(outputTypes, 0, sizeof(outputTypes));
+        int *const prevWord = prevWordSize > 0 ? prevWordCodePoints : 0;
+        if (inputSize > 0) {
+            outputCounts[i] = dictionary->getSuggestions(pInfo, traverseSession, xCoordinates,
+                    yCoordinates, times, pointerIds, inputCodePoints, inputSize, prevWord,
+                    prevWordSize, 0 /* commitPoint */, false /* isGesture */,
+                    useFullEditDistance, outputCodePoints, scores, spaceIndices, outputTypes);
+        } else {
+            outputCounts[i] = dictionary->getBigrams(prevWord, prevWordSize, inputCodePoints,
+                    inputSize, outputCodePoints, scores, outputTypes);
+        }
+        env->SetIntArrayRegion(outputCodePointsArray, i * MAX_WORD_LENGTH * MAX_RESULTS,
+                MAX_WORD_LENGTH * MAX_RESULTS, outputCodePoints);
+        env->SetIntArrayRegion(scoresArray, i * MAX_RESULTS, MAX_RESULTS, scores);
+        env->SetIntArrayRegion(outputTypesArray, i * MAX_RESULTS, MAX_RESULTS, outputTypes);
+    }
+    env->SetIntArrayRegion(outputCountsArray, 0, itemCount, outputCounts);
+    return itemCount;
+}
+
 static jint latinime_BinaryDictionary_getProbability(JNIEnv *env, jclass clazz, jlong dict,
         jintArray wordArray) {
     Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
@@ -227,6 +464,88 @@ static jboolean latinime_BinaryDictionary_isValidBigram(JNIEnv *env, jclass claz
     return dictionary->isValidBigram(codePoints1, codePointLength1, codePoints2, codePointLength2);
 }
 
+// Gets the probabilities of several words in one call. The code points of the words are packed one
+// after the other, and wordSizes gives their lengths. The probability of the i-th word is written
+// at outputProbabilities[i].
+static void latinime_BinaryDictionary_getProbabilities(JNIEnv *env, jclass clazz, jlong dict,
+        jintArray codePointsArray, jintArray wordSizesArray, jintArray outputProbabilitiesArray) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    if (!dictionary) return;
+    const jsize itemCount = env->GetArrayLength(wordSizesArray);
+    if (env->GetArrayLength(outputProbabilitiesArray) != itemCount) {
+        AKLOGE("Invalid batch array lengths for %d items", itemCount);
+        ASSERT(false);
+        return;
+    }
+    int wordSizes[itemCount];
+    int probabilities[itemCount];
+    env->GetIntArrayRegion(wordSizesArray, 0, itemCount, wordSizes);
+    int wordStart = 0;
+    for (int i = 0; i < itemCount; ++i) {
+        const int wordSize = wordSizes[i];
+        probabilities[i] = NOT_A_PROBABILITY;
+        if (wordSize < 0) {
+            AKLOGE("Invalid batch item %d: wordSize=%d", i, wordSize);
+            ASSERT(false);
+            break;
+        }
+        // Words longer than MAX_WORD_LENGTH can't be in the dictionary.
+        if (wordSize <= MAX_WORD_LENGTH) {
+            int codePoints[MAX_WORD_LENGTH];
+            env->GetIntArrayRegion(codePointsArray, wordStart, wordSize, codePoints);
+            probabilities[i] = dictionary->getProbability(codePoints, wordSize);
+        }
+        wordStart += wordSize;
+    }
+    env->SetIntArrayRegion(outputProbabilitiesArray, 0, itemCount, probabilities);
+}
+
+// Checks several bigrams in one call. The first and the second words of the bigrams are packed
+// like the words of getProbabilities, and the result of the i-th bigram is written at
+// outputResults[i]. Bigrams with an empty word are not valid.
+static void latinime_BinaryDictionary_isValidBigrams(JNIEnv *env, jclass clazz, jlong dict,
+        jintArray codePointsArray1, jintArray wordSizesArray1, jintArray codePointsArray2,
+        jintArray wordSizesArray2, jbooleanArray outputResultsArray) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    if (!dictionary) return;
+    const jsize itemCount = env->GetArrayLength(wordSizesArray1);
+    if (env->GetArrayLength(wordSizesArray2) != itemCount
+            || env->GetArrayLength(outputResultsArray) != itemCount) {
+        AKLOGE("Invalid batch array lengths for %d items", itemCount);
+        ASSERT(false);
+        return;
+    }
+    int wordSizes1[itemCount];
+    int wordSizes2[itemCount];
+    jboolean results[itemCount];
+    env->GetIntArrayRegion(wordSizesArray1, 0, itemCount, wordSizes1);
+    env->GetIntArrayRegion(wordSizesArray2, 0, itemCount, wordSizes2);
+    int wordStart1 = 0;
+    int wordStart2 = 0;
+    for (int i = 0; i < itemCount; ++i) {
+        const int wordSize1 = wordSizes1[i];
+        const int wordSize2 = wordSizes2[i];
+        results[i] = JNI_FALSE;
+        if (wordSize1 < 0 || wordSize2 < 0) {
+            AKLOGE("Invalid batch item %d: wordSize1=%d wordSize2=%d", i, wordSize1, wordSize2);
+            ASSERT(false);
+            break;
+        }
+        if (wordSize1 > 0 && wordSize1 <= MAX_WORD_LENGTH
+                && wordSize2 > 0 && wordSize2 <= MAX_WORD_LENGTH) {
+            int codePoints1[MAX_WORD_LENGTH];
+            int codePoints2[MAX_WORD_LENGTH];
+            env->GetIntArrayRegion(codePointsArray1, wordStart1, wordSize1, codePoints1);
+            env->GetIntArrayRegion(codePointsArray2, wordStart2, wordSize2, codePoints2);
+            results[i] = dictionary->isValidBigram(codePoints1, wordSize1, codePoints2,
+                    wordSize2) ? JNI_TRUE : JNI_FALSE;
+        }
+        wordStart1 += wordSize1;
+        wordStart2 += wordSize2;
+    }
+    env->SetBooleanArrayRegion(outputResultsArray, 0, itemCount, results);
+}
+
 static jfloat latinime_BinaryDictionary_calcNormalizedScore(JNIEnv *env, jclass clazz,
         jintArray before, jintArray after, jint score) {
     jsize beforeLength = env->GetArrayLength(before);
@@ -282,7 +601,7 @@ static void releaseDictBuf(const void *dictBuf, const size_t length, const int f
 
 static JNINativeMethod sMethods[] = {
     {const_cast<char *>("openNative"),
-     const_cast<char *>("(Ljava/lang/String;JJ)J"),
+     const_cast<char *>("(Ljava/lang/String;JJZ)J"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_open)},
     {const_cast<char *>("closeNative"),
      const_cast<char *>("(J)V"),
@@ -290,12 +609,27 @@ static JNINativeMethod sMethods[] = {
     {const_cast<char *>("getSuggestionsNative"),
      const_cast<char *>("(JJJ[I[I[I[I[IIIZ[IZ[I[I[I[I)I"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestions)},
+    {const_cast<char *>("getSuggestionsInSharedBufferNative"),
+     const_cast<char *>("(JJJLjava/nio/ByteBuffer;IZZ)I"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestionsInSharedBuffer)},
+    {const_cast<char *>("getSuggestionsForSessionInputNative"),
+     const_cast<char *>("(JJJIZ[IZ[I[I[I[I)I"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestionsForSessionInput)},
+    {const_cast<char *>("getSuggestionsBatchNative"),
+     const_cast<char *>("(JJJ[I[I[I[I[I[IZ[I[I[I[I)I"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestionsBatch)},
     {const_cast<char *>("getProbabilityNative"),
      const_cast<char *>("(J[I)I"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_getProbability)},
     {const_cast<char *>("isValidBigramNative"),
      const_cast<char *>("(J[I[I)Z"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_isValidBigram)},
+    {const_cast<char *>("getProbabilitiesNative"),
+     const_cast<char *>("(J[I[I[I)V"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_getProbabilities)},
+    {const_cast<char *>("isValidBigramsNative"),
+     const_cast<char *>("(J[I[I[I[I[Z)V"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_isValidBigrams)},
     {const_cast<char *>("calcNormalizedScoreNative"),
      const_cast<char *>("([I[II)F"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_calcNormalizedScore)},
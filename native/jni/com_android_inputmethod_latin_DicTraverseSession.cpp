@@ -21,6 +21,7 @@
 #include "dic_traverse_wrapper.h"
 #include "jni.h"
 #include "jni_common.h"
+#include "suggest/core/session/streamed_input.h"
 
 namespace latinime {
 class Dictionary;
@@ -47,6 +48,67 @@ static void latinime_releaseDicTraverseSession(JNIEnv *env, jclass clazz, jlong
     DicTraverseWrapper::releaseDicTraverseSession(ts);
 }
 
+static void latinime_setSearchBudget(JNIEnv *env, jclass clazz, jlong traverseSession,
+        jint timeBudgetMicros, jint maxExpandedDicNodeCount) {
+    void *ts = reinterpret_cast<void *>(traverseSession);
+    DicTraverseWrapper::setSearchBudget(ts, timeBudgetMicros, maxExpandedDicNodeCount);
+}
+
+static jboolean latinime_isLastSearchPartial(JNIEnv *env, jclass clazz, jlong traverseSession) {
+    const void *ts = reinterpret_cast<void *>(traverseSession);
+    return DicTraverseWrapper::isLastSearchPartial(ts);
+}
+
+// Sets the hit count and the miss count of the bigram maps of the session in outputCounts.
+static void latinime_getBigramMapCounts(JNIEnv *env, jclass clazz, jlong traverseSession,
+        jintArray outputCounts) {
+    const void *ts = reinterpret_cast<void *>(traverseSession);
+    int counts[2];
+    DicTraverseWrapper::getBigramMapCounts(ts, &counts[0], &counts[1]);
+    env->SetIntArrayRegion(outputCounts, 0, 2, counts);
+}
+
+// Appends count touch points to the input of the session as one input. codePoints may be null.
+static void latinime_appendTouchPoints(JNIEnv *env, jclass clazz, jlong traverseSession,
+        jintArray codePointsArray, jintArray xCoordinatesArray, jintArray yCoordinatesArray,
+        jintArray timesArray, jintArray pointerIdsArray, jint count) {
+    void *ts = reinterpret_cast<void *>(traverseSession);
+    StreamedInput *const streamedInput = DicTraverseWrapper::getStreamedInput(ts);
+    if (!streamedInput || count <= 0) {
+        return;
+    }
+    int codePoints[count];
+    int xCoordinates[count];
+    int yCoordinates[count];
+    int times[count];
+    int pointerIds[count];
+    if (codePointsArray) {
+        env->GetIntArrayRegion(codePointsArray, 0, count, codePoints);
+    }
+    env->GetIntArrayRegion(xCoordinatesArray, 0, count, xCoordinates);
+    env->GetIntArrayRegion(yCoordinatesArray, 0, count, yCoordinates);
+    env->GetIntArrayRegion(timesArray, 0, count, times);
+    env->GetIntArrayRegion(pointerIdsArray, 0, count, pointerIds);
+    streamedInput->appendTouchPoints(codePointsArray ? codePoints : 0, xCoordinates,
+            yCoordinates, times, pointerIds, count);
+}
+
+static void latinime_removeLastInput(JNIEnv *env, jclass clazz, jlong traverseSession) {
+    void *ts = reinterpret_cast<void *>(traverseSession);
+    StreamedInput *const streamedInput = DicTraverseWrapper::getStreamedInput(ts);
+    if (streamedInput) {
+        streamedInput->removeLastInput();
+    }
+}
+
+static void latinime_resetInput(JNIEnv *env, jclass clazz, jlong traverseSession) {
+    void *ts = reinterpret_cast<void *>(traverseSession);
+    StreamedInput *const streamedInput = DicTraverseWrapper::getStreamedInput(ts);
+    if (streamedInput) {
+        streamedInput->resetInput();
+    }
+}
+
 static JNINativeMethod sMethods[] = {
     {const_cast<char *>("setDicTraverseSessionNative"),
      const_cast<char *>("(Ljava/lang/String;)J"),
@@ -56,7 +118,25 @@ static JNINativeMethod sMethods[] = {
      reinterpret_cast<void *>(latinime_initDicTraverseSession)},
     {const_cast<char *>("releaseDicTraverseSessionNative"),
      const_cast<char *>("(J)V"),
-     reinterpret_cast<void *>(latinime_releaseDicTraverseSession)}
+     reinterpret_cast<void *>(latinime_releaseDicTraverseSession)},
+    {const_cast<char *>("setSearchBudgetNative"),
+     const_cast<char *>("(JII)V"),
+     reinterpret_cast<void *>(latinime_setSearchBudget)},
+    {const_cast<char *>("isLastSearchPartialNative"),
+     const_cast<char *>("(J)Z"),
+     reinterpret_cast<void *>(latinime_isLastSearchPartial)},
+    {const_cast<char *>("getBigramMapCountsNative"),
+     const_cast<char *>("(J[I)V"),
+     reinterpret_cast<void *>(latinime_getBigramMapCounts)},
+    {const_cast<char *>("appendTouchPointsNative"),
+     const_cast<char *>("(J[I[I[I[I[II)V"),
+     reinterpret_cast<void *>(latinime_appendTouchPoints)},
+    {const_cast<char *>("removeLastInputNative"),
+     const_cast<char *>("(J)V"),
+     reinterpret_cast<void *>(latinime_removeLastInput)},
+    {const_cast<char *>("resetInputNative"),
+     const_cast<char *>("(J)V"),
+     reinterpret_cast<void *>(latinime_resetInput)}
 };
 
 int register_DicTraverseSession(JNIEnv *env) {
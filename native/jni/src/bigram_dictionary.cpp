@@ -19,15 +19,20 @@
 #define LOG_TAG "LatinIME: bigram_dictionary.cpp"
 
 #include "bigram_dictionary.h"
+#include "bigram_index.h"
 #include "binary_format.h"
 #include "bloom_filter.h"
 #include "char_utils.h"
 #include "defines.h"
 #include "dictionary.h"
+#include "word_position_index.h"
 
 namespace latinime {
 
-BigramDictionary::BigramDictionary(const uint8_t *const streamStart) : DICT_ROOT(streamStart) {
+BigramDictionary::BigramDictionary(const uint8_t *const streamStart,
+        const BigramIndex *const bigramIndex, const WordPositionIndex *const wordPositionIndex)
+        : DICT_ROOT(streamStart), mBigramIndex(bigramIndex),
+          mWordPositionIndex(wordPositionIndex) {
     if (DEBUG_DICT) {
         AKLOGI("BigramDictionary - constructor");
     }
@@ -67,6 +72,9 @@ void BigramDictionary::addWordBigram(int *word, int length, int probability, int
             bigramProbability + insertAt,
             (MAX_RESULTS - insertAt - 1) * sizeof(bigramProbability[0]));
     bigramProbability[insertAt] = probability;
+    memmove(outputTypes + (insertAt + 1),
+            outputTypes + insertAt,
+            (MAX_RESULTS - insertAt - 1) * sizeof(outputTypes[0]));
     outputTypes[insertAt] = Dictionary::KIND_PREDICTION;
     memmove(bigramCodePoints + (insertAt + 1) * MAX_WORD_LENGTH,
             bigramCodePoints + insertAt * MAX_WORD_LENGTH,
@@ -102,6 +110,10 @@ int BigramDictionary::getBigrams(const int *prevWord, int prevWordLength, int *i
     // TODO: remove unused arguments, and refrain from storing stuff in members of this class
     // TODO: have "in" arguments before "out" ones, and make out args explicit in the name
 
+    if (mBigramIndex) {
+        return getBigramsFromIndex(prevWord, prevWordLength, inputCodePoints, inputSize,
+                bigramCodePoints, bigramProbability, outputTypes);
+    }
     const uint8_t *const root = DICT_ROOT;
     int pos = getBigramListPositionForWord(prevWord, prevWordLength,
             false /* forceLowerCaseSearch */);
@@ -143,14 +155,46 @@ int BigramDictionary::getBigrams(const int *prevWord, int prevWordLength, int *i
     return min(bigramCount, MAX_RESULTS);
 }
 
+// Same as getBigrams(), but only decodes the best MAX_RESULTS bigrams among the ones whose first
+// letter matches, which the bigram index keeps bucketed by first letter and sorted.
+int BigramDictionary::getBigramsFromIndex(const int *prevWord, const int prevWordLength,
+        const int *inputCodePoints, const int inputSize, int *bigramCodePoints,
+        int *bigramProbability, int *outputTypes) const {
+    if (0 >= prevWordLength) return 0;
+    const int *nextWordPositions = 0;
+    const uint8_t *probabilities = 0;
+    int pos = getTerminalPosition(prevWord, prevWordLength, false /* forceLowerCaseSearch */);
+    if (NOT_VALID_WORD == pos
+            || 0 == mBigramIndex->getBigrams(pos, &nextWordPositions, &probabilities)) {
+        // If no bigrams for this exact word, search again in lower case.
+        pos = getTerminalPosition(prevWord, prevWordLength, true /* forceLowerCaseSearch */);
+    }
+    if (NOT_VALID_WORD == pos) return 0;
+    int targetPositions[MAX_RESULTS];
+    int probabilitiesOfTargets[MAX_RESULTS];
+    // inputSize == 0 means we are trying to find bigram predictions.
+    const int bigramCount = mBigramIndex->getPredictions(pos, inputCodePoints,
+            inputSize < 1 ? 0 : MAX_ALTERNATIVES, MAX_RESULTS, targetPositions,
+            probabilitiesOfTargets);
+    const int outputCount = min(bigramCount, MAX_RESULTS);
+    for (int i = 0; i < outputCount; ++i) {
+        int bigramBuffer[MAX_WORD_LENGTH];
+        int unigramProbability = 0;
+        const int length = mBigramIndex->getTargetWordAtPosition(targetPositions[i],
+                MAX_WORD_LENGTH, bigramBuffer, &unigramProbability);
+        addWordBigram(bigramBuffer, length, probabilitiesOfTargets[i], bigramProbability,
+                bigramCodePoints, outputTypes);
+    }
+    return outputCount;
+}
+
 // Returns a pointer to the start of the bigram list.
 // If the word is not found or has no bigrams, this function returns 0.
 int BigramDictionary::getBigramListPositionForWord(const int *prevWord, const int prevWordLength,
         const bool forceLowerCaseSearch) const {
     if (0 >= prevWordLength) return 0;
     const uint8_t *const root = DICT_ROOT;
-    int pos = BinaryFormat::getTerminalPosition(root, prevWord, prevWordLength,
-            forceLowerCaseSearch);
+    int pos = getTerminalPosition(prevWord, prevWordLength, forceLowerCaseSearch);
 
     if (NOT_VALID_WORD == pos) return 0;
     const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
@@ -190,6 +234,14 @@ void BigramDictionary::fillBigramAddressToProbabilityMapAndFilter(const int *pre
     } while (BinaryFormat::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
 }
 
+int BigramDictionary::getTerminalPosition(const int *word, const int length,
+        const bool forceLowerCaseSearch) const {
+    if (mWordPositionIndex) {
+        return mWordPositionIndex->getTerminalPosition(word, length, forceLowerCaseSearch);
+    }
+    return BinaryFormat::getTerminalPosition(DICT_ROOT, word, length, forceLowerCaseSearch);
+}
+
 bool BigramDictionary::checkFirstCharacter(int *word, int *inputCodePoints) const {
     // Checks whether this word starts with same character or neighboring characters of
     // what user typed.
@@ -209,11 +261,19 @@ bool BigramDictionary::checkFirstCharacter(int *word, int *inputCodePoints) cons
 bool BigramDictionary::isValidBigram(const int *word1, int length1, const int *word2,
         int length2) const {
     const uint8_t *const root = DICT_ROOT;
+    if (mBigramIndex) {
+        if (0 >= length1) return false;
+        const int prevWordPos = getTerminalPosition(word1, length1,
+                false /* forceLowerCaseSearch */);
+        if (NOT_VALID_WORD == prevWordPos) return false;
+        const int nextWordPos = getTerminalPosition(word2, length2,
+                false /* forceLowerCaseSearch */);
+        return mBigramIndex->isValidBigram(prevWordPos, nextWordPos);
+    }
     int pos = getBigramListPositionForWord(word1, length1, false /* forceLowerCaseSearch */);
     // getBigramListPositionForWord returns 0 if this word isn't in the dictionary or has no bigrams
     if (0 == pos) return false;
-    int nextWordPos = BinaryFormat::getTerminalPosition(root, word2, length2,
-            false /* forceLowerCaseSearch */);
+    int nextWordPos = getTerminalPosition(word2, length2, false /* forceLowerCaseSearch */);
     if (NOT_VALID_WORD == nextWordPos) return false;
     uint8_t bigramFlags;
     do {
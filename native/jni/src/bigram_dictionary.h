@@ -24,9 +24,13 @@
 
 namespace latinime {
 
+class BigramIndex;
+class WordPositionIndex;
+
 class BigramDictionary {
  public:
-    BigramDictionary(const uint8_t *const streamStart);
+    BigramDictionary(const uint8_t *const streamStart, const BigramIndex *const bigramIndex,
+            const WordPositionIndex *const wordPositionIndex);
     int getBigrams(const int *word, int length, int *inputCodePoints, int inputSize, int *outWords,
             int *frequencies, int *outputTypes) const;
     void fillBigramAddressToProbabilityMapAndFilter(const int *prevWord, const int prevWordLength,
@@ -37,11 +41,20 @@ class BigramDictionary {
     DISALLOW_IMPLICIT_CONSTRUCTORS(BigramDictionary);
     void addWordBigram(int *word, int length, int probability, int *bigramProbability,
             int *bigramCodePoints, int *outputTypes) const;
+    int getBigramsFromIndex(const int *prevWord, const int prevWordLength,
+            const int *inputCodePoints, const int inputSize, int *bigramCodePoints,
+            int *bigramProbability, int *outputTypes) const;
     bool checkFirstCharacter(int *word, int *inputCodePoints) const;
     int getBigramListPositionForWord(const int *prevWord, const int prevWordLength,
             const bool forceLowerCaseSearch) const;
+    int getTerminalPosition(const int *word, const int length,
+            const bool forceLowerCaseSearch) const;
 
     const uint8_t *const DICT_ROOT;
+    // Decoded bigram lists, or 0 if the bigram lists have to be read from the dictionary
+    const BigramIndex *const mBigramIndex;
+    // Positions of the words, or 0 if the words have to be looked up in the dictionary
+    const WordPositionIndex *const mWordPositionIndex;
     // TODO: Re-implement proximity correction for bigram correction
     static const int MAX_ALTERNATIVES = 1;
 };
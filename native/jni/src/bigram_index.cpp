@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: bigram_index.cpp"
+
+#include "bigram_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "binary_format.h"
+#include "char_utils.h"
+#include "defines.h"
+
+namespace latinime {
+
+namespace {
+// Bigram list of a word, as a range of the bigrams read by the constructor.
+struct BigramList {
+    int mWordPosition;
+    int mStart;
+    int mEnd;
+
+    bool operator<(const BigramList &bigramList) const {
+        return mWordPosition < bigramList.mWordPosition;
+    }
+};
+
+// Orders the bigrams of a word by next word position only, for a stable sort to keep the first
+// bigram of a next word first.
+struct NextWordPositionLess {
+    bool operator()(const std::pair<int, int> &left, const std::pair<int, int> &right) const {
+        return left.first < right.first;
+    }
+};
+
+// Bigram of a word as a prediction. Predictions sort by first code point, then from the best to
+// the worst, that is by decreasing probability, then by increasing length and then in the order
+// of the dictionary, like BigramDictionary::addWordBigram() ranks them.
+struct Prediction {
+    int mFirstCodePoint;
+    int mProbability;
+    int mLength;
+    int mOrder;
+    int mTargetIndex;
+
+    bool operator<(const Prediction &prediction) const {
+        if (mFirstCodePoint != prediction.mFirstCodePoint) {
+            return mFirstCodePoint < prediction.mFirstCodePoint;
+        }
+        return isBetterThan(prediction);
+    }
+
+    bool isBetterThan(const Prediction &prediction) const {
+        if (mProbability != prediction.mProbability) {
+            return mProbability > prediction.mProbability;
+        }
+        if (mLength != prediction.mLength) {
+            return mLength < prediction.mLength;
+        }
+        return mOrder < prediction.mOrder;
+    }
+};
+
+// Orders the predictions from the best to the worst, which puts the worst at the top of a heap.
+struct PredictionBetter {
+    bool operator()(const Prediction &left, const Prediction &right) const {
+        return left.isBetterThan(right);
+    }
+};
+} // namespace
+
+BigramIndex::BigramIndex(const uint8_t *const dicRoot)
+        : mWordPositions(), mBigramStarts(), mNextWordPositions(), mProbabilities(),
+          mTargetPositions(), mTargetStarts(), mTargetLengths(), mTargetProbabilities(),
+          mTargetCodePoints(), mWordBucketStarts(), mBucketFirstCodePoints(), mBucketStarts(),
+          mPredictionTargets(), mPredictionOrders(), mPredictionProbabilities() {
+    // Next word positions and probabilities of the bigrams, in the order of the dictionary.
+    std::vector<std::pair<int, int> > bigrams;
+    std::vector<BigramList> bigramLists;
+    std::vector<int> nodePositions;
+    nodePositions.push_back(0);
+    while (!nodePositions.empty()) {
+        int pos = nodePositions.back();
+        nodePositions.pop_back();
+        const int groupCount = BinaryFormat::getGroupCountAndForwardPointer(dicRoot, &pos);
+        for (int i = 0; i < groupCount; ++i) {
+            const int groupPos = pos;
+            const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(dicRoot, &pos);
+            if (flags & BinaryFormat::FLAG_HAS_MULTIPLE_CHARS) {
+                pos = BinaryFormat::skipOtherCharacters(dicRoot, pos);
+            } else {
+                BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos);
+            }
+            pos = BinaryFormat::skipProbability(flags, pos);
+            if (BinaryFormat::hasChildrenInFlags(flags)) {
+                nodePositions.push_back(BinaryFormat::readChildrenPosition(dicRoot, flags, pos));
+            }
+            pos = BinaryFormat::skipChildrenPosition(flags, pos);
+            pos = BinaryFormat::skipShortcuts(dicRoot, flags, pos);
+            if (!(flags & BinaryFormat::FLAG_HAS_BIGRAMS)) {
+                continue;
+            }
+            BigramList bigramList;
+            bigramList.mWordPosition = groupPos;
+            bigramList.mStart = static_cast<int>(bigrams.size());
+            uint8_t bigramFlags;
+            do {
+                bigramFlags = BinaryFormat::getFlagsAndForwardPointer(dicRoot, &pos);
+                const int bigramPos = BinaryFormat::getAttributeAddressAndForwardPointer(dicRoot,
+                        bigramFlags, &pos);
+                bigrams.push_back(std::pair<int, int>(bigramPos,
+                        BinaryFormat::MASK_ATTRIBUTE_PROBABILITY & bigramFlags));
+            } while (BinaryFormat::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
+            bigramList.mEnd = static_cast<int>(bigrams.size());
+            bigramLists.push_back(bigramList);
+        }
+    }
+
+    if (!bigrams.empty()) {
+        mTargetPositions.reserve(bigrams.size());
+        for (size_t i = 0; i < bigrams.size(); ++i) {
+            mTargetPositions.push_back(bigrams[i].first);
+        }
+        std::sort(mTargetPositions.begin(), mTargetPositions.end());
+        mTargetPositions.erase(
+                std::unique(mTargetPositions.begin(), mTargetPositions.end()),
+                mTargetPositions.end());
+        mTargetStarts.resize(mTargetPositions.size());
+        mTargetLengths.resize(mTargetPositions.size());
+        mTargetProbabilities.resize(mTargetPositions.size());
+        int word[MAX_WORD_LENGTH];
+        readTargetWords(dicRoot, 0 /* pos */, word, 0 /* depth */);
+    }
+
+    std::sort(bigramLists.begin(), bigramLists.end());
+    mWordPositions.reserve(bigramLists.size());
+    mBigramStarts.reserve(bigramLists.size() + 1);
+    mNextWordPositions.reserve(bigrams.size());
+    mProbabilities.reserve(bigrams.size());
+    mWordBucketStarts.reserve(bigramLists.size() + 1);
+    mPredictionTargets.reserve(bigrams.size());
+    mPredictionOrders.reserve(bigrams.size());
+    mPredictionProbabilities.reserve(bigrams.size());
+    std::vector<Prediction> predictions;
+    for (size_t i = 0; i < bigramLists.size(); ++i) {
+        const std::vector<std::pair<int, int> >::iterator begin =
+                bigrams.begin() + bigramLists[i].mStart;
+        const std::vector<std::pair<int, int> >::iterator end =
+                bigrams.begin() + bigramLists[i].mEnd;
+
+        // The predictions are read before the bigrams are sorted, to rank ties in the order of
+        // the dictionary.
+        predictions.clear();
+        for (std::vector<std::pair<int, int> >::iterator it = begin; it != end; ++it) {
+            const int targetIndex = static_cast<int>(std::lower_bound(mTargetPositions.begin(),
+                    mTargetPositions.end(), it->first) - mTargetPositions.begin());
+            // A target that is not a word of the trie can't be predicted.
+            if (0 == mTargetLengths[targetIndex]) continue;
+            Prediction prediction;
+            prediction.mFirstCodePoint =
+                    toBaseLowerCase(mTargetCodePoints[mTargetStarts[targetIndex]]);
+            prediction.mProbability = BinaryFormat::computeProbabilityForBigram(
+                    mTargetProbabilities[targetIndex], it->second);
+            prediction.mLength = mTargetLengths[targetIndex];
+            prediction.mOrder = static_cast<int>(it - begin);
+            prediction.mTargetIndex = targetIndex;
+            predictions.push_back(prediction);
+        }
+        std::sort(predictions.begin(), predictions.end());
+        mWordBucketStarts.push_back(static_cast<int>(mBucketFirstCodePoints.size()));
+        for (size_t j = 0; j < predictions.size(); ++j) {
+            if (0 == j || predictions[j - 1].mFirstCodePoint != predictions[j].mFirstCodePoint) {
+                mBucketFirstCodePoints.push_back(predictions[j].mFirstCodePoint);
+                mBucketStarts.push_back(static_cast<int>(mPredictionTargets.size()));
+            }
+            mPredictionTargets.push_back(predictions[j].mTargetIndex);
+            mPredictionOrders.push_back(predictions[j].mOrder);
+            mPredictionProbabilities.push_back(static_cast<uint8_t>(predictions[j].mProbability));
+        }
+
+        std::stable_sort(begin, end, NextWordPositionLess());
+        mWordPositions.push_back(bigramLists[i].mWordPosition);
+        mBigramStarts.push_back(static_cast<int>(mNextWordPositions.size()));
+        for (std::vector<std::pair<int, int> >::iterator it = begin; it != end; ++it) {
+            // A linear walk of the bigram list finds the first bigram of a next word.
+            if (it != begin && (it - 1)->first == it->first) {
+                continue;
+            }
+            mNextWordPositions.push_back(it->first);
+            mProbabilities.push_back(static_cast<uint8_t>(it->second));
+        }
+    }
+    mBigramStarts.push_back(static_cast<int>(mNextWordPositions.size()));
+    mWordBucketStarts.push_back(static_cast<int>(mBucketFirstCodePoints.size()));
+    mBucketStarts.push_back(static_cast<int>(mPredictionTargets.size()));
+    if (DEBUG_DICT) {
+        AKLOGI("BigramIndex: %d words, %d bigrams, %d targets", getWordCount(),
+                getBigramCount(), static_cast<int>(mTargetPositions.size()));
+    }
+}
+
+void BigramIndex::readTargetWords(const uint8_t *const dicRoot, int pos, int *const word,
+        const int depth) {
+    const int groupCount = BinaryFormat::getGroupCountAndForwardPointer(dicRoot, &pos);
+    for (int i = 0; i < groupCount; ++i) {
+        const int groupPos = pos;
+        const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(dicRoot, &pos);
+        int length = depth;
+        int codePoint = BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos);
+        if (length < MAX_WORD_LENGTH) {
+            word[length++] = codePoint;
+        }
+        if (flags & BinaryFormat::FLAG_HAS_MULTIPLE_CHARS) {
+            codePoint = BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos);
+            while (NOT_A_CODE_POINT != codePoint) {
+                if (length < MAX_WORD_LENGTH) {
+                    word[length++] = codePoint;
+                }
+                codePoint = BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos);
+            }
+        }
+        const std::vector<int>::iterator it = std::lower_bound(mTargetPositions.begin(),
+                mTargetPositions.end(), groupPos);
+        if (it != mTargetPositions.end() && *it == groupPos) {
+            const int targetIndex = static_cast<int>(it - mTargetPositions.begin());
+            mTargetStarts[targetIndex] = static_cast<int>(mTargetCodePoints.size());
+            mTargetLengths[targetIndex] = static_cast<uint8_t>(length);
+            mTargetProbabilities[targetIndex] = static_cast<uint8_t>(
+                    BinaryFormat::readProbabilityWithoutMovingPointer(dicRoot, pos));
+            mTargetCodePoints.insert(mTargetCodePoints.end(), word, word + length);
+        }
+        pos = BinaryFormat::skipProbability(flags, pos);
+        if (BinaryFormat::hasChildrenInFlags(flags)) {
+            readTargetWords(dicRoot, BinaryFormat::readChildrenPosition(dicRoot, flags, pos), word,
+                    length);
+        }
+        pos = BinaryFormat::skipChildrenPosAndAttributes(dicRoot, flags, pos);
+    }
+}
+
+int BigramIndex::getBigramProbability(const int wordPosition, const int nextWordPosition,
+        const int unigramProbability) const {
+    const int bigramIndex = findBigram(wordPosition, nextWordPosition);
+    if (NOT_AN_INDEX == bigramIndex) {
+        return backoff(unigramProbability);
+    }
+    return BinaryFormat::computeProbabilityForBigram(unigramProbability,
+            mProbabilities[bigramIndex]);
+}
+
+bool BigramIndex::isValidBigram(const int wordPosition, const int nextWordPosition) const {
+    return NOT_AN_INDEX != findBigram(wordPosition, nextWordPosition);
+}
+
+int BigramIndex::getBigrams(const int wordPosition, const int **const outNextWordPositions,
+        const uint8_t **const outProbabilities) const {
+    const std::vector<int>::const_iterator it =
+            std::lower_bound(mWordPositions.begin(), mWordPositions.end(), wordPosition);
+    if (it == mWordPositions.end() || *it != wordPosition) {
+        return 0;
+    }
+    const int wordIndex = static_cast<int>(it - mWordPositions.begin());
+    const int start = mBigramStarts[wordIndex];
+    *outNextWordPositions = &mNextWordPositions[start];
+    *outProbabilities = &mProbabilities[start];
+    return mBigramStarts[wordIndex + 1] - start;
+}
+
+int BigramIndex::getTargetWordAtPosition(const int position, const int maxLength,
+        int *const outWord, int *const outUnigramProbability) const {
+    const std::vector<int>::const_iterator it = std::lower_bound(mTargetPositions.begin(),
+            mTargetPositions.end(), position);
+    if (it == mTargetPositions.end() || *it != position) {
+        return 0;
+    }
+    const int targetIndex = static_cast<int>(it - mTargetPositions.begin());
+    const int length = min(static_cast<int>(mTargetLengths[targetIndex]), maxLength);
+    memcpy(outWord, &mTargetCodePoints[mTargetStarts[targetIndex]],
+            length * sizeof(outWord[0]));
+    *outUnigramProbability = mTargetProbabilities[targetIndex];
+    return length;
+}
+
+int BigramIndex::getPredictions(const int wordPosition, const int *const firstCodePoints,
+        const int firstCodePointCount, const int maxPredictionCount,
+        int *const outTargetPositions, int *const outProbabilities) const {
+    const std::vector<int>::const_iterator it =
+            std::lower_bound(mWordPositions.begin(), mWordPositions.end(), wordPosition);
+    if (it == mWordPositions.end() || *it != wordPosition) {
+        return 0;
+    }
+    const int wordIndex = static_cast<int>(it - mWordPositions.begin());
+    if (mWordBucketStarts[wordIndex] == mWordBucketStarts[wordIndex + 1]) {
+        return 0;
+    }
+    const int *const bucketFirstCodePointsBegin =
+            &mBucketFirstCodePoints[0] + mWordBucketStarts[wordIndex];
+    const int *const bucketFirstCodePointsEnd =
+            &mBucketFirstCodePoints[0] + mWordBucketStarts[wordIndex + 1];
+    const int letterCount = firstCodePointCount > 0
+            ? firstCodePointCount : static_cast<int>(bucketFirstCodePointsEnd
+                    - bucketFirstCodePointsBegin);
+
+    // The best predictions so far, in a heap with the worst one at the top.
+    Prediction heap[MAX_RESULTS];
+    const int heapCapacity = min(maxPredictionCount, MAX_RESULTS);
+    int heapSize = 0;
+    int predictionCount = 0;
+    for (int i = 0; i < letterCount; ++i) {
+        int bucketIndex;
+        if (firstCodePointCount > 0) {
+            const int firstCodePoint = toBaseLowerCase(firstCodePoints[i]);
+            bool isDuplicate = false;
+            for (int j = 0; j < i; ++j) {
+                if (toBaseLowerCase(firstCodePoints[j]) == firstCodePoint) {
+                    isDuplicate = true;
+                    break;
+                }
+            }
+            if (isDuplicate) continue;
+            const int *const bucket = std::lower_bound(bucketFirstCodePointsBegin,
+                    bucketFirstCodePointsEnd, firstCodePoint);
+            if (bucket == bucketFirstCodePointsEnd || *bucket != firstCodePoint) continue;
+            bucketIndex = static_cast<int>(bucket - &mBucketFirstCodePoints[0]);
+        } else {
+            bucketIndex = mWordBucketStarts[wordIndex] + i;
+        }
+        const int bucketStart = mBucketStarts[bucketIndex];
+        const int bucketEnd = mBucketStarts[bucketIndex + 1];
+        predictionCount += bucketEnd - bucketStart;
+        // Buckets are sorted from the best prediction, so the first one that doesn't make it to
+        // the heap ends the bucket.
+        for (int j = bucketStart; j < bucketEnd; ++j) {
+            Prediction prediction;
+            prediction.mFirstCodePoint = mBucketFirstCodePoints[bucketIndex];
+            prediction.mProbability = mPredictionProbabilities[j];
+            prediction.mTargetIndex = mPredictionTargets[j];
+            prediction.mLength = mTargetLengths[prediction.mTargetIndex];
+            prediction.mOrder = mPredictionOrders[j];
+            if (heapSize < heapCapacity) {
+                heap[heapSize++] = prediction;
+                std::push_heap(heap, heap + heapSize, PredictionBetter());
+            } else if (heapSize > 0 && prediction.isBetterThan(heap[0])) {
+                std::pop_heap(heap, heap + heapSize, PredictionBetter());
+                heap[heapSize - 1] = prediction;
+                std::push_heap(heap, heap + heapSize, PredictionBetter());
+            } else {
+                break;
+            }
+        }
+    }
+    std::sort_heap(heap, heap + heapSize, PredictionBetter());
+    for (int i = 0; i < heapSize; ++i) {
+        outTargetPositions[i] = mTargetPositions[heap[i].mTargetIndex];
+        outProbabilities[i] = heap[i].mProbability;
+    }
+    return predictionCount;
+}
+
+int BigramIndex::findBigram(const int wordPosition, const int nextWordPosition) const {
+    const int *nextWordPositions = 0;
+    const uint8_t *probabilities = 0;
+    const int bigramCount = getBigrams(wordPosition, &nextWordPositions, &probabilities);
+    if (0 == bigramCount) {
+        return NOT_AN_INDEX;
+    }
+    const int *const it = std::lower_bound(nextWordPositions, nextWordPositions + bigramCount,
+            nextWordPosition);
+    if (it == nextWordPositions + bigramCount || *it != nextWordPosition) {
+        return NOT_AN_INDEX;
+    }
+    return static_cast<int>(it - &mNextWordPositions[0]);
+}
+} // namespace latinime
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_BIGRAM_INDEX_H
+#define LATINIME_BIGRAM_INDEX_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Decoded bigram lists of a dictionary, built once when the dictionary is opened so that bigram
+ * lookups don't have to walk and decode the variable length bigram lists of the dictionary. The
+ * words with bigrams and the bigrams of each word are sorted by position, and looked up by
+ * binary search. The code points of the bigram targets (the next words of the bigrams) are also
+ * kept, so that they don't have to be rebuilt by walking the trie from the root, and the bigrams
+ * are kept a second time as predictions bucketed by first letter. The index is read-only once
+ * built, so it can be shared by all the sessions.
+ */
+class BigramIndex {
+ public:
+    explicit BigramIndex(const uint8_t *const dicRoot);
+    // Non virtual inline destructor -- never inherit this class
+    ~BigramIndex() {}
+
+    // Returns the bigram probability in log space of the word at nextWordPosition after the word
+    // at wordPosition, like BinaryFormat::getBigramProbability().
+    int getBigramProbability(const int wordPosition, const int nextWordPosition,
+            const int unigramProbability) const;
+
+    bool isValidBigram(const int wordPosition, const int nextWordPosition) const;
+
+    // Returns the number of bigrams of the word at wordPosition, and sets the outputs to the
+    // arrays of their next word positions, sorted, and of their encoded probabilities.
+    int getBigrams(const int wordPosition, const int **const outNextWordPositions,
+            const uint8_t **const outProbabilities) const;
+
+    // Copies the code points of the bigram target at position to outWord, which has room for
+    // maxLength code points, and returns its length like BinaryFormat::getWordAtAddress().
+    // Returns 0 if position isn't the position of a bigram target.
+    int getTargetWordAtPosition(const int position, const int maxLength, int *const outWord,
+            int *const outUnigramProbability) const;
+
+    // Sets outTargetPositions and outProbabilities to the positions and the probabilities of the
+    // best maxPredictionCount bigram targets after the word at wordPosition that start with one
+    // of the firstCodePoints in base lower case, or of all of them if firstCodePointCount is 0.
+    // They are ranked from the best as by BigramDictionary::getBigrams(). Returns the number of
+    // matching bigrams, which may be more than the ones output.
+    int getPredictions(const int wordPosition, const int *const firstCodePoints,
+            const int firstCodePointCount, const int maxPredictionCount,
+            int *const outTargetPositions, int *const outProbabilities) const;
+
+    int getWordCount() const {
+        return static_cast<int>(mWordPositions.size());
+    }
+
+    int getBigramCount() const {
+        return static_cast<int>(mNextWordPositions.size());
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(BigramIndex);
+
+    // Returns the index in mNextWordPositions of the bigram of nextWordPosition after the word at
+    // wordPosition, or NOT_AN_INDEX if there is no such bigram.
+    int findBigram(const int wordPosition, const int nextWordPosition) const;
+    // Reads the code points of the bigram targets in the node at pos and in its descendants.
+    // word holds the depth code points of the parent groups.
+    void readTargetWords(const uint8_t *const dicRoot, int pos, int *const word, const int depth);
+
+    // Positions of the words with bigrams, sorted.
+    std::vector<int> mWordPositions;
+    // Index of the first bigram of each word in the arrays below, followed by the bigram count.
+    std::vector<int> mBigramStarts;
+    std::vector<int> mNextWordPositions;
+    std::vector<uint8_t> mProbabilities;
+    // Positions of the bigram targets, sorted, and for each of them the start and the length of
+    // its code points, and its unigram probability.
+    std::vector<int> mTargetPositions;
+    std::vector<int> mTargetStarts;
+    std::vector<uint8_t> mTargetLengths;
+    std::vector<uint8_t> mTargetProbabilities;
+    std::vector<int> mTargetCodePoints;
+    // The bigrams of each word again, as predictions in buckets by first code point of the target
+    // in base lower case. mWordBucketStarts holds the index of the first bucket of each word, and
+    // mBucketStarts the index of the first prediction of each bucket in the arrays below, both
+    // followed by the end. The predictions of a bucket are sorted from the best.
+    std::vector<int> mWordBucketStarts;
+    std::vector<int> mBucketFirstCodePoints;
+    std::vector<int> mBucketStarts;
+    std::vector<int> mPredictionTargets;
+    std::vector<int> mPredictionOrders;
+    std::vector<uint8_t> mPredictionProbabilities;
+};
+} // namespace latinime
+#endif // LATINIME_BIGRAM_INDEX_H
@@ -23,7 +23,6 @@
 
 #include "bloom_filter.h"
 #include "char_utils.h"
-#include "hash_map_compat.h"
 
 namespace latinime {
 
@@ -95,25 +94,38 @@ class BinaryFormat {
             const int unigramProbability, const int bigramProbability);
     static int getProbability(const int position, const std::map<int, int> *bigramMap,
             const uint8_t *bigramFilter, const int unigramProbability);
-    static int getBigramProbabilityFromHashMap(const int position,
-            const hash_map_compat<int, int> *bigramMap, const int unigramProbability);
     static float getMultiWordCostMultiplier(const uint8_t *const dict, const int dictSize);
-    static void fillBigramProbabilityToHashMap(const uint8_t *const root, int position,
-            hash_map_compat<int, int> *bigramMap);
     static int getBigramProbability(const uint8_t *const root, int position,
             const int nextPosition, const int unigramProbability);
+    static int getBigramListPositionForWordPosition(const uint8_t *const root, int position);
+    static int readSubtreeMaxProbability(const uint8_t *const dict, const int childrenPos,
+            const int childrenCount);
+    static bool hasChildTable(const int dictFlags, const int childrenCount);
+    static int getChildTablePos(const int dictFlags, const int childrenPos,
+            const int childrenCount);
+    static int readChildTableCodePoint(const uint8_t *const dict, const int childTablePos,
+            const int index);
+    static int readChildTableCharGroupPos(const uint8_t *const dict, const int childTablePos,
+            const int childrenPos, const int childrenCount, const int index);
 
     // Flags for special processing
     // Those *must* match the flags in makedict (BinaryDictInputOutput#*_PROCESSING_FLAG) or
     // something very bad (like, the apocalypse) will happen. Please update both at the same time.
     enum {
         REQUIRES_GERMAN_UMLAUT_PROCESSING = 0x1,
-        REQUIRES_FRENCH_LIGATURES_PROCESSING = 0x4
+        REQUIRES_FRENCH_LIGATURES_PROCESSING = 0x4,
+        // Each children array is preceded by the max probability of the words below its parent
+        CONTAINS_SUBTREE_MAX_PROBABILITIES = 0x10,
+        // Large children arrays are preceded by the first code points and the offsets of their
+        // char groups
+        CONTAINS_CHILD_TABLES = 0x20
     };
+    // Only children arrays with that many char groups have a child table. This must match
+    // FormatSpec#MIN_GROUP_COUNT_FOR_CHILD_TABLE.
+    static const int MIN_GROUP_COUNT_FOR_CHILD_TABLE = 16;
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(BinaryFormat);
-    static int getBigramListPositionForWordPosition(const uint8_t *const root, int position);
 
     static const int FLAG_GROUP_ADDRESS_TYPE_NOADDRESS = 0x00;
     static const int FLAG_GROUP_ADDRESS_TYPE_ONEBYTE = 0x40;
@@ -139,9 +151,13 @@ class BinaryFormat {
 
     static const int CHARACTER_ARRAY_TERMINATOR_SIZE = 1;
     static const int MINIMAL_ONE_BYTE_CHARACTER_VALUE = 0x20;
+    static const int MAX_ONE_BYTE_GROUP_COUNT = 0x7F;
     static const int CHARACTER_ARRAY_TERMINATOR = 0x1F;
     static const int MULTIPLE_BYTE_CHARACTER_ADDITIONAL_SIZE = 2;
     static const int NO_FLAGS = 0;
+    static const int SUBTREE_MAX_PROBABILITY_SIZE = 1;
+    static const int CHILD_TABLE_CODE_POINT_SIZE = 3;
+    static const int CHILD_TABLE_OFFSET_SIZE = 3;
     static int skipAllAttributes(const uint8_t *const dict, const uint8_t flags, const int pos);
     static int skipBigrams(const uint8_t *const dict, const uint8_t flags, const int pos);
 };
@@ -699,6 +715,47 @@ inline int BinaryFormat::computeProbabilityForBigram(
             + static_cast<int>(static_cast<float>(bigramProbability + 1) * stepSize);
 }
 
+// Returns the max probability stored before the children array at childrenPos, which is the
+// position past the group count. Only dictionaries with CONTAINS_SUBTREE_MAX_PROBABILITIES
+// store it.
+inline int BinaryFormat::readSubtreeMaxProbability(const uint8_t *const dict,
+        const int childrenPos, const int childrenCount) {
+    const int groupCountSize = childrenCount > MAX_ONE_BYTE_GROUP_COUNT ? 2 : 1;
+    return dict[childrenPos - groupCountSize - SUBTREE_MAX_PROBABILITY_SIZE];
+}
+
+// Returns whether a children array with childrenCount char groups has a child table. The root
+// children array never has one.
+inline bool BinaryFormat::hasChildTable(const int dictFlags, const int childrenCount) {
+    return (dictFlags & CONTAINS_CHILD_TABLES) && childrenCount >= MIN_GROUP_COUNT_FOR_CHILD_TABLE;
+}
+
+// Returns the position of the child table of the children array at childrenPos, which is the
+// position past the group count. The table holds the first code points of the char groups, then
+// their offsets from childrenPos, 3 bytes each and in the order of the char groups.
+inline int BinaryFormat::getChildTablePos(const int dictFlags, const int childrenPos,
+        const int childrenCount) {
+    const int groupCountSize = childrenCount > MAX_ONE_BYTE_GROUP_COUNT ? 2 : 1;
+    const int maxProbabilitySize =
+            (dictFlags & CONTAINS_SUBTREE_MAX_PROBABILITIES) ? SUBTREE_MAX_PROBABILITY_SIZE : 0;
+    return childrenPos - groupCountSize - maxProbabilitySize
+            - (CHILD_TABLE_CODE_POINT_SIZE + CHILD_TABLE_OFFSET_SIZE) * childrenCount;
+}
+
+inline int BinaryFormat::readChildTableCodePoint(const uint8_t *const dict,
+        const int childTablePos, const int index) {
+    const int pos = childTablePos + index * CHILD_TABLE_CODE_POINT_SIZE;
+    return (dict[pos] << 16) + (dict[pos + 1] << 8) + dict[pos + 2];
+}
+
+inline int BinaryFormat::readChildTableCharGroupPos(const uint8_t *const dict,
+        const int childTablePos, const int childrenPos, const int childrenCount,
+        const int index) {
+    const int pos = childTablePos + childrenCount * CHILD_TABLE_CODE_POINT_SIZE
+            + index * CHILD_TABLE_OFFSET_SIZE;
+    return childrenPos + (dict[pos] << 16) + (dict[pos + 1] << 8) + dict[pos + 2];
+}
+
 // This returns a probability in log space.
 inline int BinaryFormat::getProbability(const int position, const std::map<int, int> *bigramMap,
         const uint8_t *bigramFilter, const int unigramProbability) {
@@ -712,33 +769,6 @@ inline int BinaryFormat::getProbability(const int position, const std::map<int,
     return backoff(unigramProbability);
 }
 
-// This returns a probability in log space.
-inline int BinaryFormat::getBigramProbabilityFromHashMap(const int position,
-        const hash_map_compat<int, int> *bigramMap, const int unigramProbability) {
-    if (!bigramMap) return backoff(unigramProbability);
-    const hash_map_compat<int, int>::const_iterator bigramProbabilityIt = bigramMap->find(position);
-    if (bigramProbabilityIt != bigramMap->end()) {
-        const int bigramProbability = bigramProbabilityIt->second;
-        return computeProbabilityForBigram(unigramProbability, bigramProbability);
-    }
-    return backoff(unigramProbability);
-}
-
-AK_FORCE_INLINE void BinaryFormat::fillBigramProbabilityToHashMap(
-        const uint8_t *const root, int position, hash_map_compat<int, int> *bigramMap) {
-    position = getBigramListPositionForWordPosition(root, position);
-    if (0 == position) return;
-
-    uint8_t bigramFlags;
-    do {
-        bigramFlags = getFlagsAndForwardPointer(root, &position);
-        const int probability = MASK_ATTRIBUTE_PROBABILITY & bigramFlags;
-        const int bigramPos = getAttributeAddressAndForwardPointer(root, bigramFlags,
-                &position);
-        (*bigramMap)[bigramPos] = probability;
-    } while (FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
-}
-
 AK_FORCE_INLINE int BinaryFormat::getBigramProbability(const uint8_t *const root, int position,
         const int nextPosition, const int unigramProbability) {
     position = getBigramListPositionForWordPosition(root, position);
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: char_group_jump_table.cpp"
+
+#include "char_group_jump_table.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "binary_format.h"
+#include "char_utils.h"
+#include "defines.h"
+
+namespace latinime {
+
+namespace {
+// Node to index, as a range of the char groups read by the constructor.
+struct IndexedNode {
+    int mChildrenPos;
+    int mStart;
+    int mEnd;
+
+    bool operator<(const IndexedNode &node) const {
+        return mChildrenPos < node.mChildrenPos;
+    }
+};
+} // namespace
+
+const int CharGroupJumpTable::MIN_CHILD_COUNT = BinaryFormat::MIN_GROUP_COUNT_FOR_CHILD_TABLE;
+
+CharGroupJumpTable::CharGroupJumpTable(const uint8_t *const dicRoot, const int dictFlags)
+        : mDicRoot(dicRoot), mDictFlags(dictFlags), mNodePositions(), mNodeStarts(),
+          mFirstCodePoints(), mCharGroupPositions() {
+    // The other nodes are found through the child tables, if any.
+    const bool indexesRootOnly = (dictFlags & BinaryFormat::CONTAINS_CHILD_TABLES) != 0;
+    // First code points in base lower case and positions of the char groups of the nodes to
+    // index, in the order of the dictionary.
+    std::vector<std::pair<int, int> > charGroups;
+    std::vector<IndexedNode> indexedNodes;
+    std::vector<int> nodePositions;
+    nodePositions.push_back(0);
+    while (!nodePositions.empty()) {
+        int pos = nodePositions.back();
+        nodePositions.pop_back();
+        const int groupCount = BinaryFormat::getGroupCountAndForwardPointer(dicRoot, &pos);
+        const bool isIndexed = isWorthIndexing(groupCount);
+        IndexedNode indexedNode;
+        indexedNode.mChildrenPos = pos;
+        indexedNode.mStart = static_cast<int>(charGroups.size());
+        for (int i = 0; i < groupCount; ++i) {
+            const int groupPos = pos;
+            const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(dicRoot, &pos);
+            const int codePoint = BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos);
+            if (isIndexed) {
+                charGroups.push_back(std::pair<int, int>(toBaseLowerCase(codePoint), groupPos));
+            }
+            if (flags & BinaryFormat::FLAG_HAS_MULTIPLE_CHARS) {
+                pos = BinaryFormat::skipOtherCharacters(dicRoot, pos);
+            }
+            pos = BinaryFormat::skipProbability(flags, pos);
+            if (BinaryFormat::hasChildrenInFlags(flags) && !indexesRootOnly) {
+                nodePositions.push_back(BinaryFormat::readChildrenPosition(dicRoot, flags, pos));
+            }
+            pos = BinaryFormat::skipChildrenPosAndAttributes(dicRoot, flags, pos);
+        }
+        if (isIndexed) {
+            indexedNode.mEnd = static_cast<int>(charGroups.size());
+            indexedNodes.push_back(indexedNode);
+        }
+    }
+
+    std::sort(indexedNodes.begin(), indexedNodes.end());
+    mNodePositions.reserve(indexedNodes.size());
+    mNodeStarts.reserve(indexedNodes.size() + 1);
+    mFirstCodePoints.reserve(charGroups.size());
+    mCharGroupPositions.reserve(charGroups.size());
+    for (size_t i = 0; i < indexedNodes.size(); ++i) {
+        const std::vector<std::pair<int, int> >::iterator begin =
+                charGroups.begin() + indexedNodes[i].mStart;
+        const std::vector<std::pair<int, int> >::iterator end =
+                charGroups.begin() + indexedNodes[i].mEnd;
+        // Char group positions grow along the node, so this also keeps the order of the
+        // dictionary among the char groups of a code point.
+        std::sort(begin, end);
+        mNodePositions.push_back(indexedNodes[i].mChildrenPos);
+        mNodeStarts.push_back(static_cast<int>(mFirstCodePoints.size()));
+        for (std::vector<std::pair<int, int> >::iterator it = begin; it != end; ++it) {
+            mFirstCodePoints.push_back(it->first);
+            mCharGroupPositions.push_back(it->second);
+        }
+    }
+    mNodeStarts.push_back(static_cast<int>(mFirstCodePoints.size()));
+    if (DEBUG_DICT) {
+        AKLOGI("CharGroupJumpTable: %d nodes, %d char groups", getNodeCount(),
+                static_cast<int>(mCharGroupPositions.size()));
+    }
+}
+
+int CharGroupJumpTable::getNodeIndex(const int childrenPos) const {
+    const std::vector<int>::const_iterator it =
+            std::lower_bound(mNodePositions.begin(), mNodePositions.end(), childrenPos);
+    if (it == mNodePositions.end() || *it != childrenPos) {
+        return NOT_AN_INDEX;
+    }
+    return static_cast<int>(it - mNodePositions.begin());
+}
+
+int CharGroupJumpTable::getCharGroupPositions(const int childrenPos, const int childCount,
+        const int *const baseLowerCodePoints, const int baseLowerCodePointCount,
+        const int maxCharGroupCount, int *const outCharGroupPositions) const {
+    int charGroupCount = 0;
+    const int nodeIndex = getNodeIndex(childrenPos);
+    if (NOT_AN_INDEX != nodeIndex) {
+        const int *const begin = &mFirstCodePoints[0] + mNodeStarts[nodeIndex];
+        const int *const end = &mFirstCodePoints[0] + mNodeStarts[nodeIndex + 1];
+        for (int i = 0; i < baseLowerCodePointCount; ++i) {
+            const std::pair<const int *, const int *> range =
+                    std::equal_range(begin, end, baseLowerCodePoints[i]);
+            const int count = static_cast<int>(range.second - range.first);
+            if (charGroupCount + count > maxCharGroupCount) {
+                return NOT_AN_INDEX;
+            }
+            const int *const positions =
+                    &mCharGroupPositions[0] + (range.first - &mFirstCodePoints[0]);
+            for (int j = 0; j < count; ++j) {
+                outCharGroupPositions[charGroupCount++] = positions[j];
+            }
+        }
+        std::sort(outCharGroupPositions, outCharGroupPositions + charGroupCount);
+        return charGroupCount;
+    }
+    if (!BinaryFormat::hasChildTable(mDictFlags, childCount)) {
+        return NOT_AN_INDEX;
+    }
+    // The code points of the child table are fixed width, so they are compared without decoding
+    // the char groups, which are already in the order of the dictionary.
+    const int childTablePos = BinaryFormat::getChildTablePos(mDictFlags, childrenPos, childCount);
+    for (int i = 0; i < childCount; ++i) {
+        const int baseLowerCodePoint = toBaseLowerCase(
+                BinaryFormat::readChildTableCodePoint(mDicRoot, childTablePos, i));
+        for (int j = 0; j < baseLowerCodePointCount; ++j) {
+            if (baseLowerCodePoints[j] != baseLowerCodePoint) continue;
+            if (charGroupCount >= maxCharGroupCount) {
+                return NOT_AN_INDEX;
+            }
+            outCharGroupPositions[charGroupCount++] = BinaryFormat::readChildTableCharGroupPos(
+                    mDicRoot, childTablePos, childrenPos, childCount, i);
+            break;
+        }
+    }
+    return charGroupCount;
+}
+} // namespace latinime
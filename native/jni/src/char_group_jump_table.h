@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_CHAR_GROUP_JUMP_TABLE_H
+#define LATINIME_CHAR_GROUP_JUMP_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Positions of the char groups of the nodes of a dictionary with many children, by first code
+ * point in base lower case. It lets a search that only wants the children matching a touch point
+ * jump to them, instead of reading every char group of the node to find the next one. It is built
+ * once when the dictionary is opened and is read-only afterwards, so it can be shared by all the
+ * sessions and their worker threads. Dictionaries with child tables already store the first code
+ * points of the large nodes, so only their root node, which has no child table, is built.
+ */
+class CharGroupJumpTable {
+ public:
+    CharGroupJumpTable(const uint8_t *const dicRoot, const int dictFlags);
+    // Non virtual inline destructor -- never inherit this class
+    ~CharGroupJumpTable() {}
+
+    // Sets outCharGroupPositions to the positions of the char groups of the node whose char
+    // groups start at childrenPos, which is the position past its group count, and whose first
+    // code point in base lower case is one of the distinct baseLowerCodePoints. They are in the
+    // order of the dictionary. Returns their count, or NOT_AN_INDEX if the node isn't in the
+    // table or if more than maxCharGroupCount char groups match.
+    int getCharGroupPositions(const int childrenPos, const int childCount,
+            const int *const baseLowerCodePoints, const int baseLowerCodePointCount,
+            const int maxCharGroupCount, int *const outCharGroupPositions) const;
+
+    int getNodeCount() const {
+        return static_cast<int>(mNodePositions.size());
+    }
+
+    static bool isWorthIndexing(const int childCount) {
+        return childCount >= MIN_CHILD_COUNT;
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(CharGroupJumpTable);
+
+    // Nodes with fewer children are faster to read in full than to look up. This is the same
+    // count as the one of the child tables so that the nodes without one are never indexed.
+    static const int MIN_CHILD_COUNT;
+
+    // Returns the index of the node whose char groups start at childrenPos, or NOT_AN_INDEX if
+    // the node isn't in the arrays below.
+    int getNodeIndex(const int childrenPos) const;
+
+    const uint8_t *const mDicRoot;
+    const int mDictFlags;
+
+    // Children positions of the nodes, sorted.
+    std::vector<int> mNodePositions;
+    // Index of the first char group of each node in the arrays below, followed by the end. The
+    // char groups of a node are sorted by first code point, then by position.
+    std::vector<int> mNodeStarts;
+    std::vector<int> mFirstCodePoints;
+    std::vector<int> mCharGroupPositions;
+};
+} // namespace latinime
+#endif // LATINIME_CHAR_GROUP_JUMP_TABLE_H
@@ -120,7 +120,8 @@ class Correction {
     void initInputParams(const ProximityInfo *proximityInfo, const int *inputCodes,
             const int inputSize, const int *xCoordinates, const int *yCoordinates) {
         mProximityInfoState.initInputParams(0, static_cast<float>(MAX_VALUE_FOR_WEIGHTING),
-                proximityInfo, inputCodes, inputSize, xCoordinates, yCoordinates, 0, 0, false);
+                proximityInfo, inputCodes, inputSize, xCoordinates, yCoordinates, 0, 0, false,
+                NOT_AN_INDEX);
     }
 
     const int *getPrimaryInputWord() const {
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: decoded_trie.cpp"
+
+#include "decoded_trie.h"
+
+#include <algorithm>
+
+#include "binary_format.h"
+#include "defines.h"
+
+namespace latinime {
+
+namespace {
+// Char group as read by the constructor, before it is stored at its index.
+struct CharGroup {
+    int mPosition;
+    uint8_t mFlags;
+    uint8_t mProbability;
+    int mCodePointStart;
+    int mCodePointEnd;
+    int mChildrenPosition;
+    int mChildrenCount;
+    int mAttributesPosition;
+    int mSiblingPosition;
+
+    bool operator<(const CharGroup &charGroup) const {
+        return mPosition < charGroup.mPosition;
+    }
+};
+} // namespace
+
+DecodedTrie::DecodedTrie(const uint8_t *const dicRoot)
+        : mCharGroupBits(), mCharGroupRanks(), mPositions(), mFlags(), mProbabilities(),
+          mCodePointStarts(), mCodePoints(), mChildrenPositions(), mChildrenCounts(),
+          mAttributesPositions(), mSiblingPositions() {
+    // Code points of the char groups, in the order they are read.
+    std::vector<int> codePoints;
+    std::vector<CharGroup> charGroups;
+    std::vector<int> nodePositions;
+    nodePositions.push_back(0);
+    while (!nodePositions.empty()) {
+        int pos = nodePositions.back();
+        nodePositions.pop_back();
+        const int groupCount = BinaryFormat::getGroupCountAndForwardPointer(dicRoot, &pos);
+        for (int i = 0; i < groupCount; ++i) {
+            CharGroup charGroup;
+            charGroup.mPosition = pos;
+            const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(dicRoot, &pos);
+            charGroup.mFlags = flags;
+            charGroup.mCodePointStart = static_cast<int>(codePoints.size());
+            codePoints.push_back(BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos));
+            if (flags & BinaryFormat::FLAG_HAS_MULTIPLE_CHARS) {
+                int codePoint = BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos);
+                while (NOT_A_CODE_POINT != codePoint) {
+                    codePoints.push_back(codePoint);
+                    codePoint = BinaryFormat::getCodePointAndForwardPointer(dicRoot, &pos);
+                }
+            }
+            charGroup.mCodePointEnd = static_cast<int>(codePoints.size());
+            charGroup.mProbability = (flags & BinaryFormat::FLAG_IS_TERMINAL)
+                    ? static_cast<uint8_t>(
+                            BinaryFormat::readProbabilityWithoutMovingPointer(dicRoot, pos))
+                    : 0;
+            pos = BinaryFormat::skipProbability(flags, pos);
+            charGroup.mChildrenPosition = 0;
+            charGroup.mChildrenCount = 0;
+            if (BinaryFormat::hasChildrenInFlags(flags)) {
+                int childrenPos = BinaryFormat::readChildrenPosition(dicRoot, flags, pos);
+                nodePositions.push_back(childrenPos);
+                charGroup.mChildrenCount =
+                        BinaryFormat::getGroupCountAndForwardPointer(dicRoot, &childrenPos);
+                charGroup.mChildrenPosition = childrenPos;
+            }
+            charGroup.mAttributesPosition = BinaryFormat::skipChildrenPosition(flags, pos);
+            pos = BinaryFormat::skipChildrenPosAndAttributes(dicRoot, flags, pos);
+            charGroup.mSiblingPosition = pos;
+            charGroups.push_back(charGroup);
+        }
+    }
+
+    std::sort(charGroups.begin(), charGroups.end());
+    const size_t charGroupCount = charGroups.size();
+    mPositions.reserve(charGroupCount);
+    mFlags.reserve(charGroupCount);
+    mProbabilities.reserve(charGroupCount);
+    mCodePointStarts.reserve(charGroupCount + 1);
+    mCodePoints.reserve(codePoints.size());
+    mChildrenPositions.reserve(charGroupCount);
+    mChildrenCounts.reserve(charGroupCount);
+    mAttributesPositions.reserve(charGroupCount);
+    mSiblingPositions.reserve(charGroupCount);
+    for (size_t i = 0; i < charGroupCount; ++i) {
+        const CharGroup &charGroup = charGroups[i];
+        mPositions.push_back(charGroup.mPosition);
+        mFlags.push_back(charGroup.mFlags);
+        mProbabilities.push_back(charGroup.mProbability);
+        mCodePointStarts.push_back(static_cast<int>(mCodePoints.size()));
+        mCodePoints.insert(mCodePoints.end(), codePoints.begin() + charGroup.mCodePointStart,
+                codePoints.begin() + charGroup.mCodePointEnd);
+        mChildrenPositions.push_back(charGroup.mChildrenPosition);
+        mChildrenCounts.push_back(static_cast<uint16_t>(charGroup.mChildrenCount));
+        mAttributesPositions.push_back(charGroup.mAttributesPosition);
+        mSiblingPositions.push_back(charGroup.mSiblingPosition);
+    }
+    mCodePointStarts.push_back(static_cast<int>(mCodePoints.size()));
+
+    const int wordCount = mPositions.empty() ? 0 : (mPositions.back() >> 5) + 1;
+    mCharGroupBits.resize(wordCount, 0);
+    mCharGroupRanks.resize(wordCount, 0);
+    for (int i = 0; i < getCharGroupCount(); ++i) {
+        mCharGroupBits[mPositions[i] >> 5] |= 1u << (mPositions[i] & 31);
+    }
+    for (int i = 1; i < wordCount; ++i) {
+        mCharGroupRanks[i] = mCharGroupRanks[i - 1] + countBits(mCharGroupBits[i - 1]);
+    }
+    if (DEBUG_DICT) {
+        AKLOGI("DecodedTrie: %d char groups, %d code points", getCharGroupCount(),
+                static_cast<int>(mCodePoints.size()));
+    }
+}
+} // namespace latinime
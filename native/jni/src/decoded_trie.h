@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DECODED_TRIE_H
+#define LATINIME_DECODED_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * The char groups of a dictionary, decoded once into fixed width arrays indexed by char group,
+ * so that the children of a node can be read without decoding the variable width format of the
+ * dictionary. The char groups are indexed in the order of their positions, so the children of a
+ * node have consecutive indices. Positions are kept as they are in the dictionary, and the
+ * shortcut and bigram lists are still read from there through the attributes positions. It
+ * takes a few MB for a main dictionary, so it is only built when the dictionary is opened with
+ * useDecodedTrie set.
+ */
+class DecodedTrie {
+ public:
+    explicit DecodedTrie(const uint8_t *const dicRoot);
+    // Non virtual inline destructor -- never inherit this class
+    ~DecodedTrie() {}
+
+    // Returns the index of the char group at pos, or NOT_AN_INDEX if there is none. The children
+    // of a node with childrenPos, which is the position past its group count, start at
+    // getCharGroupIndex(childrenPos).
+    int getCharGroupIndex(const int pos) const {
+        const int word = pos >> 5;
+        if (pos < 0 || word >= static_cast<int>(mCharGroupBits.size())) {
+            return NOT_AN_INDEX;
+        }
+        const uint32_t bit = 1u << (pos & 31);
+        if (!(mCharGroupBits[word] & bit)) {
+            return NOT_AN_INDEX;
+        }
+        return mCharGroupRanks[word] + countBits(mCharGroupBits[word] & (bit - 1));
+    }
+
+    int getCharGroupCount() const {
+        return static_cast<int>(mPositions.size());
+    }
+
+    int getPosition(const int index) const {
+        return mPositions[index];
+    }
+
+    uint8_t getFlags(const int index) const {
+        return mFlags[index];
+    }
+
+    // Returns the code points of the char group at index, of which there are
+    // getCodePointCount(index).
+    const int *getCodePoints(const int index) const {
+        return &mCodePoints[mCodePointStarts[index]];
+    }
+
+    int getCodePointCount(const int index) const {
+        return mCodePointStarts[index + 1] - mCodePointStarts[index];
+    }
+
+    // Returns the unigram probability of the char group at index, which is only meaningful if it
+    // is terminal.
+    int getProbability(const int index) const {
+        return mProbabilities[index];
+    }
+
+    int getChildrenPosition(const int index) const {
+        return mChildrenPositions[index];
+    }
+
+    int getChildrenCount(const int index) const {
+        return mChildrenCounts[index];
+    }
+
+    int getAttributesPosition(const int index) const {
+        return mAttributesPositions[index];
+    }
+
+    int getSiblingPosition(const int index) const {
+        return mSiblingPositions[index];
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(DecodedTrie);
+
+    static int countBits(uint32_t bits) {
+        bits = bits - ((bits >> 1) & 0x55555555u);
+        bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+        return static_cast<int>((((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+    }
+
+    // Bit i of mCharGroupBits is set if there is a char group at position i, and each word of
+    // mCharGroupRanks is the number of char groups before the positions of the same word of
+    // mCharGroupBits, to find the index of a char group from its position in constant time.
+    std::vector<uint32_t> mCharGroupBits;
+    std::vector<int> mCharGroupRanks;
+    std::vector<int> mPositions;
+    std::vector<uint8_t> mFlags;
+    std::vector<uint8_t> mProbabilities;
+    // Index of the first code point of each char group in mCodePoints, followed by the end.
+    std::vector<int> mCodePointStarts;
+    std::vector<int> mCodePoints;
+    // Positions past the group count of the children nodes, or 0 for char groups without
+    // children.
+    std::vector<int> mChildrenPositions;
+    std::vector<uint16_t> mChildrenCounts;
+    std::vector<int> mAttributesPositions;
+    std::vector<int> mSiblingPositions;
+};
+} // namespace latinime
+#endif // LATINIME_DECODED_TRIE_H
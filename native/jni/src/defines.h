@@ -73,7 +73,7 @@ AK_FORCE_INLINE static int intArrayToCharArray(const int *source, const int sour
 
 static inline void dumpWordInfo(const int *word, const int length, const int rank,
         const int probability) {
-    static char charBuf[50];
+    char charBuf[50];
     const int N = intArrayToCharArray(word, length, charBuf);
     if (N > 1) {
         AKLOGI("%2d [ %s ] (%d)", rank, charBuf, probability);
@@ -89,7 +89,7 @@ static inline void dumpResult(const int *outWords, const int *frequencies) {
 }
 
 static AK_FORCE_INLINE void dumpWord(const int *word, const int length) {
-    static char charBuf[50];
+    char charBuf[50];
     const int N = intArrayToCharArray(word, length, charBuf);
     if (N > 1) {
         AKLOGI("[ %s ]", charBuf);
@@ -141,9 +141,11 @@ static inline void showStackTrace() {
 #include <time.h>
 
 #define PROF_BUF_SIZE 100
-static float profile_buf[PROF_BUF_SIZE];
-static float profile_old[PROF_BUF_SIZE];
-static unsigned int profile_counter[PROF_BUF_SIZE];
+// Thread local so that searches profiled concurrently on different sessions don't mix their
+// counters.
+static __thread float profile_buf[PROF_BUF_SIZE];
+static __thread float profile_old[PROF_BUF_SIZE];
+static __thread unsigned int profile_counter[PROF_BUF_SIZE];
 
 #define PROF_RESET               prof_reset()
 #define PROF_COUNT(prof_buf_id)  ++profile_counter[prof_buf_id]
@@ -290,6 +292,13 @@ static inline void prof_out(void) {
 #define CALIBRATE_SCORE_BY_TOUCH_COORDINATES true
 #define SUGGEST_MULTIPLE_WORDS true
 #define USE_SUGGEST_INTERFACE_FOR_TYPING true
+// Decode the bigram lists of the dictionary when it is opened, for faster bigram lookups
+#define USE_BIGRAM_INDEX true
+// Index the children of the nodes with many of them by code point when the dictionary is opened
+#define USE_CHAR_GROUP_JUMP_TABLE true
+// Hash the words of the dictionary to their positions on the first exact word lookup, for lookups
+// that don't read the dictionary. Costs about 8 bytes per word.
+#define USE_WORD_POSITION_INDEX true
 #define SUGGEST_INTERFACE_OUTPUT_SCALE 1000000.0f
 
 // The following "rate"s are used as a multiplier before dividing by 100, so they are in percent.
@@ -379,14 +388,11 @@ static inline void prof_out(void) {
 #error "BIGRAM_FILTER_MODULO is larger than BIGRAM_FILTER_BYTE_SIZE"
 #endif
 
-// Max number of bigram maps (previous word contexts) to be cached. Increasing this number could
-// improve bigram lookup speed for multi-word suggestions, but at the cost of more memory usage.
-// Also, there are diminishing returns since the most frequently used bigrams are typically near
-// the beginning of the input and are thus the first ones to be cached. Note that these bigrams
-// are reset for each new composing word.
+// Max number of bigram maps (previous word contexts) to be cached by each worker. Increasing this
+// number could improve bigram lookup speed for multi-word suggestions, but at the cost of more
+// memory usage. The maps are kept across composing words, the least recently used one being
+// evicted when they are all used.
 #define MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP 25
-// Most common previous word contexts currently have 100 bigrams
-#define DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP 100
 
 template<typename T> AK_FORCE_INLINE const T &min(const T &a, const T &b) { return a < b ? a : b; }
 template<typename T> AK_FORCE_INLINE const T &max(const T &a, const T &b) { return a > b ? a : b; }
@@ -23,4 +23,10 @@ void *(*DicTraverseWrapper::sDicTraverseSessionFactoryMethod)(JNIEnv *, jstring)
 void (*DicTraverseWrapper::sDicTraverseSessionReleaseMethod)(void *) = 0;
 void (*DicTraverseWrapper::sDicTraverseSessionInitMethod)(
         void *, const Dictionary *const, const int *, const int) = 0;
+void (*DicTraverseWrapper::sDicTraverseSessionSearchBudgetMethod)(void *, const int, const int) =
+        0;
+bool (*DicTraverseWrapper::sDicTraverseSessionIsLastSearchPartialMethod)(const void *) = 0;
+StreamedInput *(*DicTraverseWrapper::sDicTraverseSessionStreamedInputMethod)(void *) = 0;
+void (*DicTraverseWrapper::sDicTraverseSessionBigramMapCountsMethod)(
+        const void *, int *const, int *const) = 0;
 } // namespace latinime
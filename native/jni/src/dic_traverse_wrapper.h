@@ -22,7 +22,10 @@
 
 namespace latinime {
 class Dictionary;
+class StreamedInput;
 // TODO: Remove
+// The methods are set by a static registerer while the library is loaded and are only read
+// afterwards, so sessions can be created, initialized and released from any thread.
 class DicTraverseWrapper {
  public:
     static void *getDicTraverseSession(JNIEnv *env, jstring locale) {
@@ -42,6 +45,34 @@ class DicTraverseWrapper {
             sDicTraverseSessionReleaseMethod(traverseSession);
         }
     }
+    static void setSearchBudget(void *traverseSession, const int timeBudgetMicros,
+            const int maxExpandedDicNodeCount) {
+        if (sDicTraverseSessionSearchBudgetMethod) {
+            sDicTraverseSessionSearchBudgetMethod(
+                    traverseSession, timeBudgetMicros, maxExpandedDicNodeCount);
+        }
+    }
+    static bool isLastSearchPartial(const void *traverseSession) {
+        if (sDicTraverseSessionIsLastSearchPartialMethod) {
+            return sDicTraverseSessionIsLastSearchPartialMethod(traverseSession);
+        }
+        return false;
+    }
+    static StreamedInput *getStreamedInput(void *traverseSession) {
+        if (sDicTraverseSessionStreamedInputMethod) {
+            return sDicTraverseSessionStreamedInputMethod(traverseSession);
+        }
+        return 0;
+    }
+    static void getBigramMapCounts(const void *traverseSession, int *const hitCount,
+            int *const missCount) {
+        if (sDicTraverseSessionBigramMapCountsMethod) {
+            sDicTraverseSessionBigramMapCountsMethod(traverseSession, hitCount, missCount);
+            return;
+        }
+        *hitCount = 0;
+        *missCount = 0;
+    }
     static void setTraverseSessionFactoryMethod(void *(*factoryMethod)(JNIEnv *, jstring)) {
         sDicTraverseSessionFactoryMethod = factoryMethod;
     }
@@ -52,6 +83,22 @@ class DicTraverseWrapper {
     static void setTraverseSessionReleaseMethod(void (*releaseMethod)(void *)) {
         sDicTraverseSessionReleaseMethod = releaseMethod;
     }
+    static void setTraverseSessionSearchBudgetMethod(
+            void (*searchBudgetMethod)(void *, const int, const int)) {
+        sDicTraverseSessionSearchBudgetMethod = searchBudgetMethod;
+    }
+    static void setTraverseSessionIsLastSearchPartialMethod(
+            bool (*isLastSearchPartialMethod)(const void *)) {
+        sDicTraverseSessionIsLastSearchPartialMethod = isLastSearchPartialMethod;
+    }
+    static void setTraverseSessionStreamedInputMethod(
+            StreamedInput *(*streamedInputMethod)(void *)) {
+        sDicTraverseSessionStreamedInputMethod = streamedInputMethod;
+    }
+    static void setTraverseSessionBigramMapCountsMethod(
+            void (*bigramMapCountsMethod)(const void *, int *const, int *const)) {
+        sDicTraverseSessionBigramMapCountsMethod = bigramMapCountsMethod;
+    }
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(DicTraverseWrapper);
@@ -59,6 +106,10 @@ class DicTraverseWrapper {
     static void (*sDicTraverseSessionInitMethod)(
             void *, const Dictionary *const, const int *, const int);
     static void (*sDicTraverseSessionReleaseMethod)(void *);
+    static void (*sDicTraverseSessionSearchBudgetMethod)(void *, const int, const int);
+    static bool (*sDicTraverseSessionIsLastSearchPartialMethod)(const void *);
+    static StreamedInput *(*sDicTraverseSessionStreamedInputMethod)(void *);
+    static void (*sDicTraverseSessionBigramMapCountsMethod)(const void *, int *const, int *const);
 };
 } // namespace latinime
 #endif // LATINIME_DIC_TRAVERSE_WRAPPER_H
@@ -22,24 +22,35 @@
 #include <stdint.h>
 
 #include "bigram_dictionary.h"
+#include "bigram_index.h"
 #include "binary_format.h"
+#include "char_group_jump_table.h"
+#include "decoded_trie.h"
 #include "defines.h"
 #include "dic_traverse_wrapper.h"
 #include "suggest/core/suggest.h"
 #include "suggest/policyimpl/gesture/gesture_suggest_policy_factory.h"
 #include "suggest/policyimpl/typing/typing_suggest_policy_factory.h"
 #include "unigram_dictionary.h"
+#include "word_position_index.h"
 
 namespace latinime {
 
-Dictionary::Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust)
+Dictionary::Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust,
+        bool useDecodedTrie)
         : mDict(static_cast<unsigned char *>(dict)),
           mOffsetDict((static_cast<unsigned char *>(dict))
                   + BinaryFormat::getHeaderSize(mDict, dictSize)),
           mDictSize(dictSize), mMmapFd(mmapFd), mDictBufAdjust(dictBufAdjust),
+          mWordPositionIndex(USE_WORD_POSITION_INDEX ? new WordPositionIndex(mOffsetDict) : 0),
           mUnigramDictionary(new UnigramDictionary(mOffsetDict,
-                  BinaryFormat::getFlags(mDict, dictSize))),
-          mBigramDictionary(new BigramDictionary(mOffsetDict)),
+                  BinaryFormat::getFlags(mDict, dictSize), mWordPositionIndex)),
+          mBigramIndex(USE_BIGRAM_INDEX ? new BigramIndex(mOffsetDict) : 0),
+          mBigramDictionary(new BigramDictionary(mOffsetDict, mBigramIndex, mWordPositionIndex)),
+          mCharGroupJumpTable(USE_CHAR_GROUP_JUMP_TABLE
+                  ? new CharGroupJumpTable(mOffsetDict, BinaryFormat::getFlags(mDict, dictSize))
+                  : 0),
+          mDecodedTrie(useDecodedTrie ? new DecodedTrie(mOffsetDict) : 0),
           mGestureSuggest(new Suggest(GestureSuggestPolicyFactory::getGestureSuggestPolicy())),
           mTypingSuggest(new Suggest(TypingSuggestPolicyFactory::getTypingSuggestPolicy())) {
 }
@@ -47,6 +58,10 @@ Dictionary::Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust)
 Dictionary::~Dictionary() {
     delete mUnigramDictionary;
     delete mBigramDictionary;
+    delete mBigramIndex;
+    delete mCharGroupJumpTable;
+    delete mDecodedTrie;
+    delete mWordPositionIndex;
     delete mGestureSuggest;
     delete mTypingSuggest;
 }
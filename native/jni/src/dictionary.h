@@ -24,9 +24,13 @@
 namespace latinime {
 
 class BigramDictionary;
+class BigramIndex;
+class CharGroupJumpTable;
+class DecodedTrie;
 class ProximityInfo;
 class SuggestInterface;
 class UnigramDictionary;
+class WordPositionIndex;
 
 class Dictionary {
  public:
@@ -46,7 +50,7 @@ class Dictionary {
     static const int KIND_FLAG_POSSIBLY_OFFENSIVE = 0x80000000;
     static const int KIND_FLAG_EXACT_MATCH = 0x40000000;
 
-    Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust);
+    Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust, bool useDecodedTrie);
 
     int getSuggestions(ProximityInfo *proximityInfo, void *traverseSession, int *xcoordinates,
             int *ycoordinates, int *times, int *pointerIds, int *inputCodePoints, int inputSize,
@@ -69,6 +73,16 @@ class Dictionary {
     int getMmapFd() const { return mMmapFd; }
     int getDictBufAdjust() const { return mDictBufAdjust; }
     int getDictFlags() const;
+    // Returns the decoded bigram lists of the dictionary, or 0 if they aren't indexed.
+    const BigramIndex *getBigramIndex() const { return mBigramIndex; }
+    // Returns the jump table of the nodes with many children, or 0 if there is none.
+    const CharGroupJumpTable *getCharGroupJumpTable() const { return mCharGroupJumpTable; }
+    // Returns the decoded char groups of the dictionary, or 0 if they are read from the
+    // dictionary.
+    const DecodedTrie *getDecodedTrie() const { return mDecodedTrie; }
+
+    // Returns the positions of the words of the dictionary, or 0 if they aren't indexed.
+    const WordPositionIndex *getWordPositionIndex() const { return mWordPositionIndex; }
     virtual ~Dictionary();
 
  private:
@@ -82,8 +96,12 @@ class Dictionary {
     const int mMmapFd;
     const int mDictBufAdjust;
 
+    const WordPositionIndex *mWordPositionIndex;
     const UnigramDictionary *mUnigramDictionary;
+    const BigramIndex *mBigramIndex;
     const BigramDictionary *mBigramDictionary;
+    const CharGroupJumpTable *mCharGroupJumpTable;
+    const DecodedTrie *mDecodedTrie;
     SuggestInterface *mGestureSuggest;
     SuggestInterface *mTypingSuggest;
 };
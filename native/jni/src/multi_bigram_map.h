@@ -17,73 +17,312 @@
 #ifndef LATINIME_MULTI_BIGRAM_MAP_H
 #define LATINIME_MULTI_BIGRAM_MAP_H
 
-#include <cstring>
 #include <stdint.h>
+#include <vector>
 
 #include "defines.h"
+#include "bigram_index.h"
 #include "binary_format.h"
-#include "hash_map_compat.h"
+
+// Size of the hash table of the cached bigram maps by previous word position. A power of 2 that
+// leaves enough empty entries for the probe sequences to stay short.
+#define BIGRAM_MAP_INDEX_TABLE_SIZE 64
+
+#if BIGRAM_MAP_INDEX_TABLE_SIZE < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP * 2
+#error "BIGRAM_MAP_INDEX_TABLE_SIZE is too small for MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP"
+#endif
 
 namespace latinime {
 
 // Class for caching bigram maps for multiple previous word contexts. This is useful since the
 // algorithm needs to look up the set of bigrams for every word pair that occurs in every
-// multi-word suggestion.
+// multi-word suggestion. The maps only depend on the dictionary, so they are kept across
+// searches, and the least recently used one is evicted to cache the bigrams of a new previous
+// word.
 class MultiBigramMap {
  public:
-    MultiBigramMap() : mBigramMaps() {}
+    MultiBigramMap()
+            : mBigramIndex(0), mBigramMaps(MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP), mUsedCount(0),
+              mMostRecentlyUsedIndex(NOT_AN_INDEX), mLeastRecentlyUsedIndex(NOT_AN_INDEX),
+              mHitCount(0), mMissCount(0) {
+        clear();
+    }
     ~MultiBigramMap() {}
 
     // Look up the bigram probability for the given word pair from the cached bigram maps.
-    // Also caches the bigrams if there is space remaining and they have not been cached already.
+    // Also caches the bigrams if they have not been cached already.
     int getBigramProbability(const uint8_t *const dicRoot, const int wordPosition,
             const int nextWordPosition, const int unigramProbability) {
-        hash_map_compat<int, BigramMap>::const_iterator mapPosition =
-                mBigramMaps.find(wordPosition);
-        if (mapPosition != mBigramMaps.end()) {
-            return mapPosition->second.getBigramProbability(nextWordPosition, unigramProbability);
-        }
-        if (mBigramMaps.size() < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP) {
-            addBigramsForWordPosition(dicRoot, wordPosition);
-            return mBigramMaps[wordPosition].getBigramProbability(
-                    nextWordPosition, unigramProbability);
-        }
-        return BinaryFormat::getBigramProbability(
-                dicRoot, wordPosition, nextWordPosition, unigramProbability);
+        int index = mMostRecentlyUsedIndex;
+        if (index == NOT_AN_INDEX || mBigramMaps[index].getWordPosition() != wordPosition) {
+            index = findIndex(wordPosition);
+            if (index == NOT_AN_INDEX) {
+                ++mMissCount;
+                index = addBigramsForWordPosition(dicRoot, wordPosition);
+            } else {
+                ++mHitCount;
+            }
+            setMostRecentlyUsed(index);
+        } else {
+            ++mHitCount;
+        }
+        return mBigramMaps[index].getBigramProbability(nextWordPosition, unigramProbability);
     }
 
     void clear() {
-        mBigramMaps.clear();
+        for (int i = 0; i < BIGRAM_MAP_INDEX_TABLE_SIZE; ++i) {
+            mIndexTable[i] = NOT_AN_INDEX;
+        }
+        for (int i = 0; i < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP; ++i) {
+            mPreviousIndices[i] = NOT_AN_INDEX;
+            mNextIndices[i] = NOT_AN_INDEX;
+        }
+        mUsedCount = 0;
+        mMostRecentlyUsedIndex = NOT_AN_INDEX;
+        mLeastRecentlyUsedIndex = NOT_AN_INDEX;
+    }
+
+    // Sets the decoded bigram lists of the dictionary to read the bigrams from instead of the
+    // dictionary, or 0. The map has to be cleared when the dictionary changes.
+    void setBigramIndex(const BigramIndex *const bigramIndex) {
+        mBigramIndex = bigramIndex;
+    }
+
+    // Number of lookups that found the bigrams of the previous word cached, and that had to read
+    // them from the dictionary, since the creation of the map.
+    int getHitCount() const {
+        return mHitCount;
+    }
+
+    int getMissCount() const {
+        return mMissCount;
     }
 
  private:
     DISALLOW_COPY_AND_ASSIGN(MultiBigramMap);
 
+    // Bigram probabilities of one previous word, in an open addressing hash table by next word
+    // position.
     class BigramMap {
      public:
-        BigramMap() : mBigramMap(DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP) {}
+        BigramMap()
+                : mWordPosition(NOT_VALID_WORD), mNextWordPositions(), mProbabilities(),
+                  mMask(0) {}
         ~BigramMap() {}
 
-        void init(const uint8_t *const dicRoot, int position) {
-            BinaryFormat::fillBigramProbabilityToHashMap(dicRoot, position, &mBigramMap);
+        void init(const BigramIndex *const bigramIndex, const int wordPosition) {
+            mWordPosition = wordPosition;
+            const int *nextWordPositions = 0;
+            const uint8_t *probabilities = 0;
+            const int bigramCount =
+                    bigramIndex->getBigrams(wordPosition, &nextWordPositions, &probabilities);
+            initTable(bigramCount);
+            for (int i = 0; i < bigramCount; ++i) {
+                // The next word positions of the index are unique.
+                int j = getTableIndex(nextWordPositions[i]);
+                while (mNextWordPositions[j] != NOT_VALID_WORD) {
+                    j = (j + 1) & mMask;
+                }
+                mNextWordPositions[j] = nextWordPositions[i];
+                mProbabilities[j] = probabilities[i];
+            }
+        }
+
+        void init(const uint8_t *const dicRoot, const int wordPosition) {
+            mWordPosition = wordPosition;
+            const int bigramListPosition =
+                    BinaryFormat::getBigramListPositionForWordPosition(dicRoot, wordPosition);
+            int bigramCount = 0;
+            if (0 != bigramListPosition) {
+                int position = bigramListPosition;
+                uint8_t bigramFlags;
+                do {
+                    bigramFlags = BinaryFormat::getFlagsAndForwardPointer(dicRoot, &position);
+                    BinaryFormat::getAttributeAddressAndForwardPointer(dicRoot, bigramFlags,
+                            &position);
+                    ++bigramCount;
+                } while (BinaryFormat::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
+            }
+            initTable(bigramCount);
+            if (0 == bigramCount) {
+                return;
+            }
+            int position = bigramListPosition;
+            uint8_t bigramFlags;
+            do {
+                bigramFlags = BinaryFormat::getFlagsAndForwardPointer(dicRoot, &position);
+                const int bigramPos = BinaryFormat::getAttributeAddressAndForwardPointer(dicRoot,
+                        bigramFlags, &position);
+                int i = getTableIndex(bigramPos);
+                while (mNextWordPositions[i] != NOT_VALID_WORD
+                        && mNextWordPositions[i] != bigramPos) {
+                    i = (i + 1) & mMask;
+                }
+                mNextWordPositions[i] = bigramPos;
+                mProbabilities[i] = BinaryFormat::MASK_ATTRIBUTE_PROBABILITY & bigramFlags;
+            } while (BinaryFormat::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
         }
 
+        int getWordPosition() const {
+            return mWordPosition;
+        }
+
+        // This returns a probability in log space.
         inline int getBigramProbability(const int nextWordPosition, const int unigramProbability)
                 const {
-           return BinaryFormat::getBigramProbabilityFromHashMap(
-                   nextWordPosition, &mBigramMap, unigramProbability);
+            for (int i = getTableIndex(nextWordPosition); mNextWordPositions[i] != NOT_VALID_WORD;
+                    i = (i + 1) & mMask) {
+                if (mNextWordPositions[i] == nextWordPosition) {
+                    return BinaryFormat::computeProbabilityForBigram(unigramProbability,
+                            mProbabilities[i]);
+                }
+            }
+            return backoff(unigramProbability);
         }
 
      private:
-        // Note: Default copy constructor needed for use in hash_map.
-        hash_map_compat<int, int> mBigramMap;
+        static const int MIN_TABLE_SIZE = 16;
+
+        void initTable(const int bigramCount) {
+            // At least twice as many entries as bigrams, so that lookups of the next words
+            // without bigrams quickly reach an empty entry.
+            int tableSize = MIN_TABLE_SIZE;
+            while (tableSize < bigramCount * 2) {
+                tableSize *= 2;
+            }
+            mMask = tableSize - 1;
+            // assign() keeps the capacity of the vectors, which are reused after an eviction.
+            mNextWordPositions.assign(tableSize, NOT_VALID_WORD);
+            mProbabilities.resize(tableSize);
+        }
+
+        inline int getTableIndex(const int position) const {
+            return static_cast<int>((static_cast<uint32_t>(position) * 2654435761U) >> 16)
+                    & mMask;
+        }
+
+        // Note: Default copy constructor needed for use in std::vector.
+        int mWordPosition;
+        std::vector<int> mNextWordPositions;
+        std::vector<int> mProbabilities;
+        int mMask;
     };
 
-    void addBigramsForWordPosition(const uint8_t *const dicRoot, const int position) {
-        mBigramMaps[position].init(dicRoot, position);
+    static AK_FORCE_INLINE int getIndexTableIndex(const int wordPosition) {
+        return ((static_cast<uint32_t>(wordPosition) * 2654435761U) >> 16)
+                & (BIGRAM_MAP_INDEX_TABLE_SIZE - 1);
+    }
+
+    // Returns the index of the bigram map of wordPosition, or NOT_AN_INDEX if it isn't cached.
+    AK_FORCE_INLINE int findIndex(const int wordPosition) const {
+        for (int i = getIndexTableIndex(wordPosition); mIndexTable[i] != NOT_AN_INDEX;
+                i = (i + 1) & (BIGRAM_MAP_INDEX_TABLE_SIZE - 1)) {
+            if (mBigramMaps[mIndexTable[i]].getWordPosition() == wordPosition) {
+                return mIndexTable[i];
+            }
+        }
+        return NOT_AN_INDEX;
+    }
+
+    // Caches the bigrams of wordPosition, evicting the least recently used bigram map if all of
+    // them are used, and returns the index of the new bigram map.
+    int addBigramsForWordPosition(const uint8_t *const dicRoot, const int wordPosition) {
+        int index;
+        if (mUsedCount < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP) {
+            index = mUsedCount++;
+        } else {
+            index = mLeastRecentlyUsedIndex;
+            removeIndex(index);
+            unlink(index);
+        }
+        if (mBigramIndex) {
+            mBigramMaps[index].init(mBigramIndex, wordPosition);
+        } else {
+            mBigramMaps[index].init(dicRoot, wordPosition);
+        }
+        int i = getIndexTableIndex(wordPosition);
+        while (mIndexTable[i] != NOT_AN_INDEX) {
+            i = (i + 1) & (BIGRAM_MAP_INDEX_TABLE_SIZE - 1);
+        }
+        mIndexTable[i] = index;
+        return index;
+    }
+
+    // Removes the entry of the bigram map at index from the index table, moving back the entries
+    // after it in its probe sequence so that no tombstone is needed.
+    void removeIndex(const int index) {
+        int i = getIndexTableIndex(mBigramMaps[index].getWordPosition());
+        while (mIndexTable[i] != index) {
+            i = (i + 1) & (BIGRAM_MAP_INDEX_TABLE_SIZE - 1);
+        }
+        int j = i;
+        while (true) {
+            j = (j + 1) & (BIGRAM_MAP_INDEX_TABLE_SIZE - 1);
+            if (mIndexTable[j] == NOT_AN_INDEX) {
+                break;
+            }
+            const int home = getIndexTableIndex(mBigramMaps[mIndexTable[j]].getWordPosition());
+            // The entry at j can fill the hole at i unless its home is cyclically in (i, j].
+            const bool isHomeInRange = (i <= j) ? (i < home && home <= j)
+                    : (i < home || home <= j);
+            if (!isHomeInRange) {
+                mIndexTable[i] = mIndexTable[j];
+                i = j;
+            }
+        }
+        mIndexTable[i] = NOT_AN_INDEX;
+    }
+
+    // Moves the bigram map at index to the head of the recency list.
+    AK_FORCE_INLINE void setMostRecentlyUsed(const int index) {
+        if (index == mMostRecentlyUsedIndex) {
+            return;
+        }
+        if (mPreviousIndices[index] != NOT_AN_INDEX) {
+            // Any listed bigram map but the most recently used one has a previous one.
+            unlink(index);
+        }
+        mPreviousIndices[index] = NOT_AN_INDEX;
+        mNextIndices[index] = mMostRecentlyUsedIndex;
+        if (mMostRecentlyUsedIndex != NOT_AN_INDEX) {
+            mPreviousIndices[mMostRecentlyUsedIndex] = index;
+        }
+        mMostRecentlyUsedIndex = index;
+        if (mLeastRecentlyUsedIndex == NOT_AN_INDEX) {
+            mLeastRecentlyUsedIndex = index;
+        }
+    }
+
+    // Removes the bigram map at index from the recency list.
+    AK_FORCE_INLINE void unlink(const int index) {
+        const int previousIndex = mPreviousIndices[index];
+        const int nextIndex = mNextIndices[index];
+        if (previousIndex != NOT_AN_INDEX) {
+            mNextIndices[previousIndex] = nextIndex;
+        } else {
+            mMostRecentlyUsedIndex = nextIndex;
+        }
+        if (nextIndex != NOT_AN_INDEX) {
+            mPreviousIndices[nextIndex] = previousIndex;
+        } else {
+            mLeastRecentlyUsedIndex = previousIndex;
+        }
+        mPreviousIndices[index] = NOT_AN_INDEX;
+        mNextIndices[index] = NOT_AN_INDEX;
     }
 
-    hash_map_compat<int, BigramMap> mBigramMaps;
+    const BigramIndex *mBigramIndex;
+    std::vector<BigramMap> mBigramMaps;
+    int mUsedCount;
+    // Index in mBigramMaps of the bigram maps by previous word position
+    int mIndexTable[BIGRAM_MAP_INDEX_TABLE_SIZE];
+    // Recency list of the used bigram maps, from the most recently used one.
+    int mPreviousIndices[MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP];
+    int mNextIndices[MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP];
+    int mMostRecentlyUsedIndex;
+    int mLeastRecentlyUsedIndex;
+    int mHitCount;
+    int mMissCount;
 };
 } // namespace latinime
 #endif // LATINIME_MULTI_BIGRAM_MAP_H
@@ -71,6 +71,9 @@ ProximityInfo::ProximityInfo(JNIEnv *env, const jstring localeJStr,
           mProximityCharsArray(new int[GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE
                   /* proximityCharsLength */]),
           mCodeToKeyMap() {
+    for (int c = 0; c < KEY_INDEX_CACHE_SIZE; ++c) {
+        mCachedKeyIndices[c] = NOT_AN_INDEX;
+    }
     /* Let's check the input array length here to make sure */
     const jsize proximityCharsLength = env->GetArrayLength(proximityChars);
     if (proximityCharsLength != GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE) {
@@ -153,13 +156,6 @@ float ProximityInfo::getNormalizedSquaredDistanceFromCenterFloatG(
             / SQUARE_FLOAT(keyWidth);
 }
 
-int ProximityInfo::getCodePointOf(const int keyIndex) const {
-    if (keyIndex < 0 || keyIndex >= KEY_COUNT) {
-        return NOT_A_CODE_POINT;
-    }
-    return mKeyIndexToCodePointG[keyIndex];
-}
-
 void ProximityInfo::initializeG() {
     // TODO: Optimize
     for (int i = 0; i < KEY_COUNT; ++i) {
@@ -170,6 +166,9 @@ void ProximityInfo::initializeG() {
         mCodeToKeyMap[lowerCode] = i;
         mKeyIndexToCodePointG[i] = lowerCode;
     }
+    for (int c = 0; c < KEY_INDEX_CACHE_SIZE; ++c) {
+        mCachedKeyIndices[c] = ProximityInfoUtils::getKeyIndexOf(KEY_COUNT, c, &mCodeToKeyMap);
+    }
     for (int i = 0; i < KEY_COUNT; i++) {
         mKeyKeyDistancesG[i][i] = 0;
         for (int j = i + 1; j < KEY_COUNT; j++) {
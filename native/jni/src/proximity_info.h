@@ -42,7 +42,14 @@ class ProximityInfo {
             const int keyId, const int x, const int y,
             const float verticalScale) const;
     bool sameAsTyped(const unsigned short *word, int length) const;
-    int getCodePointOf(const int keyIndex) const;
+
+    AK_FORCE_INLINE int getCodePointOf(const int keyIndex) const {
+        if (keyIndex < 0 || keyIndex >= KEY_COUNT) {
+            return NOT_A_CODE_POINT;
+        }
+        return mKeyIndexToCodePointG[keyIndex];
+    }
+
     bool hasSweetSpotData(const int keyIndex) const {
         // When there are no calibration data for a key,
         // the radius of the key is assigned to zero.
@@ -84,6 +91,9 @@ class ProximityInfo {
     }
 
     AK_FORCE_INLINE int getKeyIndexOf(const int c) const {
+        if (c >= 0 && c < KEY_INDEX_CACHE_SIZE) {
+            return mCachedKeyIndices[c];
+        }
         return ProximityInfoUtils::getKeyIndexOf(KEY_COUNT, c, &mCodeToKeyMap);
     }
 
@@ -94,6 +104,10 @@ class ProximityInfo {
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(ProximityInfo);
 
+    // The key indices of the Latin-1 code points are looked up in an array instead of lower casing
+    // them and searching the map.
+    static const int KEY_INDEX_CACHE_SIZE = 256;
+
     void initializeG();
     float calculateNormalizedSquaredDistance(const int keyIndex, const int inputIndex) const;
     bool hasInputCoordinates() const;
@@ -122,6 +136,7 @@ class ProximityInfo {
     float mSweetSpotCenterYs[MAX_KEY_COUNT_IN_A_KEYBOARD];
     float mSweetSpotRadii[MAX_KEY_COUNT_IN_A_KEYBOARD];
     hash_map_compat<int, int> mCodeToKeyMap;
+    int mCachedKeyIndices[KEY_INDEX_CACHE_SIZE];
 
     int mKeyIndexToCodePointG[MAX_KEY_COUNT_IN_A_KEYBOARD];
     int mCenterXsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
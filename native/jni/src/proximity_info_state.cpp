@@ -25,6 +25,7 @@
 #include "proximity_info.h"
 #include "proximity_info_state.h"
 #include "proximity_info_state_utils.h"
+#include "proximity_row_matcher.h"
 
 namespace latinime {
 
@@ -32,17 +33,40 @@ namespace latinime {
 void ProximityInfoState::initInputParams(const int pointerId, const float maxPointToKeyLength,
         const ProximityInfo *proximityInfo, const int *const inputCodes, const int inputSize,
         const int *const xCoordinates, const int *const yCoordinates, const int *const times,
-        const int *const pointerIds, const bool isGeometric) {
+        const int *const pointerIds, const bool isGeometric,
+        const int knownSharedInputPrefixLength) {
     ASSERT(isGeometric || (inputSize < MAX_WORD_LENGTH));
-    mIsContinuousSuggestionPossible =
-            ProximityInfoStateUtils::checkAndReturnIsContinuousSuggestionPossible(
-                    inputSize, xCoordinates, yCoordinates, times, mSampledInputSize,
-                    &mSampledInputXs, &mSampledInputYs, &mSampledTimes, &mSampledInputIndice);
+    ASSERT(knownSharedInputPrefixLength == NOT_AN_INDEX || (xCoordinates && yCoordinates));
+    // The sampled points of the previous input were measured against the keys of its keyboard,
+    // so none of them is reused after a keyboard switch.
+    if (proximityInfo != mProximityInfo) {
+        mSharedInputPrefixLength = 0;
+        mIsContinuousSuggestionPossible = false;
+    } else if (knownSharedInputPrefixLength != NOT_AN_INDEX) {
+        mSharedInputPrefixLength = ProximityInfoStateUtils::getKnownSharedInputPrefixLength(
+                knownSharedInputPrefixLength, mSampledInputSize, &mSampledInputIndice);
+        mIsContinuousSuggestionPossible =
+                ProximityInfoStateUtils::isContinuousSuggestionPossibleWithKnownPrefix(
+                        knownSharedInputPrefixLength, mSampledInputSize, &mSampledInputIndice);
+    } else {
+        mSharedInputPrefixLength = ProximityInfoStateUtils::getSharedInputPrefixLength(inputSize,
+                xCoordinates, yCoordinates, times, mSampledInputSize, &mSampledInputXs,
+                &mSampledInputYs, &mSampledTimes, &mSampledInputIndice);
+        mIsContinuousSuggestionPossible =
+                ProximityInfoStateUtils::checkAndReturnIsContinuousSuggestionPossible(
+                        inputSize, xCoordinates, yCoordinates, times, mSampledInputSize,
+                        &mSampledInputXs, &mSampledInputYs, &mSampledTimes, &mSampledInputIndice);
+    }
     if (DEBUG_DICT) {
         AKLOGI("isContinuousSuggestionPossible = %s",
                 (mIsContinuousSuggestionPossible ? "true" : "false"));
     }
 
+    // The proximities of the points known to be the same are kept if the previous input was typed
+    // on the same keyboard, as they were computed for all its points.
+    const int reusedProximitiesSize = (!isGeometric && pointerId == 0
+            && knownSharedInputPrefixLength != NOT_AN_INDEX && proximityInfo == mProximityInfo)
+            ? min(knownSharedInputPrefixLength, mKeyProximityTypesInputSize) : 0;
     mProximityInfo = proximityInfo;
     mHasTouchPositionCorrectionData = proximityInfo->hasTouchPositionCorrectionData();
     mMostCommonKeyWidthSquare = proximityInfo->getMostCommonKeyWidthSquare();
@@ -52,11 +76,15 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
     mGridHeight = proximityInfo->getGridWidth();
     mGridWidth = proximityInfo->getGridHeight();
 
-    memset(mInputProximities, 0, sizeof(mInputProximities));
+    const int reusedProximityCount = reusedProximitiesSize * MAX_PROXIMITY_CHARS_SIZE;
+    memset(mInputProximities + reusedProximityCount, 0,
+            sizeof(mInputProximities) - reusedProximityCount * sizeof(mInputProximities[0]));
+    mKeyProximityTypesInputSize = 0;
 
     if (!isGeometric && pointerId == 0) {
-        mProximityInfo->initializeProximities(inputCodes, xCoordinates, yCoordinates,
-                inputSize, mInputProximities);
+        mProximityInfo->initializeProximities(inputCodes + reusedProximitiesSize,
+                xCoordinates + reusedProximitiesSize, yCoordinates + reusedProximitiesSize,
+                inputSize - reusedProximitiesSize, mInputProximities + reusedProximityCount);
     }
 
     ///////////////////////
@@ -152,13 +180,23 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
     mTouchPositionCorrectionEnabled = mSampledInputSize > 0 && mHasTouchPositionCorrectionData
             && xCoordinates && yCoordinates;
     if (!isGeometric && pointerId == 0) {
+        // Points without coordinates are told apart by their code points only.
+        int previousPrimaryInputWord[MAX_WORD_LENGTH];
+        memcpy(previousPrimaryInputWord, mPrimaryInputWord, sizeof(previousPrimaryInputWord));
         ProximityInfoStateUtils::initPrimaryInputWord(
                 inputSize, mInputProximities, mPrimaryInputWord);
+        for (int i = 0; i < mSharedInputPrefixLength; ++i) {
+            if (mPrimaryInputWord[i] != previousPrimaryInputWord[i]) {
+                mSharedInputPrefixLength = i;
+                break;
+            }
+        }
         if (mTouchPositionCorrectionEnabled) {
             ProximityInfoStateUtils::initNormalizedSquaredDistances(
                     mProximityInfo, inputSize, xCoordinates, yCoordinates, mInputProximities,
                     &mSampledInputXs, &mSampledInputYs, mNormalizedSquaredDistances);
         }
+        initKeyProximityTypes(reusedProximitiesSize, inputSize);
     }
     if (DEBUG_GEO_FULL) {
         AKLOGI("ProximityState init finished: %d points out of %d", mSampledInputSize, inputSize);
@@ -198,8 +236,8 @@ float ProximityInfoState::getPointToKeyByIdLength(
 // Notice : accented characters do not have a proximity list, so they are alone in their list. The
 // non-accented version of the character should be considered "close", but not the other keys close
 // to the non-accented version.
-ProximityType ProximityInfoState::getProximityType(const int index, const int codePoint,
-        const bool checkProximityChars, int *proximityIndex) const {
+ProximityType ProximityInfoState::getProximityTypeFromProximityCodePoints(const int index,
+        const int codePoint, const bool checkProximityChars, int *proximityIndex) const {
     const int *currentCodePoints = getProximityCodePointsAt(index);
     const int firstCodePoint = currentCodePoints[0];
     const int baseLowerC = toBaseLowerCase(codePoint);
@@ -219,37 +257,44 @@ ProximityType ProximityInfoState::getProximityType(const int index, const int co
     }
 
     // Not an exact nor an accent-alike match: search the list of close keys
-    int j = 1;
-    while (j < MAX_PROXIMITY_CHARS_SIZE
-            && currentCodePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
-        const bool matched = (currentCodePoints[j] == baseLowerC
-                || currentCodePoints[j] == codePoint);
-        if (matched) {
-            if (proximityIndex) {
-                *proximityIndex = j;
-            }
-            return PROXIMITY_CHAR;
+    return ProximityRowMatcher::getCloseKeyProximityType(currentCodePoints, codePoint, baseLowerC,
+            proximityIndex);
+}
+
+// Computes once per input the proximity types that getProximityType() returns for the code points
+// of the keys, so that classifying a child of the typing traversal is a table lookup. The types of
+// the input indices before startIndex are kept from the previous input.
+void ProximityInfoState::initKeyProximityTypes(const int startIndex, const int inputSize) {
+    const int keyCount = mProximityInfo->getKeyCount();
+    for (int i = startIndex; i < inputSize; ++i) {
+        int8_t *const keyProximityTypes = mKeyProximityTypes + i * MAX_KEY_COUNT_IN_A_KEYBOARD;
+        for (int keyId = 0; keyId < keyCount; ++keyId) {
+            const ProximityType proximityType = getProximityTypeFromProximityCodePoints(i,
+                    mProximityInfo->getCodePointOf(keyId), true /* checkProximityChars */,
+                    0 /* proximityIndex */);
+            keyProximityTypes[keyId] = static_cast<int8_t>(proximityType);
         }
-        ++j;
     }
-    if (j < MAX_PROXIMITY_CHARS_SIZE
-            && currentCodePoints[j] == ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
-        ++j;
-        while (j < MAX_PROXIMITY_CHARS_SIZE
-                && currentCodePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
-            const bool matched = (currentCodePoints[j] == baseLowerC
-                    || currentCodePoints[j] == codePoint);
-            if (matched) {
-                if (proximityIndex) {
-                    *proximityIndex = j;
-                }
-                return ADDITIONAL_PROXIMITY_CHAR;
-            }
-            ++j;
+    mKeyProximityTypesInputSize = inputSize;
+}
+
+// A code point c is close if the typed code point or one of the close keys is c or its base lower
+// case, so c is in base lower case one of these or the base lower case of one of these.
+int ProximityInfoState::getProximityBaseLowerCodePoints(const int index,
+        int *const outCodePoints) const {
+    const int *currentCodePoints = getProximityCodePointsAt(index);
+    int count = 0;
+    outCodePoints[count++] = toBaseLowerCase(currentCodePoints[0]);
+    for (int j = 1; j < MAX_PROXIMITY_CHARS_SIZE; ++j) {
+        if (currentCodePoints[j] == ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) continue;
+        if (currentCodePoints[j] <= ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) break;
+        outCodePoints[count++] = currentCodePoints[j];
+        const int baseLowerCodePoint = toBaseLowerCase(currentCodePoints[j]);
+        if (baseLowerCodePoint != currentCodePoints[j]) {
+            outCodePoints[count++] = baseLowerCodePoint;
         }
     }
-    // Was not included, signal this as a substitution character.
-    return SUBSTITUTION_CHAR;
+    return count;
 }
 
 ProximityType ProximityInfoState::getProximityTypeG(const int index, const int codePoint) const {
@@ -18,18 +18,19 @@
 #define LATINIME_PROXIMITY_INFO_STATE_H
 
 #include <cstring> // for memset()
+#include <stdint.h>
 #include <vector>
 
 #include "char_utils.h"
 #include "defines.h"
 #include "hash_map_compat.h"
+#include "proximity_info.h"
 #include "proximity_info_params.h"
 #include "proximity_info_state_utils.h"
+#include "proximity_row_matcher.h"
 
 namespace latinime {
 
-class ProximityInfo;
-
 class ProximityInfoState {
  public:
     /////////////////////////////////////////
@@ -38,7 +39,8 @@ class ProximityInfoState {
     void initInputParams(const int pointerId, const float maxPointToKeyLength,
             const ProximityInfo *proximityInfo, const int *const inputCodes,
             const int inputSize, const int *xCoordinates, const int *yCoordinates,
-            const int *const times, const int *const pointerIds, const bool isGeometric);
+            const int *const times, const int *const pointerIds, const bool isGeometric,
+            const int knownSharedInputPrefixLength);
 
     /////////////////////////////////////////
     // Defined here                        //
@@ -47,16 +49,19 @@ class ProximityInfoState {
             : mProximityInfo(0), mMaxPointToKeyLength(0.0f), mAverageSpeed(0.0f),
               mHasTouchPositionCorrectionData(false), mMostCommonKeyWidthSquare(0),
               mKeyCount(0), mCellHeight(0), mCellWidth(0), mGridHeight(0), mGridWidth(0),
-              mIsContinuousSuggestionPossible(false), mSampledInputXs(), mSampledInputYs(),
+              mIsContinuousSuggestionPossible(false), mSharedInputPrefixLength(0),
+              mSampledInputXs(), mSampledInputYs(),
               mSampledTimes(), mSampledInputIndice(), mSampledLengthCache(),
               mBeelineSpeedPercentiles(), mSampledNormalizedSquaredLengthCache(), mSpeedRates(),
               mDirections(), mCharProbabilities(), mSampledNearKeySets(), mSampledSearchKeySets(),
               mSampledSearchKeyVectors(), mTouchPositionCorrectionEnabled(false),
-              mSampledInputSize(0), mMostProbableStringProbability(0.0f) {
+              mSampledInputSize(0), mMostProbableStringProbability(0.0f),
+              mKeyProximityTypesInputSize(0) {
         memset(mInputProximities, 0, sizeof(mInputProximities));
         memset(mNormalizedSquaredDistances, 0, sizeof(mNormalizedSquaredDistances));
         memset(mPrimaryInputWord, 0, sizeof(mPrimaryInputWord));
         memset(mMostProbableString, 0, sizeof(mMostProbableString));
+        memset(mKeyProximityTypes, 0, sizeof(mKeyProximityTypes));
     }
 
     // Non virtual inline destructor -- never inherit this class
@@ -82,14 +87,7 @@ class ProximityInfoState {
     }
 
     AK_FORCE_INLINE bool existsCodePointInProximityAt(const int index, const int c) const {
-        const int *codePoints = getProximityCodePointsAt(index);
-        int i = 0;
-        while (codePoints[i] > 0 && i < MAX_PROXIMITY_CHARS_SIZE) {
-            if (codePoints[i++] == c) {
-                return true;
-            }
-        }
-        return false;
+        return ProximityRowMatcher::containsCodePoint(getProximityCodePointsAt(index), c);
     }
 
     inline bool existsAdjacentProximityChars(const int index) const {
@@ -147,13 +145,39 @@ class ProximityInfoState {
         return mIsContinuousSuggestionPossible;
     }
 
+    // Returns the number of leading input points, with their code points, that are the same as
+    // in the previous input.
+    int getSharedInputPrefixLength() const {
+        return mSharedInputPrefixLength;
+    }
+
     // TODO: Rename s/Length/NormalizedSquaredLength/
     float getPointToKeyByIdLength(const int inputIndex, const int keyId) const;
     // TODO: Rename s/Length/NormalizedSquaredLength/
     float getPointToKeyLength(const int inputIndex, const int codePoint) const;
 
-    ProximityType getProximityType(const int index, const int codePoint,
-            const bool checkProximityChars, int *proximityIndex = 0) const;
+    // The code points of the keys are looked up in the table of the proximity types of the keys,
+    // which the typing traversal classifies most of its children with.
+    AK_FORCE_INLINE ProximityType getProximityType(const int index, const int codePoint,
+            const bool checkProximityChars, int *proximityIndex = 0) const {
+        if (!proximityIndex && index >= 0 && index < mKeyProximityTypesInputSize) {
+            const int keyId = mProximityInfo->getKeyIndexOf(codePoint);
+            if (keyId != NOT_AN_INDEX && mProximityInfo->getCodePointOf(keyId) == codePoint) {
+                const ProximityType proximityType = static_cast<ProximityType>(
+                        mKeyProximityTypes[index * MAX_KEY_COUNT_IN_A_KEYBOARD + keyId]);
+                return (checkProximityChars || proximityType == MATCH_CHAR)
+                        ? proximityType : SUBSTITUTION_CHAR;
+            }
+        }
+        return getProximityTypeFromProximityCodePoints(index, codePoint, checkProximityChars,
+                proximityIndex);
+    }
+
+    // Writes to outCodePoints the code points in base lower case of all the code points that
+    // getProximityType() may find close at index, and returns their count, which is at most
+    // MAX_PROXIMITY_BASE_LOWER_CODE_POINTS. Some of them may not be close.
+    int getProximityBaseLowerCodePoints(const int index, int *const outCodePoints) const;
+    static const int MAX_PROXIMITY_BASE_LOWER_CODE_POINTS = 2 * MAX_PROXIMITY_CHARS_SIZE;
 
     ProximityType getProximityTypeG(const int index, const int codePoint) const;
 
@@ -206,6 +230,10 @@ class ProximityInfoState {
     float calculateSquaredDistanceFromSweetSpotCenter(
             const int keyIndex, const int inputIndex) const;
 
+    ProximityType getProximityTypeFromProximityCodePoints(const int index, const int codePoint,
+            const bool checkProximityChars, int *proximityIndex) const;
+    void initKeyProximityTypes(const int startIndex, const int inputSize);
+
     /////////////////////////////////////////
     // Defined here                        //
     /////////////////////////////////////////
@@ -226,6 +254,7 @@ class ProximityInfoState {
     int mGridHeight;
     int mGridWidth;
     bool mIsContinuousSuggestionPossible;
+    int mSharedInputPrefixLength;
 
     std::vector<int> mSampledInputXs;
     std::vector<int> mSampledInputYs;
@@ -255,6 +284,10 @@ class ProximityInfoState {
     int mPrimaryInputWord[MAX_WORD_LENGTH];
     float mMostProbableStringProbability;
     int mMostProbableString[MAX_WORD_LENGTH];
+    // The proximity types of the code points of the keys, by input index then key index, for the
+    // first mKeyProximityTypesInputSize input indices.
+    int mKeyProximityTypesInputSize;
+    int8_t mKeyProximityTypes[MAX_WORD_LENGTH * MAX_KEY_COUNT_IN_A_KEYBOARD];
 };
 } // namespace latinime
 #endif // LATINIME_PROXIMITY_INFO_STATE_H
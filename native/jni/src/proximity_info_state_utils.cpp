@@ -1005,6 +1005,58 @@ namespace latinime {
     return true;
 }
 
+// Returns the number of leading input points that were all sampled at the same positions and
+// times by the previous input.
+/* static */ int ProximityInfoStateUtils::getSharedInputPrefixLength(const int inputSize,
+        const int *const xCoordinates, const int *const yCoordinates, const int *const times,
+        const int sampledInputSize, const std::vector<int> *const sampledInputXs,
+        const std::vector<int> *const sampledInputYs, const std::vector<int> *const sampledTimes,
+        const std::vector<int> *const sampledInputIndices) {
+    if (!xCoordinates || !yCoordinates) {
+        return 0;
+    }
+    const int maxLength = min(inputSize, sampledInputSize);
+    for (int i = 0; i < maxLength; ++i) {
+        if ((*sampledInputIndices)[i] != i) {
+            // The previous input skipped a point.
+            return i;
+        }
+        if (xCoordinates[i] != (*sampledInputXs)[i] || yCoordinates[i] != (*sampledInputYs)[i]) {
+            return i;
+        }
+        if (times && times[i] != (*sampledTimes)[i]) {
+            return i;
+        }
+    }
+    return maxLength;
+}
+
+// Same as checkAndReturnIsContinuousSuggestionPossible() for an input whose first
+// knownSharedInputPrefixLength points are known to be the same as in the previous input: the
+// previous input must only have sampled these points.
+/* static */ bool ProximityInfoStateUtils::isContinuousSuggestionPossibleWithKnownPrefix(
+        const int knownSharedInputPrefixLength, const int sampledInputSize,
+        const std::vector<int> *const sampledInputIndices) {
+    return sampledInputSize == 0
+            || (*sampledInputIndices)[sampledInputSize - 1] < knownSharedInputPrefixLength;
+}
+
+// Same as getSharedInputPrefixLength() for an input whose first knownSharedInputPrefixLength
+// points are known to be the same as in the previous input, so only the skipped points are
+// looked for.
+/* static */ int ProximityInfoStateUtils::getKnownSharedInputPrefixLength(
+        const int knownSharedInputPrefixLength, const int sampledInputSize,
+        const std::vector<int> *const sampledInputIndices) {
+    const int maxLength = min(knownSharedInputPrefixLength, sampledInputSize);
+    for (int i = 0; i < maxLength; ++i) {
+        if ((*sampledInputIndices)[i] != i) {
+            // The previous input skipped a point.
+            return i;
+        }
+    }
+    return maxLength;
+}
+
 // Get a word that is detected by tracing the most probable string into codePointBuf and
 // returns probability of generating the word.
 /* static */ float ProximityInfoStateUtils::getMostProbableString(
@@ -109,6 +109,17 @@ class ProximityInfoStateUtils {
             const std::vector<int> *const sampledInputYs,
             const std::vector<int> *const sampledTimes,
             const std::vector<int> *const sampledInputIndices);
+    static int getSharedInputPrefixLength(const int inputSize, const int *const xCoordinates,
+            const int *const yCoordinates, const int *const times, const int sampledInputSize,
+            const std::vector<int> *const sampledInputXs,
+            const std::vector<int> *const sampledInputYs,
+            const std::vector<int> *const sampledTimes,
+            const std::vector<int> *const sampledInputIndices);
+    static bool isContinuousSuggestionPossibleWithKnownPrefix(
+            const int knownSharedInputPrefixLength, const int sampledInputSize,
+            const std::vector<int> *const sampledInputIndices);
+    static int getKnownSharedInputPrefixLength(const int knownSharedInputPrefixLength,
+            const int sampledInputSize, const std::vector<int> *const sampledInputIndices);
     // TODO: Move to most_probable_string_utils.h
     static float getMostProbableString(const ProximityInfo *const proximityInfo,
             const int sampledInputSize,
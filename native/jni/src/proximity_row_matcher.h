@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_PROXIMITY_ROW_MATCHER_H
+#define LATINIME_PROXIMITY_ROW_MATCHER_H
+
+#include <stdint.h>
+
+#include "defines.h"
+
+// The vector units are only used when the compiler targets them: NEON is optional on ARMv7, so
+// ARM builds without -mfpu=neon use the scalar code.
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LATINIME_PROXIMITY_ROW_MATCHER_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LATINIME_PROXIMITY_ROW_MATCHER_SSE2
+#endif
+
+#if defined(LATINIME_PROXIMITY_ROW_MATCHER_NEON) || defined(LATINIME_PROXIMITY_ROW_MATCHER_SSE2)
+#if MAX_PROXIMITY_CHARS_SIZE != 16
+#error "The vector code of ProximityRowMatcher only handles rows of 16 code points"
+#endif
+#endif
+
+namespace latinime {
+
+/**
+ * Searches the proximity row of an input index, that is its MAX_PROXIMITY_CHARS_SIZE proximity
+ * code points: the typed code point, the close keys, then optionally the delimiter and the
+ * additional proximity chars, ended by a code point not above the delimiter. With a vector unit,
+ * the code point is compared with the whole row at once instead of one slot after the other. The
+ * vector code assumes rows of 16 code points, which fit the bits of a mask.
+ */
+class ProximityRowMatcher {
+ public:
+    // Returns the proximity type of codePoint, whose base lower case is baseLowerCodePoint, among
+    // the close keys and the additional proximity chars of row, like the end of
+    // ProximityInfoState::getProximityType(). Sets proximityIndex, if any, to the index of the
+    // matching slot.
+    static AK_FORCE_INLINE ProximityType getCloseKeyProximityType(const int *const row,
+            const int codePoint, const int baseLowerCodePoint, int *const proximityIndex) {
+#if defined(LATINIME_PROXIMITY_ROW_MATCHER_NEON) || defined(LATINIME_PROXIMITY_ROW_MATCHER_SSE2)
+        return getCloseKeyProximityTypeWithMasks(row, codePoint, baseLowerCodePoint,
+                proximityIndex);
+#else
+        return getCloseKeyProximityTypeScalar(row, codePoint, baseLowerCodePoint,
+                proximityIndex);
+#endif
+    }
+
+    // Returns whether codePoint is in row before its first code point not above 0.
+    static AK_FORCE_INLINE bool containsCodePoint(const int *const row, const int codePoint) {
+#if defined(LATINIME_PROXIMITY_ROW_MATCHER_NEON) || defined(LATINIME_PROXIMITY_ROW_MATCHER_SSE2)
+        const int matchMask = getMatchMask(row, codePoint, codePoint);
+        return (matchMask & getLowerBitsMask(getAtMostMask(row, 0))) != 0;
+#else
+        return containsCodePointScalar(row, codePoint);
+#endif
+    }
+
+    static AK_FORCE_INLINE ProximityType getCloseKeyProximityTypeScalar(const int *const row,
+            const int codePoint, const int baseLowerCodePoint, int *const proximityIndex) {
+        int j = 1;
+        while (j < MAX_PROXIMITY_CHARS_SIZE
+                && row[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+            if (row[j] == baseLowerCodePoint || row[j] == codePoint) {
+                if (proximityIndex) {
+                    *proximityIndex = j;
+                }
+                return PROXIMITY_CHAR;
+            }
+            ++j;
+        }
+        if (j < MAX_PROXIMITY_CHARS_SIZE && row[j] == ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+            ++j;
+            while (j < MAX_PROXIMITY_CHARS_SIZE
+                    && row[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+                if (row[j] == baseLowerCodePoint || row[j] == codePoint) {
+                    if (proximityIndex) {
+                        *proximityIndex = j;
+                    }
+                    return ADDITIONAL_PROXIMITY_CHAR;
+                }
+                ++j;
+            }
+        }
+        return SUBSTITUTION_CHAR;
+    }
+
+    static AK_FORCE_INLINE bool containsCodePointScalar(const int *const row,
+            const int codePoint) {
+        for (int i = 0; i < MAX_PROXIMITY_CHARS_SIZE && row[i] > 0; ++i) {
+            if (row[i] == codePoint) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(ProximityRowMatcher);
+
+    // Returns the mask of the bits below the lowest bit set in mask, or of all the bits if mask
+    // is 0.
+    static AK_FORCE_INLINE int getLowerBitsMask(const int mask) {
+        return (mask & -mask) - 1;
+    }
+
+    // Returns the index of the lowest bit set in mask, which must not be 0.
+    static AK_FORCE_INLINE int getLowestBitIndex(const int mask) {
+        // De Bruijn sequence lookup of the isolated lowest bit.
+        static const int INDICES[32] = {
+            0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+            31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+        };
+        const uint32_t lowestBit = static_cast<uint32_t>(mask & -mask);
+        return INDICES[(lowestBit * 0x077CB531U) >> 27];
+    }
+
+#if defined(LATINIME_PROXIMITY_ROW_MATCHER_NEON) || defined(LATINIME_PROXIMITY_ROW_MATCHER_SSE2)
+    static AK_FORCE_INLINE ProximityType getCloseKeyProximityTypeWithMasks(const int *const row,
+            const int codePoint, const int baseLowerCodePoint, int *const proximityIndex) {
+        // Slot 0 is the typed code point, which is checked by the caller. Most code points don't
+        // match at all, so the end of the row is only looked for when they do.
+        int matchMask = getMatchMask(row, codePoint, baseLowerCodePoint) & ~1;
+        if (!matchMask) {
+            return SUBSTITUTION_CHAR;
+        }
+        const int endMask = getAtMostMask(row, ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) & ~1;
+        matchMask &= ~endMask;
+        if (!matchMask) {
+            return SUBSTITUTION_CHAR;
+        }
+        const int closeKeysMask = getLowerBitsMask(endMask);
+        ProximityType proximityType = PROXIMITY_CHAR;
+        if (!(matchMask & closeKeysMask)) {
+            // endMask isn't 0, or the match would be among the close keys.
+            const int end = getLowestBitIndex(endMask);
+            if (row[end] != ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+                return SUBSTITUTION_CHAR;
+            }
+            const int additionalProximityCharsMask =
+                    getLowerBitsMask(endMask & ~(closeKeysMask | (1 << end)));
+            if (!(matchMask & additionalProximityCharsMask)) {
+                return SUBSTITUTION_CHAR;
+            }
+            proximityType = ADDITIONAL_PROXIMITY_CHAR;
+        }
+        if (proximityIndex) {
+            *proximityIndex = getLowestBitIndex(matchMask);
+        }
+        return proximityType;
+    }
+#endif
+
+#if defined(LATINIME_PROXIMITY_ROW_MATCHER_NEON)
+    // Returns the mask of the slots of row equal to codePoint0 or codePoint1.
+    static AK_FORCE_INLINE int getMatchMask(const int *const row, const int codePoint0,
+            const int codePoint1) {
+        const int32x4_t codePoints0 = vdupq_n_s32(codePoint0);
+        const int32x4_t codePoints1 = vdupq_n_s32(codePoint1);
+        uint16x8_t masks[2];
+        for (int i = 0; i < 2; ++i) {
+            const int32x4_t low = vld1q_s32(row + i * 8);
+            const int32x4_t high = vld1q_s32(row + i * 8 + 4);
+            const uint32x4_t lowMatches =
+                    vorrq_u32(vceqq_s32(low, codePoints0), vceqq_s32(low, codePoints1));
+            const uint32x4_t highMatches =
+                    vorrq_u32(vceqq_s32(high, codePoints0), vceqq_s32(high, codePoints1));
+            masks[i] = vcombine_u16(vmovn_u32(lowMatches), vmovn_u32(highMatches));
+        }
+        return getMask(masks[0], masks[1]);
+    }
+
+    // Returns the mask of the slots of row whose code point is at most maxCodePoint.
+    static AK_FORCE_INLINE int getAtMostMask(const int *const row, const int maxCodePoint) {
+        const int32x4_t maxCodePoints = vdupq_n_s32(maxCodePoint);
+        uint16x8_t masks[2];
+        for (int i = 0; i < 2; ++i) {
+            const uint32x4_t low = vcleq_s32(vld1q_s32(row + i * 8), maxCodePoints);
+            const uint32x4_t high = vcleq_s32(vld1q_s32(row + i * 8 + 4), maxCodePoints);
+            masks[i] = vcombine_u16(vmovn_u32(low), vmovn_u32(high));
+        }
+        return getMask(masks[0], masks[1]);
+    }
+
+    // Packs the all-ones or all-zeros lanes of the two vectors into the bits of a mask.
+    static AK_FORCE_INLINE int getMask(const uint16x8_t low, const uint16x8_t high) {
+        static const uint8_t BITS[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+        const uint8x8_t bits = vld1_u8(BITS);
+        // Each lane keeps its own bit, then the pairwise additions gather the bits of each half.
+        const uint8x8_t lowBits = vand_u8(vmovn_u16(low), bits);
+        const uint8x8_t highBits = vand_u8(vmovn_u16(high), bits);
+        uint8x8_t sums = vpadd_u8(lowBits, highBits);
+        sums = vpadd_u8(sums, sums);
+        sums = vpadd_u8(sums, sums);
+        return vget_lane_u8(sums, 0) | (vget_lane_u8(sums, 1) << 8);
+    }
+#elif defined(LATINIME_PROXIMITY_ROW_MATCHER_SSE2)
+    // Returns the mask of the slots of row equal to codePoint0 or codePoint1.
+    static AK_FORCE_INLINE int getMatchMask(const int *const row, const int codePoint0,
+            const int codePoint1) {
+        const __m128i codePoints0 = _mm_set1_epi32(codePoint0);
+        const __m128i codePoints1 = _mm_set1_epi32(codePoint1);
+        __m128i matches[4];
+        for (int i = 0; i < 4; ++i) {
+            const __m128i codePoints =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i * 4));
+            matches[i] = _mm_or_si128(_mm_cmpeq_epi32(codePoints, codePoints0),
+                    _mm_cmpeq_epi32(codePoints, codePoints1));
+        }
+        return getMask(matches);
+    }
+
+    // Returns the mask of the slots of row whose code point is at most maxCodePoint.
+    static AK_FORCE_INLINE int getAtMostMask(const int *const row, const int maxCodePoint) {
+        const __m128i maxCodePoints = _mm_set1_epi32(maxCodePoint);
+        __m128i aboveMax[4];
+        for (int i = 0; i < 4; ++i) {
+            const __m128i codePoints =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i * 4));
+            aboveMax[i] = _mm_cmpgt_epi32(codePoints, maxCodePoints);
+        }
+        return ~getMask(aboveMax) & ((1 << MAX_PROXIMITY_CHARS_SIZE) - 1);
+    }
+
+    // Packs the all-ones or all-zeros lanes of the four vectors into the bits of a mask.
+    static AK_FORCE_INLINE int getMask(const __m128i *const lanes) {
+        const __m128i low = _mm_packs_epi32(lanes[0], lanes[1]);
+        const __m128i high = _mm_packs_epi32(lanes[2], lanes[3]);
+        return _mm_movemask_epi8(_mm_packs_epi16(low, high));
+    }
+#endif
+};
+} // namespace latinime
+#endif // LATINIME_PROXIMITY_ROW_MATCHER_H
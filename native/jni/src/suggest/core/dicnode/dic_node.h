@@ -17,25 +17,31 @@
 #ifndef LATINIME_DIC_NODE_H
 #define LATINIME_DIC_NODE_H
 
+#include <cstring> // for memcmp()
+
 #include "char_utils.h"
 #include "defines.h"
 #include "dic_node_state.h"
 #include "dic_node_profiler.h"
 #include "dic_node_properties.h"
-#include "dic_node_release_listener.h"
 #include "digraph_utils.h"
 
 #if DEBUG_DICT
 #define LOGI_SHOW_ADD_COST_PROP \
-        do { char charBuf[50]; \
-        INTS_TO_CHARS(getOutputWordBuf(), getDepth(), charBuf); \
+        do { char charBuf[50]; int codePoints[MAX_WORD_LENGTH]; \
+        outputCurrentWord(codePoints); \
+        INTS_TO_CHARS(codePoints, getDepth(), charBuf); \
         AKLOGI("%20s, \"%c\", size = %03d, total = %03d, index(0) = %02d, dist = %.4f, %s,,", \
                 __FUNCTION__, getNodeCodePoint(), inputSize, getTotalInputIndex(), \
                 getInputIndex(0), getNormalizedCompoundDistance(), charBuf); } while (0)
 #define DUMP_WORD_AND_SCORE(header) \
         do { char charBuf[50]; char prevWordCharBuf[50]; \
-        INTS_TO_CHARS(getOutputWordBuf(), getDepth(), charBuf); \
-        INTS_TO_CHARS(mDicNodeState.mDicNodeStatePrevWord.mPrevWord, \
+        int codePoints[MAX_WORD_LENGTH]; int prevWordCodePoints[MAX_WORD_LENGTH]; \
+        outputCurrentWord(codePoints); \
+        outputPrevWords(mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength(), \
+                prevWordCodePoints); \
+        INTS_TO_CHARS(codePoints, getDepth(), charBuf); \
+        INTS_TO_CHARS(prevWordCodePoints, \
                 mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength(), prevWordCharBuf); \
         AKLOGI("#%8s, %5f, %5f, %5f, %5f, %s, %s, %d,,", header, \
                 getSpatialDistanceForScoring(), getLanguageDistanceForScoring(), \
@@ -86,7 +92,7 @@ class DicNode {
               mProfiler(),
 #endif
               mDicNodeProperties(), mDicNodeState(), mIsCachedForNextSuggestion(false),
-              mIsUsed(false), mReleaseListener(0) {}
+              mIsUsed(false) {}
 
     DicNode(const DicNode &dicNode);
     DicNode &operator=(const DicNode &dicNode);
@@ -105,12 +111,12 @@ class DicNode {
     // TODO: minimize arguments by looking binary_format
     // Init for root with prevWordNodePos which is used for bigram
     void initAsRoot(const int pos, const int childrenPos, const int childrenCount,
-            const int prevWordNodePos) {
+            const int prevWordNodePos, DicNodeWordStore *const wordStore) {
         mIsUsed = true;
         mIsCachedForNextSuggestion = false;
         mDicNodeProperties.init(
                 pos, 0, childrenPos, 0, 0, 0, childrenCount, 0, 0, false, false, true, 0, 0);
-        mDicNodeState.init(prevWordNodePos);
+        mDicNodeState.init(prevWordNodePos, wordStore);
         PROF_NODE_RESET(mProfiler);
     }
 
@@ -132,21 +138,24 @@ class DicNode {
         mDicNodeProperties.init(
                 pos, 0, childrenPos, 0, 0, 0, childrenCount, 0, 0, false, false, true, 0, 0);
         // TODO: Move to dicNodeState?
-        mDicNodeState.mDicNodeStateOutput.init(); // reset for next word
         mDicNodeState.mDicNodeStateInput.init(
                 &dicNode->mDicNodeState.mDicNodeStateInput, true /* resetTerminalDiffCost */);
         mDicNodeState.mDicNodeStateScoring.init(
                 &dicNode->mDicNodeState.mDicNodeStateScoring);
+        DicNodeWordStore *const wordStore = dicNode->getWordStore();
         mDicNodeState.mDicNodeStatePrevWord.init(
                 dicNode->mDicNodeState.mDicNodeStatePrevWord.getPrevWordCount() + 1,
                 dicNode->mDicNodeProperties.getProbability(),
                 dicNode->mDicNodeProperties.getPos(),
-                dicNode->mDicNodeState.mDicNodeStatePrevWord.mPrevWord,
+                wordStore,
+                dicNode->mDicNodeState.mDicNodeStateOutput.getWordHandleAt(dicNode->getDepth()),
                 dicNode->mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength(),
-                dicNode->getOutputWordBuf(),
                 dicNode->mDicNodeProperties.getDepth(),
                 dicNode->mDicNodeState.mDicNodeStatePrevWord.mPrevSpacePositions,
                 mDicNodeState.mDicNodeStateInput.getInputIndex(0) /* lastInputIndex */);
+        // reset for next word
+        mDicNodeState.mDicNodeStateOutput.init(wordStore,
+                mDicNodeState.mDicNodeStatePrevWord.getPrevWordHandle());
         PROF_NODE_COPY(&dicNode->mProfiler, mProfiler);
     }
 
@@ -170,9 +179,6 @@ class DicNode {
 
     AK_FORCE_INLINE void remove() {
         mIsUsed = false;
-        if (mReleaseListener) {
-            mReleaseListener->onReleased(this);
-        }
     }
 
     bool isUsed() const {
@@ -220,7 +226,7 @@ class DicNode {
     }
 
     bool isFirstCharUppercase() const {
-        const int c = getOutputWordBuf()[0];
+        const int c = getOutputWordCodePointAt(0);
         return isAsciiUpper(c);
     }
 
@@ -289,12 +295,19 @@ class DicNode {
 
     // TODO: This may be defective. Needs to be revised.
     bool truncateNode(const DicNode *const topNode, const int inputCommitPoint) {
-        const int prevWordLenOfTop = mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength();
+        // The previous words in the word store aren't bounded by MAX_WORD_LENGTH, so only the
+        // first ones are compared, as in outputResult(). prefixLength is bounded by this length,
+        // so topPrevWord fits the same buffer size.
+        const int prevWordLenOfTop = min(
+                static_cast<int>(mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength()),
+                MAX_WORD_LENGTH);
+        int prevWord[MAX_WORD_LENGTH];
+        outputPrevWords(prevWordLenOfTop, prevWord);
         int newPrevWordStartIndex = inputCommitPoint;
         int charCount = 0;
         // Find new word start index
         for (int i = 0; i < prevWordLenOfTop; ++i) {
-            const int c = mDicNodeState.mDicNodeStatePrevWord.getPrevWordCodePointAt(i);
+            const int c = prevWord[i];
             // TODO: Check other separators.
             if (c != KEYCODE_SPACE && c != KEYCODE_SINGLE_QUOTE) {
                 if (charCount == inputCommitPoint) {
@@ -304,24 +317,61 @@ class DicNode {
                 ++charCount;
             }
         }
-        if (!mDicNodeState.mDicNodeStatePrevWord.startsWith(
-                &topNode->mDicNodeState.mDicNodeStatePrevWord, newPrevWordStartIndex - 1)) {
+        const int prefixLength = newPrevWordStartIndex - 1;
+        if (prefixLength > prevWordLenOfTop || prefixLength
+                > topNode->mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength()) {
             // Node mismatch.
             return false;
         }
+        if (prefixLength > 0) {
+            int topPrevWord[MAX_WORD_LENGTH];
+            topNode->outputPrevWords(prefixLength, topPrevWord);
+            if (memcmp(prevWord, topPrevWord, prefixLength * sizeof(prevWord[0])) != 0) {
+                // Node mismatch.
+                return false;
+            }
+        }
         mDicNodeState.mDicNodeStateInput.truncate(inputCommitPoint);
-        mDicNodeState.mDicNodeStatePrevWord.truncate(newPrevWordStartIndex);
+        mDicNodeState.mDicNodeStatePrevWord.truncate(getWordStore(), newPrevWordStartIndex);
+        mDicNodeState.mDicNodeStateOutput.rebase(
+                mDicNodeState.mDicNodeStatePrevWord.getPrevWordHandle());
         return true;
     }
 
     void outputResult(int *dest) const {
-        const uint16_t prevWordLength = mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength();
-        const uint16_t currentDepth = getDepth();
-        DicNodeUtils::appendTwoWords(mDicNodeState.mDicNodeStatePrevWord.mPrevWord,
-                   prevWordLength, getOutputWordBuf(), currentDepth, dest);
+        const int prevWordLength = min(
+                static_cast<int>(mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength()),
+                MAX_WORD_LENGTH);
+        const int currentDepth = min(static_cast<int>(getDepth()),
+                MAX_WORD_LENGTH - prevWordLength - 1);
+        outputPrevWords(prevWordLength, dest);
+        if (currentDepth > 0) {
+            mDicNodeState.mDicNodeStateOutput.outputCodePoints(currentDepth,
+                    &dest[prevWordLength]);
+        }
         DUMP_WORD_AND_SCORE("OUTPUT");
     }
 
+    // Moves the words of this dicNode to the current generation of the word store. Must only be
+    // called while the store is relocating.
+    void relocateOutputWords() {
+        mDicNodeState.mDicNodeStatePrevWord.relocate(getWordStore());
+        mDicNodeState.mDicNodeStateOutput.relocate(
+                mDicNodeState.mDicNodeStatePrevWord.getPrevWordHandle());
+    }
+
+    // Makes this dicNode and the dicNodes created from it append their code points to an overlay
+    // of the word store this dicNode uses.
+    void setOverlayWordStore(DicNodeWordStore *const wordStore) {
+        mDicNodeState.mDicNodeStateOutput.setOverlayWordStore(wordStore);
+    }
+
+    // Moves the words of this dicNode from the overlay it uses to the base word store.
+    void moveWordsToBaseStore() {
+        mDicNodeState.mDicNodeStatePrevWord.moveToBaseStore(getWordStore());
+        mDicNodeState.mDicNodeStateOutput.moveToBaseStore();
+    }
+
     void outputSpacePositionsResult(int *spaceIndices) const {
         mDicNodeState.mDicNodeStatePrevWord.outputSpacePositions(spaceIndices);
     }
@@ -364,8 +414,13 @@ class DicNode {
         return mDicNodeState.mDicNodeStatePrevWord.getPrevWordNodePos();
     }
 
-    AK_FORCE_INLINE const int *getOutputWordBuf() const {
-        return mDicNodeState.mDicNodeStateOutput.mWordBuf;
+    int getOutputWordCodePointAt(const int index) const {
+        return mDicNodeState.mDicNodeStateOutput.getCodePointAt(index);
+    }
+
+    // Materializes the current word up to the current depth into dest.
+    AK_FORCE_INLINE void outputCurrentWord(int *dest) const {
+        mDicNodeState.mDicNodeStateOutput.outputCodePoints(getDepth(), dest);
     }
 
     int getPrevCodePointG(int pointerId) const {
@@ -488,8 +543,45 @@ class DicNode {
 #endif
     }
 
-    void setReleaseListener(DicNodeReleaseListener *releaseListener) {
-        mReleaseListener = releaseListener;
+    // Returns whether dicNode is at the same position of the lexicon and of the input as this one,
+    // in the same context. The expansions of two such dicNodes only differ by the cost they
+    // started from, so only the best one of them needs to be expanded.
+    AK_FORCE_INLINE bool isRecombinableWith(const DicNode *const dicNode) const {
+        if (getPos() != dicNode->getPos() || getDepth() != dicNode->getDepth()) {
+            return false;
+        }
+        for (int i = 0; i < MAX_POINTER_COUNT_G; ++i) {
+            if (getInputIndex(i) != dicNode->getInputIndex(i)) {
+                return false;
+            }
+        }
+        const DicNodeStatePrevWord &prevWord = mDicNodeState.mDicNodeStatePrevWord;
+        const DicNodeStatePrevWord &otherPrevWord = dicNode->mDicNodeState.mDicNodeStatePrevWord;
+        const DicNodeStateScoring &scoring = mDicNodeState.mDicNodeStateScoring;
+        const DicNodeStateScoring &otherScoring = dicNode->mDicNodeState.mDicNodeStateScoring;
+        return prevWord.getPrevWordNodePos() == otherPrevWord.getPrevWordNodePos()
+                && prevWord.getPrevWordCount() == otherPrevWord.getPrevWordCount()
+                && prevWord.getPrevWordLength() == otherPrevWord.getPrevWordLength()
+                && scoring.getDigraphIndex() == otherScoring.getDigraphIndex()
+                && scoring.getDoubleLetterLevel() == otherScoring.getDoubleLetterLevel()
+                && scoring.isExactMatch() == otherScoring.isExactMatch()
+                // The terminal cost depends on whether there are corrections.
+                && (scoring.getProximityCorrectionCount() > 0)
+                        == (otherScoring.getProximityCorrectionCount() > 0)
+                && (scoring.getEditCorrectionCount() > 0)
+                        == (otherScoring.getEditCorrectionCount() > 0);
+    }
+
+    // Hash of the fields compared by isRecombinableWith().
+    AK_FORCE_INLINE int getRecombinationKey() const {
+        uint32_t key = static_cast<uint32_t>(getPos()) * 31 + getDepth();
+        for (int i = 0; i < MAX_POINTER_COUNT_G; ++i) {
+            key = key * 31 + static_cast<uint32_t>(getInputIndex(i));
+        }
+        key = key * 31 + static_cast<uint32_t>(getPrevWordNodePos());
+        key = key * 31 + static_cast<uint32_t>(
+                mDicNodeState.mDicNodeStateScoring.getDigraphIndex());
+        return static_cast<int>(key);
     }
 
     AK_FORCE_INLINE bool compare(const DicNode *right) {
@@ -516,12 +608,10 @@ class DicNode {
         if (depthDiff != 0) {
             return depthDiff > 0;
         }
-        for (int i = 0; i < depth; ++i) {
-            const int codePoint = mDicNodeState.mDicNodeStateOutput.getCodePointAt(i);
-            const int rightCodePoint = right->mDicNodeState.mDicNodeStateOutput.getCodePointAt(i);
-            if (codePoint != rightCodePoint) {
-                return rightCodePoint > codePoint;
-            }
+        const int codePointsDiff = mDicNodeState.mDicNodeStateOutput.compareCodePoints(
+                &right->mDicNodeState.mDicNodeStateOutput, depth);
+        if (codePointsDiff != 0) {
+            return codePointsDiff < 0;
         }
         // Compare pointer values here for stable comparison
         return this > right;
@@ -533,7 +623,14 @@ class DicNode {
     // TODO: Remove
     bool mIsCachedForNextSuggestion;
     bool mIsUsed;
-    DicNodeReleaseListener *mReleaseListener;
+
+    DicNodeWordStore *getWordStore() const {
+        return mDicNodeState.mDicNodeStateOutput.getWordStore();
+    }
+
+    void outputPrevWords(const int length, int *dest) const {
+        mDicNodeState.mDicNodeStatePrevWord.outputPrevWordCodePoints(getWordStore(), length, dest);
+    }
 
     AK_FORCE_INLINE int getTotalInputIndex() const {
         int index = 0;
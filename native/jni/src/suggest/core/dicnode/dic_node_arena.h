@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_ARENA_H
+#define LATINIME_DIC_NODE_ARENA_H
+
+#include <vector>
+
+#include "defines.h"
+#include "dic_node.h"
+
+namespace latinime {
+
+/**
+ * Bump allocator of the dicNodes of DicNodeVectors, owned by a session. The vectors are
+ * stack-allocated and nest, so the arena is a stack: only the most recently created vector
+ * grows, and destroying a vector rolls the arena back to where the vector started. Blocks are
+ * kept across searches, so expanding dicNodes does not allocate once the arena has warmed up.
+ */
+class DicNodeArena {
+ public:
+    DicNodeArena() : mBlocks(), mBlockSizes(), mBlockIndex(0), mUsedSizeInBlock(0) {}
+
+    // Non virtual inline destructor -- never inherit this class
+    ~DicNodeArena() {
+        for (size_t i = 0; i < mBlocks.size(); ++i) {
+            delete[] mBlocks[i];
+        }
+    }
+
+    void reset() {
+        rollback(0 /* blockIndex */, 0 /* usedSizeInBlock */);
+    }
+
+    int getBlockIndex() const {
+        return mBlockIndex;
+    }
+
+    int getUsedSizeInBlock() const {
+        return mUsedSizeInBlock;
+    }
+
+    // Releases all the dicNodes allocated after getBlockIndex() and getUsedSizeInBlock()
+    // returned blockIndex and usedSizeInBlock.
+    void rollback(const int blockIndex, const int usedSizeInBlock) {
+        mBlockIndex = blockIndex;
+        mUsedSizeInBlock = usedSizeInBlock;
+    }
+
+    // Allocates the dicNode that follows the "size" dicNodes starting at *dicNodes, which must be
+    // the most recently allocated ones. When the current block is full, they are moved to the
+    // beginning of the next block and *dicNodes is updated.
+    AK_FORCE_INLINE DicNode *extend(DicNode **dicNodes, const int size) {
+        if (mBlocks.empty() || mUsedSizeInBlock >= mBlockSizes[mBlockIndex]) {
+            moveToNextBlock(dicNodes, size);
+        } else if (size == 0) {
+            *dicNodes = &mBlocks[mBlockIndex][mUsedSizeInBlock];
+        }
+        ASSERT(*dicNodes + size == &mBlocks[mBlockIndex][mUsedSizeInBlock]);
+        return &mBlocks[mBlockIndex][mUsedSizeInBlock++];
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicNodeArena);
+
+#ifdef FLAG_DBG
+    // Small blocks exercise moving dicNodes to the next block.
+    static const int MIN_BLOCK_SIZE = 2;
+#else
+    static const int MIN_BLOCK_SIZE = 256;
+#endif
+
+    void moveToNextBlock(DicNode **dicNodes, const int size) {
+        const int nextBlockIndex = mBlocks.empty() ? 0 : mBlockIndex + 1;
+        const int requiredSize = size + 1;
+        if (nextBlockIndex < static_cast<int>(mBlocks.size())
+                && mBlockSizes[nextBlockIndex] < requiredSize) {
+            // The free block is too small for the moved dicNodes. Blocks after the current one
+            // are not in use, so it can be replaced.
+            delete[] mBlocks[nextBlockIndex];
+            mBlocks[nextBlockIndex] = new DicNode[requiredSize * 2];
+            mBlockSizes[nextBlockIndex] = requiredSize * 2;
+        } else if (nextBlockIndex == static_cast<int>(mBlocks.size())) {
+            const int blockSize = max(static_cast<int>(MIN_BLOCK_SIZE), requiredSize * 2);
+            mBlocks.push_back(new DicNode[blockSize]);
+            mBlockSizes.push_back(blockSize);
+        }
+        DicNode *const nextBlock = mBlocks[nextBlockIndex];
+        for (int i = 0; i < size; ++i) {
+            nextBlock[i] = (*dicNodes)[i];
+        }
+        *dicNodes = nextBlock;
+        mBlockIndex = nextBlockIndex;
+        mUsedSizeInBlock = size;
+    }
+
+    std::vector<DicNode *> mBlocks;
+    std::vector<int> mBlockSizes;
+    int mBlockIndex;
+    int mUsedSizeInBlock;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_ARENA_H
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_POOL_H
+#define LATINIME_DIC_NODE_POOL_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+#include "dic_node.h"
+
+namespace latinime {
+
+/**
+ * Slab of dicNodes shared by all the priority queues of a session. Queues refer to dicNodes by
+ * slot index, and each slot is reference counted so that a dicNode can be held by several
+ * queues at once without being copied.
+ * The pool is reset in constant time: resetting bumps the generation of the pool, and slots
+ * that were handed out in an older generation are treated as free without being visited.
+ */
+class DicNodePool {
+ public:
+    static const int NOT_A_SLOT = -1;
+
+    DicNodePool()
+            : mDicNodes(), mRefCounts(), mNextUnusedSlots(), mSlotGenerations(), mGeneration(0),
+              mNextFreshSlot(0), mNextUnusedSlot(NOT_A_SLOT) {}
+
+    // Non virtual inline destructor -- never inherit this class
+    ~DicNodePool() {}
+
+    // Releases all the slots at once. The pool only grows when nothing refers to its dicNodes,
+    // as growing it moves them.
+    void reset(const int capacity) {
+        if (capacity > getCapacity()) {
+            mDicNodes.resize(capacity);
+            mRefCounts.resize(capacity, 0);
+            mNextUnusedSlots.resize(capacity, NOT_A_SLOT);
+            mSlotGenerations.resize(capacity, 0);
+        }
+        ++mGeneration;
+        if (mGeneration == 0) {
+            // The generation counter wrapped around. Slots stamped long ago could be mistaken
+            // for current ones, so forget all the stamps.
+            std::fill(mSlotGenerations.begin(), mSlotGenerations.end(), 0);
+            mGeneration = 1;
+        }
+        mNextFreshSlot = 0;
+        mNextUnusedSlot = NOT_A_SLOT;
+    }
+
+    // Returns a free slot with a reference count of 1, or NOT_A_SLOT if the pool is exhausted.
+    AK_FORCE_INLINE int allocate() {
+        int slot = mNextUnusedSlot;
+        if (slot != NOT_A_SLOT) {
+            mNextUnusedSlot = mNextUnusedSlots[slot];
+        } else if (mNextFreshSlot < getCapacity()) {
+            slot = mNextFreshSlot++;
+            mSlotGenerations[slot] = mGeneration;
+        } else {
+            AKLOGI("No unused node found.");
+            ASSERT(false);
+            return NOT_A_SLOT;
+        }
+        mRefCounts[slot] = 1;
+        return slot;
+    }
+
+    AK_FORCE_INLINE void retain(const int slot) {
+        ASSERT(isAlive(slot));
+        ++mRefCounts[slot];
+    }
+
+    AK_FORCE_INLINE void release(const int slot) {
+        if (!isAlive(slot)) {
+            // It belongs to a previous generation, which is free as a whole, or it's already
+            // released.
+            return;
+        }
+        if (--mRefCounts[slot] > 0) {
+            return;
+        }
+        mNextUnusedSlots[slot] = mNextUnusedSlot;
+        mNextUnusedSlot = slot;
+    }
+
+    AK_FORCE_INLINE DicNode *getDicNode(const int slot) {
+        return &mDicNodes[slot];
+    }
+
+    // Moves the words of the dicNodes in use to the current generation of the word store. Each
+    // dicNode is visited once however many queues hold it.
+    void relocateOutputWords() {
+        for (int slot = 0; slot < mNextFreshSlot; ++slot) {
+            if (isAlive(slot)) {
+                mDicNodes[slot].relocateOutputWords();
+            }
+        }
+    }
+
+    AK_FORCE_INLINE int getSlot(const DicNode *const dicNode) const {
+        const int slot = static_cast<int>(dicNode - &mDicNodes[0]);
+        ASSERT(slot >= 0 && slot < getCapacity());
+        return slot;
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicNodePool);
+
+    int getCapacity() const {
+        return static_cast<int>(mDicNodes.size());
+    }
+
+    AK_FORCE_INLINE bool isAlive(const int slot) const {
+        return mSlotGenerations[slot] == mGeneration && mRefCounts[slot] > 0;
+    }
+
+    std::vector<DicNode> mDicNodes;
+    std::vector<int> mRefCounts;
+    // Next free slot of each released slot. Only meaningful for the slots stamped with the
+    // current generation.
+    std::vector<int> mNextUnusedSlots;
+    std::vector<uint32_t> mSlotGenerations;
+    uint32_t mGeneration;
+    // Slots from this index on have not been handed out in the current generation.
+    int mNextFreshSlot;
+    // Head of the list of the slots released in the current generation.
+    int mNextUnusedSlot;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_POOL_H
@@ -17,33 +17,47 @@
 #ifndef LATINIME_DIC_NODE_PRIORITY_QUEUE_H
 #define LATINIME_DIC_NODE_PRIORITY_QUEUE_H
 
-#include <queue>
+#include <algorithm>
 #include <vector>
 
 #include "defines.h"
 #include "dic_node.h"
-#include "dic_node_release_listener.h"
+#include "dic_node_pool.h"
+#include "dic_node_utils.h"
 
 #define MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY 200
+// Size of the hash table of the recombined dicNodes. A power of 2 that leaves enough empty
+// entries for the probes to stay short when the queue is full.
+#define DIC_NODE_RECOMBINATION_TABLE_SIZE 512
 
 namespace latinime {
 
-class DicNodePriorityQueue : public DicNodeReleaseListener {
+/**
+ * Bounded priority queue of dicNodes, which evicts the worst dicNode when it is full.
+ * The queue is a min-max heap, so both the best and the worst dicNodes can be peeked in
+ * constant time and popped in logarithmic time.
+ * The dicNodes live in a DicNodePool shared with the other queues of the session. The queue
+ * only holds their slots, and holds one reference to each of them.
+ */
+class DicNodePriorityQueue {
  public:
     AK_FORCE_INLINE DicNodePriorityQueue()
             : MAX_CAPACITY(MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY),
-              mMaxSize(MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY), mDicNodesBuf(), mUnusedNodeIndices(),
-              mNextUnusedNodeId(0), mDicNodesQueue() {
-        mDicNodesBuf.resize(MAX_CAPACITY + 1);
-        mUnusedNodeIndices.resize(MAX_CAPACITY + 1);
-        reset();
+              mMaxSize(MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY), mDicNodePool(0), mSlots(),
+              mWorstIndex(NOT_AN_INDEX), mRecombinesDicNodes(false), mRecombinationKeys(),
+              mRecombinationSlots(), mRecombinationTableUsedCount(0) {
+        mSlots.reserve(MAX_CAPACITY);
     }
 
     // Non virtual inline destructor -- never inherit this class
     AK_FORCE_INLINE ~DicNodePriorityQueue() {}
 
+    void setDicNodePool(DicNodePool *const dicNodePool) {
+        mDicNodePool = dicNodePool;
+    }
+
     int getSize() const {
-        return static_cast<int>(mDicNodesQueue.size());
+        return static_cast<int>(mSlots.size());
     }
 
     int getMaxSize() const {
@@ -54,6 +68,21 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
         mMaxSize = min(maxSize, MAX_CAPACITY);
     }
 
+    inline bool isFull() const {
+        return getSize() >= mMaxSize;
+    }
+
+    // When enabled, a dicNode pushed while a recombinable one (see DicNode::isRecombinableWith())
+    // is queued only keeps the better one of the two.
+    void setRecombinesDicNodes(const bool recombinesDicNodes) {
+        mRecombinesDicNodes = recombinesDicNodes;
+        if (mRecombinesDicNodes) {
+            mRecombinationKeys.resize(DIC_NODE_RECOMBINATION_TABLE_SIZE);
+            mRecombinationSlots.resize(DIC_NODE_RECOMBINATION_TABLE_SIZE);
+            rebuildRecombinationTable();
+        }
+    }
+
     AK_FORCE_INLINE void reset() {
         clearAndResize(MAX_CAPACITY);
     }
@@ -62,151 +91,367 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
         clearAndResize(mMaxSize);
     }
 
+    // Only the slots are visited, not the dicNodes.
     AK_FORCE_INLINE void clearAndResize(const int maxSize) {
-        while (!mDicNodesQueue.empty()) {
-            mDicNodesQueue.pop();
+        for (int i = 0; i < getSize(); ++i) {
+            mDicNodePool->release(mSlots[i]);
+        }
+        mSlots.clear();
+        mWorstIndex = NOT_AN_INDEX;
+        if (mRecombinesDicNodes) {
+            rebuildRecombinationTable();
         }
         setMaxSize(maxSize);
-        for (int i = 0; i < MAX_CAPACITY + 1; ++i) {
-            mDicNodesBuf[i].remove();
-            mDicNodesBuf[i].setReleaseListener(this);
-            mUnusedNodeIndices[i] = i == MAX_CAPACITY ? NOT_A_NODE_ID : static_cast<int>(i) + 1;
+    }
+
+    // Copies dicNode to a new slot of the pool and queues the copy. Returns the copy, or 0 if it
+    // was not queued.
+    AK_FORCE_INLINE DicNode *copyPush(DicNode *dicNode) {
+        const int slot = mDicNodePool->allocate();
+        if (slot == DicNodePool::NOT_A_SLOT) {
+            return 0;
         }
-        mNextUnusedNodeId = 0;
+        DicNode *const newDicNode = mDicNodePool->getDicNode(slot);
+        DicNodeUtils::initByCopy(dicNode, newDicNode);
+        return pushSlot(slot) ? newDicNode : 0;
     }
 
-    AK_FORCE_INLINE DicNode *newDicNode(DicNode *dicNode) {
-        DicNode *newNode = searchEmptyDicNode();
-        if (newNode) {
-            DicNodeUtils::initByCopy(dicNode, newNode);
-            return newNode;
+    // Queues a dicNode of the pool without copying it.
+    AK_FORCE_INLINE bool push(DicNode *dicNode) {
+        const int slot = mDicNodePool->getSlot(dicNode);
+        mDicNodePool->retain(slot);
+        return pushSlot(slot);
+    }
+
+    // Pops the worst dicNode. The reference held by the queue is handed over to the caller,
+    // who has to release it to the pool.
+    AK_FORCE_INLINE DicNode *pop() {
+        if (mSlots.empty()) {
+            ASSERT(false);
+            return 0;
         }
-        return 0;
+        return mDicNodePool->getDicNode(popSlotAt(getWorstIndex()));
     }
 
-    // Copy
-    AK_FORCE_INLINE DicNode *copyPush(DicNode *dicNode) {
-        return copyPush(dicNode, mMaxSize);
+    // Returns the worst dicNode without popping it.
+    AK_FORCE_INLINE const DicNode *getWorst() {
+        if (mSlots.empty()) {
+            ASSERT(false);
+            return 0;
+        }
+        return mDicNodePool->getDicNode(mSlots[getWorstIndex()]);
     }
 
+    // Pops the worst dicNode.
     AK_FORCE_INLINE void copyPop(DicNode *dest) {
-        if (mDicNodesQueue.empty()) {
+        if (mSlots.empty()) {
             ASSERT(false);
             return;
         }
-        DicNode *node = mDicNodesQueue.top();
-        if (dest) {
-            DicNodeUtils::initByCopy(node, dest);
-        }
-        node->remove();
-        mDicNodesQueue.pop();
+        copyPopSlotAt(getWorstIndex(), dest);
     }
 
-    void onReleased(DicNode *dicNode) {
-        const int index = static_cast<int>(dicNode - &mDicNodesBuf[0]);
-        if (mUnusedNodeIndices[index] != NOT_A_NODE_ID) {
-            // it's already released
+    AK_FORCE_INLINE void copyPopBest(DicNode *dest) {
+        if (mSlots.empty()) {
+            ASSERT(false);
             return;
         }
-        mUnusedNodeIndices[index] = mNextUnusedNodeId;
-        mNextUnusedNodeId = index;
-        ASSERT(index >= 0 && index < (MAX_CAPACITY + 1));
+        copyPopSlotAt(0 /* index */, dest);
     }
 
     AK_FORCE_INLINE void dump() const {
         AKLOGI("\n\n\n\n\n===========================");
-        for (int i = 0; i < MAX_CAPACITY + 1; ++i) {
-            if (mDicNodesBuf[i].isUsed()) {
-                mDicNodesBuf[i].dump("QUEUE: ");
-            }
+        for (int i = 0; i < getSize(); ++i) {
+            mDicNodePool->getDicNode(mSlots[i])->dump("QUEUE: ");
         }
         AKLOGI("===========================\n\n\n\n\n");
     }
 
  private:
     DISALLOW_COPY_AND_ASSIGN(DicNodePriorityQueue);
-    static const int NOT_A_NODE_ID = -1;
 
-    AK_FORCE_INLINE static bool compareDicNode(DicNode *left, DicNode *right) {
-        return left->compare(right);
+    // Returns whether the dicNode in slot0 is better than the one in slot1.
+    AK_FORCE_INLINE bool compareSlots(const int slot0, const int slot1) const {
+        return mDicNodePool->getDicNode(slot0)->compare(mDicNodePool->getDicNode(slot1));
     }
 
-    struct DicNodeComparator {
-        bool operator ()(DicNode *left, DicNode *right) {
-            return compareDicNode(left, right);
-        }
-    };
-
-    typedef std::priority_queue<DicNode *, std::vector<DicNode *>, DicNodeComparator> DicNodesQueue;
     const int MAX_CAPACITY;
     int mMaxSize;
-    std::vector<DicNode> mDicNodesBuf; // of each element of mDicNodesBuf respectively
-    std::vector<int> mUnusedNodeIndices;
-    int mNextUnusedNodeId;
-    DicNodesQueue mDicNodesQueue;
+    DicNodePool *mDicNodePool;
+    // Min-max heap of slots: the levels of even depth hold dicNodes that are better than their
+    // descendants and the levels of odd depth hold dicNodes that are worse than their
+    // descendants. The best dicNode is at the root and the worst one is one of its children.
+    std::vector<int> mSlots;
+    // Cached index of the worst dicNode, or NOT_AN_INDEX when it has to be looked up again.
+    int mWorstIndex;
+    bool mRecombinesDicNodes;
+    // Open addressing hash table of the queued slots by recombination key, used when recombining
+    // dicNodes. Removed entries are marked until the table is rebuilt.
+    std::vector<int> mRecombinationKeys;
+    std::vector<int> mRecombinationSlots;
+    // Number of entries that are not empty, removed ones included.
+    int mRecombinationTableUsedCount;
 
-    inline bool isFull(const int maxSize) const {
-        return getSize() >= maxSize;
-    }
+    static const int EMPTY_RECOMBINATION_ENTRY = -1;
+    static const int REMOVED_RECOMBINATION_ENTRY = -2;
 
-    AK_FORCE_INLINE void pop() {
-        copyPop(0);
+    // Takes over one reference to slot, which is released if the dicNode is not queued.
+    AK_FORCE_INLINE bool pushSlot(const int slot) {
+        if (mRecombinesDicNodes) {
+            return recombineSlot(slot);
+        }
+        return pushSlotWithoutRecombination(slot);
     }
 
-    AK_FORCE_INLINE bool betterThanWorstDicNode(DicNode *dicNode) const {
-        DicNode *worstNode = mDicNodesQueue.top();
-        if (!worstNode) {
+    AK_FORCE_INLINE bool pushSlotWithoutRecombination(const int slot) {
+        if (!isFull()) {
+            mWorstIndex = NOT_AN_INDEX;
+            mSlots.push_back(slot);
+            siftUp(getSize() - 1);
             return true;
         }
-        return compareDicNode(dicNode, worstNode);
+        if (getSize() > 0) {
+            const int worstIndex = getWorstIndex();
+            if (compareSlots(slot, mSlots[worstIndex])) {
+                replaceWorst(worstIndex, slot);
+                return true;
+            }
+        }
+        mDicNodePool->release(slot);
+        return false;
     }
 
-    AK_FORCE_INLINE DicNode *searchEmptyDicNode() {
-        // TODO: Currently O(n) but should be improved to O(1)
-        if (MAX_CAPACITY == 0) {
-            return 0;
+    // Queues slot unless a better recombinable dicNode is queued, in which case slot is
+    // released. A worse recombinable dicNode is replaced.
+    bool recombineSlot(const int slot) {
+        if (isFull() && getSize() > 0 && !compareSlots(slot, mSlots[getWorstIndex()])) {
+            // Any recombinable dicNode in the queue is better than this one.
+            mDicNodePool->release(slot);
+            return false;
         }
-        if (mNextUnusedNodeId == NOT_A_NODE_ID) {
-            AKLOGI("No unused node found.");
-            for (int i = 0; i < MAX_CAPACITY + 1; ++i) {
-                AKLOGI("Dump node availability, %d, %d, %d",
-                        i, mDicNodesBuf[i].isUsed(), mUnusedNodeIndices[i]);
+        const DicNode *const dicNode = mDicNodePool->getDicNode(slot);
+        const int key = dicNode->getRecombinationKey();
+        for (int i = getRecombinationEntryIndex(key);
+                mRecombinationSlots[i] != EMPTY_RECOMBINATION_ENTRY;
+                i = (i + 1) & (DIC_NODE_RECOMBINATION_TABLE_SIZE - 1)) {
+            const int queuedSlot = mRecombinationSlots[i];
+            if (mRecombinationKeys[i] != key || queuedSlot == REMOVED_RECOMBINATION_ENTRY
+                    || !mDicNodePool->getDicNode(queuedSlot)->isRecombinableWith(dicNode)) {
+                continue;
             }
-            ASSERT(false);
-            return 0;
+            if (!compareSlots(slot, queuedSlot)) {
+                mDicNodePool->release(slot);
+                return false;
+            }
+            // Replacing is rare enough for the index of the queued slot to be looked up
+            // linearly.
+            for (int j = 0; j < getSize(); ++j) {
+                if (mSlots[j] == queuedSlot) {
+                    mDicNodePool->release(popSlotAt(j));
+                    break;
+                }
+            }
+            break;
+        }
+        if (!pushSlotWithoutRecombination(slot)) {
+            return false;
         }
-        DicNode *dicNode = &mDicNodesBuf[mNextUnusedNodeId];
-        markNodeAsUsed(dicNode);
-        return dicNode;
+        addRecombinationEntry(key, slot);
+        return true;
     }
 
-    AK_FORCE_INLINE void markNodeAsUsed(DicNode *dicNode) {
-        const int index = static_cast<int>(dicNode - &mDicNodesBuf[0]);
-        mNextUnusedNodeId = mUnusedNodeIndices[index];
-        mUnusedNodeIndices[index] = NOT_A_NODE_ID;
-        ASSERT(index >= 0 && index < (MAX_CAPACITY + 1));
+    static AK_FORCE_INLINE int getRecombinationEntryIndex(const int key) {
+        return ((static_cast<uint32_t>(key) * 2654435761U) >> 23)
+                & (DIC_NODE_RECOMBINATION_TABLE_SIZE - 1);
     }
 
-    AK_FORCE_INLINE DicNode *pushPoolNodeWithMaxSize(DicNode *dicNode, const int maxSize) {
-        if (!dicNode) {
-            return 0;
+    AK_FORCE_INLINE void addRecombinationEntry(const int key, const int slot) {
+        if (mRecombinationTableUsedCount >= DIC_NODE_RECOMBINATION_TABLE_SIZE * 3 / 4) {
+            // Too many removed entries: rebuilding also adds slot, which is already queued.
+            rebuildRecombinationTable();
+            return;
+        }
+        int i = getRecombinationEntryIndex(key);
+        while (mRecombinationSlots[i] != EMPTY_RECOMBINATION_ENTRY) {
+            i = (i + 1) & (DIC_NODE_RECOMBINATION_TABLE_SIZE - 1);
+        }
+        mRecombinationKeys[i] = key;
+        mRecombinationSlots[i] = slot;
+        ++mRecombinationTableUsedCount;
+    }
+
+    // Removes the entry of a slot leaving the queue.
+    AK_FORCE_INLINE void removeRecombinationEntry(const int slot) {
+        if (!mRecombinesDicNodes) {
+            return;
+        }
+        for (int i = getRecombinationEntryIndex(
+                mDicNodePool->getDicNode(slot)->getRecombinationKey());
+                mRecombinationSlots[i] != EMPTY_RECOMBINATION_ENTRY;
+                i = (i + 1) & (DIC_NODE_RECOMBINATION_TABLE_SIZE - 1)) {
+            if (mRecombinationSlots[i] == slot) {
+                mRecombinationSlots[i] = REMOVED_RECOMBINATION_ENTRY;
+                return;
+            }
+        }
+    }
+
+    void rebuildRecombinationTable() {
+        // Cast for std::fill not to take the address of the constant, which isn't defined.
+        std::fill(mRecombinationSlots.begin(), mRecombinationSlots.end(),
+                static_cast<int>(EMPTY_RECOMBINATION_ENTRY));
+        mRecombinationTableUsedCount = 0;
+        for (int i = 0; i < getSize(); ++i) {
+            addRecombinationEntry(mDicNodePool->getDicNode(mSlots[i])->getRecombinationKey(),
+                    mSlots[i]);
+        }
+    }
+
+    // Replaces the worst dicNode, which is either the root or one of its children.
+    AK_FORCE_INLINE void replaceWorst(const int worstIndex, const int slot) {
+        mWorstIndex = NOT_AN_INDEX;
+        removeRecombinationEntry(mSlots[worstIndex]);
+        mDicNodePool->release(mSlots[worstIndex]);
+        if (worstIndex > 0 && compareSlots(slot, mSlots[0])) {
+            // slot becomes the best one, and the former best one is sifted down instead.
+            const int bestSlot = mSlots[0];
+            mSlots[0] = slot;
+            siftDown(worstIndex, bestSlot);
+        } else {
+            siftDown(worstIndex, slot);
+        }
+    }
+
+    // Removes the slot at index from the heap without releasing it.
+    AK_FORCE_INLINE int popSlotAt(const int index) {
+        const int slot = mSlots[index];
+        mWorstIndex = NOT_AN_INDEX;
+        removeRecombinationEntry(slot);
+        const int lastSlot = mSlots.back();
+        mSlots.pop_back();
+        if (index < getSize()) {
+            siftDown(index, lastSlot);
+        }
+        return slot;
+    }
+
+    AK_FORCE_INLINE void copyPopSlotAt(const int index, DicNode *dest) {
+        const int slot = popSlotAt(index);
+        if (dest) {
+            DicNodeUtils::initByCopy(mDicNodePool->getDicNode(slot), dest);
+        }
+        mDicNodePool->release(slot);
+    }
+
+    AK_FORCE_INLINE int getWorstIndex() {
+        if (mWorstIndex == NOT_AN_INDEX) {
+            const int size = getSize();
+            if (size <= 2) {
+                mWorstIndex = size - 1;
+            } else {
+                mWorstIndex = compareSlots(mSlots[1], mSlots[2]) ? 2 : 1;
+            }
         }
-        if (!isFull(maxSize)) {
-            mDicNodesQueue.push(dicNode);
-            return dicNode;
+        return mWorstIndex;
+    }
+
+    // Whether the dicNode at index is on a level of dicNodes that are better than their
+    // descendants.
+    static AK_FORCE_INLINE bool isOnBestLevel(int index) {
+        bool isBestLevel = true;
+        while (index > 0) {
+            index = (index - 1) / 2;
+            isBestLevel = !isBestLevel;
         }
-        if (betterThanWorstDicNode(dicNode)) {
-            pop();
-            mDicNodesQueue.push(dicNode);
-            return dicNode;
+        return isBestLevel;
+    }
+
+    // Returns whether the dicNode at index0 should be closer to the root than the one at index1
+    // on the levels of the given kind.
+    AK_FORCE_INLINE bool precedes(const bool bestLevel, const int index0,
+            const int index1) const {
+        return bestLevel ? compareSlots(mSlots[index0], mSlots[index1])
+                : compareSlots(mSlots[index1], mSlots[index0]);
+    }
+
+    AK_FORCE_INLINE void swapSlots(const int index0, const int index1) {
+        const int tmp = mSlots[index0];
+        mSlots[index0] = mSlots[index1];
+        mSlots[index1] = tmp;
+    }
+
+    AK_FORCE_INLINE void siftUp(int index) {
+        if (index == 0) {
+            return;
         }
-        dicNode->remove();
-        return 0;
+        bool bestLevel = isOnBestLevel(index);
+        const int parent = (index - 1) / 2;
+        // The parent is on a level of the other kind.
+        if (precedes(!bestLevel, index, parent)) {
+            swapSlots(index, parent);
+            index = parent;
+            bestLevel = !bestLevel;
+        }
+        // Climb the levels of the same kind.
+        while (index > 2) {
+            const int grandparent = ((index - 1) / 2 - 1) / 2;
+            if (!precedes(bestLevel, index, grandparent)) {
+                break;
+            }
+            swapSlots(index, grandparent);
+            index = grandparent;
+        }
+    }
+
+    AK_FORCE_INLINE int getExtremeChildOrSelf(const bool bestLevel, const int index,
+            const int size) const {
+        const int firstChild = index * 2 + 1;
+        if (firstChild >= size) {
+            return index;
+        }
+        if (firstChild + 1 < size && precedes(bestLevel, firstChild + 1, firstChild)) {
+            return firstChild + 1;
+        }
+        return firstChild;
     }
 
-    // Copy
-    AK_FORCE_INLINE DicNode *copyPush(DicNode *dicNode, const int maxSize) {
-        return pushPoolNodeWithMaxSize(newDicNode(dicNode), maxSize);
+    // Fills the hole at index with slot. The hole is first moved down along the most extreme
+    // grandchildren without comparing them with slot, as the filling dicNode usually belongs
+    // near the leaves, and slot is then sifted up from there.
+    AK_FORCE_INLINE void siftDown(int index, const int slot) {
+        const bool bestLevel = isOnBestLevel(index);
+        const int size = getSize();
+        while (true) {
+            const int firstChild = index * 2 + 1;
+            if (firstChild >= size) {
+                mSlots[index] = slot;
+                break;
+            }
+            // Find the most extreme of the children and grandchildren. A child that has
+            // children of its own is on a level of the other kind, so it is never more extreme
+            // than all of them and only needs to be considered when it is a leaf.
+            int extremeIndex = getExtremeChildOrSelf(bestLevel, firstChild, size);
+            if (firstChild + 1 < size) {
+                const int candidate = getExtremeChildOrSelf(bestLevel, firstChild + 1, size);
+                if (precedes(bestLevel, candidate, extremeIndex)) {
+                    extremeIndex = candidate;
+                }
+            }
+            if (extremeIndex > firstChild + 1) {
+                // A grandchild: move it up into the hole.
+                mSlots[index] = mSlots[extremeIndex];
+                index = extremeIndex;
+                continue;
+            }
+            // A leaf child: it fills the hole if it is more extreme than slot.
+            mSlots[index] = slot;
+            if (precedes(bestLevel, extremeIndex, index)) {
+                swapSlots(index, extremeIndex);
+                index = extremeIndex;
+            }
+            break;
+        }
+        siftUp(index);
     }
 };
 } // namespace latinime
@@ -22,6 +22,7 @@
 #include "dic_node_state_output.h"
 #include "dic_node_state_prevword.h"
 #include "dic_node_state_scoring.h"
+#include "dic_node_word_store.h"
 
 namespace latinime {
 
@@ -40,9 +41,9 @@ class DicNodeState {
     virtual ~DicNodeState() {}
 
     // Init with prevWordPos
-    void init(const int prevWordPos) {
+    void init(const int prevWordPos, DicNodeWordStore *const wordStore) {
         mDicNodeStateInput.init();
-        mDicNodeStateOutput.init();
+        mDicNodeStateOutput.init(wordStore, DicNodeWordStore::EMPTY_WORD_HANDLE);
         mDicNodeStatePrevWord.init(prevWordPos);
         mDicNodeStateScoring.init();
     }
@@ -17,58 +17,135 @@
 #ifndef LATINIME_DIC_NODE_STATE_OUTPUT_H
 #define LATINIME_DIC_NODE_STATE_OUTPUT_H
 
-#include <cstring> // for memcpy()
+#include <cstring> // for memcpy() and memset()
 #include <stdint.h>
 
 #include "defines.h"
+#include "dic_node_word_store.h"
 
 namespace latinime {
 
 class DicNodeStateOutput {
  public:
-    DicNodeStateOutput() : mOutputtedLength(0) {
-        init();
+    DicNodeStateOutput()
+            : mWordStore(0), mWordHandle(DicNodeWordStore::EMPTY_WORD_HANDLE),
+              mOutputtedLength(0) {
+        memset(mLeadingCodePoints, 0, sizeof(mLeadingCodePoints));
+    }
+
+    // Copies share the word store: only the handle of the word in the store is copied.
+    DicNodeStateOutput(const DicNodeStateOutput &stateOutput)
+            : mWordStore(stateOutput.mWordStore), mWordHandle(stateOutput.mWordHandle),
+              mOutputtedLength(stateOutput.mOutputtedLength) {
+        memcpy(mLeadingCodePoints, stateOutput.mLeadingCodePoints, sizeof(mLeadingCodePoints));
+    }
+
+    DicNodeStateOutput &operator=(const DicNodeStateOutput &stateOutput) {
+        init(&stateOutput);
+        return *this;
     }
 
     virtual ~DicNodeStateOutput() {}
 
-    void init() {
+    // The output of the current word is chained after prevWordHandle in the word store.
+    void init(DicNodeWordStore *const wordStore, const int prevWordHandle) {
+        mWordStore = wordStore;
+        mWordHandle = prevWordHandle;
         mOutputtedLength = 0;
-        mWordBuf[0] = 0;
     }
 
     void init(const DicNodeStateOutput *const stateOutput) {
-        memcpy(mWordBuf, stateOutput->mWordBuf,
-                stateOutput->mOutputtedLength * sizeof(mWordBuf[0]));
+        mWordStore = stateOutput->mWordStore;
+        mWordHandle = stateOutput->mWordHandle;
         mOutputtedLength = stateOutput->mOutputtedLength;
-        if (mOutputtedLength < MAX_WORD_LENGTH) {
-            mWordBuf[mOutputtedLength] = 0;
-        }
+        memcpy(mLeadingCodePoints, stateOutput->mLeadingCodePoints, sizeof(mLeadingCodePoints));
     }
 
     void addSubword(const uint16_t additionalSubwordLength, const int *const additionalSubword) {
         if (additionalSubword) {
-            memcpy(&mWordBuf[mOutputtedLength], additionalSubword,
-                    additionalSubwordLength * sizeof(mWordBuf[0]));
-            mOutputtedLength = static_cast<uint16_t>(mOutputtedLength + additionalSubwordLength);
-            if (mOutputtedLength < MAX_WORD_LENGTH) {
-                mWordBuf[mOutputtedLength] = 0;
+            for (int i = mOutputtedLength, j = 0;
+                    i < LEADING_CODE_POINTS_SIZE && j < additionalSubwordLength; ++i, ++j) {
+                mLeadingCodePoints[i] = additionalSubword[j];
             }
+            mWordHandle = mWordStore->append(mWordHandle, additionalSubword,
+                    additionalSubwordLength);
+            mOutputtedLength = static_cast<uint16_t>(mOutputtedLength + additionalSubwordLength);
         }
     }
 
     // TODO: Remove
     int getCodePointAt(const int id) const {
-        return mWordBuf[id];
+        if (id >= mOutputtedLength) {
+            return 0;
+        }
+        if (id < LEADING_CODE_POINTS_SIZE) {
+            return mLeadingCodePoints[id];
+        }
+        return mWordStore->getCodePointAt(mWordHandle, mOutputtedLength - 1 - id);
     }
 
-    // TODO: Move to private
-    int mWordBuf[MAX_WORD_LENGTH];
+    // Writes the first "length" code points of the current word to dest.
+    void outputCodePoints(const int length, int *const dest) const {
+        mWordStore->getCodePoints(mWordHandle, mOutputtedLength - length, length, dest);
+    }
+
+    // Returns the handle of the "length"-th code point of the current word, which the output
+    // of a following word is chained to.
+    int getWordHandleAt(const int length) const {
+        if (length >= mOutputtedLength) {
+            return mWordHandle;
+        }
+        return mWordStore->getPrecedingHandle(mWordHandle, mOutputtedLength - length);
+    }
+
+    // Compares the first "length" code points of the current words in lexicographic order.
+    AK_FORCE_INLINE int compareCodePoints(const DicNodeStateOutput *const other,
+            const int length) const {
+        const int leadingLength = min(length, static_cast<int>(LEADING_CODE_POINTS_SIZE));
+        for (int i = 0; i < leadingLength; ++i) {
+            if (mLeadingCodePoints[i] != other->mLeadingCodePoints[i]) {
+                return mLeadingCodePoints[i] - other->mLeadingCodePoints[i];
+            }
+        }
+        if (length <= LEADING_CODE_POINTS_SIZE) {
+            return 0;
+        }
+        return mWordStore->compareCodePoints(getWordHandleAt(length),
+                other->getWordHandleAt(length), length - LEADING_CODE_POINTS_SIZE);
+    }
+
+    DicNodeWordStore *getWordStore() const {
+        return mWordStore;
+    }
+
+    // Re-chains the current word after prevWordHandle, e.g. after the previous words have been
+    // truncated.
+    void rebase(const int prevWordHandle) {
+        mWordHandle = mWordStore->appendCopy(mWordHandle, mOutputtedLength, prevWordHandle);
+    }
+
+    void relocate(const int prevWordHandle) {
+        mWordHandle = mWordStore->relocate(mWordHandle, mOutputtedLength, prevWordHandle);
+    }
+
+    void setOverlayWordStore(DicNodeWordStore *const wordStore) {
+        ASSERT(wordStore->getBaseStore() == mWordStore);
+        mWordStore = wordStore;
+    }
+
+    void moveToBaseStore() {
+        mWordHandle = mWordStore->moveToBaseStore(mWordHandle);
+        mWordStore = mWordStore->getBaseStore();
+    }
 
  private:
-    // Caution!!!
-    // Use a default copy constructor and an assign operator because shallow copies are ok
-    // for this class
+    // The first code points are also kept here since dicNodes are constantly compared by them
+    // while they are in priority queues.
+    static const int LEADING_CODE_POINTS_SIZE = 4;
+
+    int mLeadingCodePoints[LEADING_CODE_POINTS_SIZE];
+    DicNodeWordStore *mWordStore;
+    int mWordHandle;
     uint16_t mOutputtedLength;
 };
 } // namespace latinime
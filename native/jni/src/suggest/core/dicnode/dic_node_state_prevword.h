@@ -21,7 +21,7 @@
 #include <stdint.h>
 
 #include "defines.h"
-#include "dic_node_utils.h"
+#include "dic_node_word_store.h"
 
 namespace latinime {
 
@@ -29,8 +29,7 @@ class DicNodeStatePrevWord {
  public:
     AK_FORCE_INLINE DicNodeStatePrevWord()
             : mPrevWordCount(0), mPrevWordLength(0), mPrevWordStart(0), mPrevWordProbability(0),
-              mPrevWordNodePos(0) {
-        memset(mPrevWord, 0, sizeof(mPrevWord));
+              mPrevWordNodePos(0), mPrevWordHandle(DicNodeWordStore::EMPTY_WORD_HANDLE) {
         memset(mPrevSpacePositions, 0, sizeof(mPrevSpacePositions));
     }
 
@@ -42,6 +41,7 @@ class DicNodeStatePrevWord {
         mPrevWordStart = 0;
         mPrevWordProbability = -1;
         mPrevWordNodePos = NOT_VALID_WORD;
+        mPrevWordHandle = DicNodeWordStore::EMPTY_WORD_HANDLE;
         memset(mPrevSpacePositions, 0, sizeof(mPrevSpacePositions));
     }
 
@@ -51,6 +51,7 @@ class DicNodeStatePrevWord {
         mPrevWordStart = 0;
         mPrevWordProbability = -1;
         mPrevWordNodePos = prevWordNodePos;
+        mPrevWordHandle = DicNodeWordStore::EMPTY_WORD_HANDLE;
         memset(mPrevSpacePositions, 0, sizeof(mPrevSpacePositions));
     }
 
@@ -61,38 +62,47 @@ class DicNodeStatePrevWord {
         mPrevWordStart = prevWord->mPrevWordStart;
         mPrevWordProbability = prevWord->mPrevWordProbability;
         mPrevWordNodePos = prevWord->mPrevWordNodePos;
-        memcpy(mPrevWord, prevWord->mPrevWord, prevWord->mPrevWordLength * sizeof(mPrevWord[0]));
+        mPrevWordHandle = prevWord->mPrevWordHandle;
         memcpy(mPrevSpacePositions, prevWord->mPrevSpacePositions, sizeof(mPrevSpacePositions));
     }
 
+    // lastWordHandle designates the last code point of the word that is being added, which is
+    // chained after the previous words of the same dicNode in the word store.
     void init(const int16_t prevWordCount, const int16_t prevWordProbability,
-            const int prevWordNodePos, const int *const src0, const int16_t length0,
-            const int *const src1, const int16_t length1, const int *const prevSpacePositions,
-            const int lastInputIndex) {
+            const int prevWordNodePos, DicNodeWordStore *const wordStore,
+            const int lastWordHandle, const int16_t length0, const int16_t length1,
+            const int *const prevSpacePositions, const int lastInputIndex) {
         mPrevWordCount = prevWordCount;
         mPrevWordProbability = prevWordProbability;
         mPrevWordNodePos = prevWordNodePos;
-        const int twoWordsLen =
-                DicNodeUtils::appendTwoWords(src0, length0, src1, length1, mPrevWord);
-        mPrevWord[twoWordsLen] = KEYCODE_SPACE;
+        mPrevWordHandle = wordStore->append(lastWordHandle, KEYCODE_SPACE);
         mPrevWordStart = length0;
-        mPrevWordLength = static_cast<int16_t>(twoWordsLen + 1);
+        mPrevWordLength = static_cast<int16_t>(length0 + length1 + 1);
         memcpy(mPrevSpacePositions, prevSpacePositions, sizeof(mPrevSpacePositions));
         mPrevSpacePositions[mPrevWordCount - 1] = lastInputIndex;
     }
 
-    void truncate(const int offset) {
-        // TODO: memmove
+    void truncate(DicNodeWordStore *const wordStore, const int offset) {
         if (mPrevWordLength < offset) {
-            memset(mPrevWord, 0, sizeof(mPrevWord));
+            mPrevWordHandle = DicNodeWordStore::EMPTY_WORD_HANDLE;
             mPrevWordLength = 0;
             return;
         }
         const int newPrevWordLength = mPrevWordLength - offset;
-        memmove(mPrevWord, &mPrevWord[offset], newPrevWordLength * sizeof(mPrevWord[0]));
+        mPrevWordHandle = wordStore->appendCopy(mPrevWordHandle, newPrevWordLength,
+                DicNodeWordStore::EMPTY_WORD_HANDLE);
         mPrevWordLength = newPrevWordLength;
     }
 
+    void relocate(DicNodeWordStore *const wordStore) {
+        mPrevWordHandle = wordStore->relocate(mPrevWordHandle, mPrevWordLength,
+                DicNodeWordStore::EMPTY_WORD_HANDLE);
+    }
+
+    void moveToBaseStore(DicNodeWordStore *const wordStore) {
+        mPrevWordHandle = wordStore->moveToBaseStore(mPrevWordHandle);
+    }
+
     void outputSpacePositions(int *spaceIndices) const {
         // Convert uint16_t to int
         for (int i = 0; i < MAX_RESULTS; i++) {
@@ -100,6 +110,12 @@ class DicNodeStatePrevWord {
         }
     }
 
+    // Writes the first "length" code points of the previous words to dest.
+    void outputPrevWordCodePoints(const DicNodeWordStore *const wordStore, const int length,
+            int *const dest) const {
+        wordStore->getCodePoints(mPrevWordHandle, mPrevWordLength - length, length, dest);
+    }
+
     // TODO: remove
     int16_t getPrevWordLength() const {
         return mPrevWordLength;
@@ -121,24 +137,10 @@ class DicNodeStatePrevWord {
         return mPrevWordNodePos;
     }
 
-    int getPrevWordCodePointAt(const int id) const {
-        return mPrevWord[id];
+    int getPrevWordHandle() const {
+        return mPrevWordHandle;
     }
 
-    bool startsWith(const DicNodeStatePrevWord *const prefix, const int prefixLen) const {
-        if (prefixLen > mPrevWordLength) {
-            return false;
-        }
-        for (int i = 0; i < prefixLen; ++i) {
-            if (mPrevWord[i] != prefix->mPrevWord[i]) {
-                return false;
-            }
-        }
-        return true;
-    }
-
-    // TODO: Move to private
-    int mPrevWord[MAX_WORD_LENGTH];
     // TODO: Move to private
     int mPrevSpacePositions[MAX_RESULTS];
 
@@ -151,6 +153,8 @@ class DicNodeStatePrevWord {
     int16_t mPrevWordStart;
     int16_t mPrevWordProbability;
     int mPrevWordNodePos;
+    // The previous words live in the word store shared by the dicNodes of the session.
+    int mPrevWordHandle;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODE_STATE_PREVWORD_H
@@ -18,6 +18,8 @@
 #include <vector>
 
 #include "binary_format.h"
+#include "char_group_jump_table.h"
+#include "decoded_trie.h"
 #include "dic_node.h"
 #include "dic_node_utils.h"
 #include "dic_node_vector.h"
@@ -32,12 +34,12 @@ namespace latinime {
 ///////////////////////////////
 
 /* static */ void DicNodeUtils::initAsRoot(const int rootPos, const uint8_t *const dicRoot,
-        const int prevWordNodePos, DicNode *newRootNode) {
+        const int prevWordNodePos, DicNodeWordStore *const wordStore, DicNode *newRootNode) {
     int curPos = rootPos;
     const int pos = curPos;
     const int childrenCount = BinaryFormat::getGroupCountAndForwardPointer(dicRoot, &curPos);
     const int childrenPos = curPos;
-    newRootNode->initAsRoot(pos, childrenPos, childrenCount, prevWordNodePos);
+    newRootNode->initAsRoot(pos, childrenPos, childrenCount, prevWordNodePos, wordStore);
 }
 
 /*static */ void DicNodeUtils::initAsRootWithPreviousWord(const int rootPos,
@@ -118,6 +120,32 @@ namespace latinime {
     return siblingPos;
 }
 
+// Same as createAndGetLeavingChildNode(), for the char group at index in the decoded trie.
+/* static */ void DicNodeUtils::createAndGetDecodedLeavingChildNode(DicNode *dicNode,
+        const DecodedTrie *const decodedTrie, const int index,
+        const ProximityInfoState *pInfoState, const int pointIndex, const bool exactOnly,
+        const std::vector<int> *const codePointsFilter, const ProximityInfo *const pInfo,
+        DicNodeVector *childDicNodes) {
+    const int *const codePoints = decodedTrie->getCodePoints(index);
+    const int nodeCodePoint = codePoints[0];
+    if (isDicNodeFilteredOut(nodeCodePoint, pInfo, codePointsFilter)) {
+        return;
+    }
+    if (!isMatchedNodeCodePoint(pInfoState, pointIndex, exactOnly, nodeCodePoint)) {
+        return;
+    }
+    const uint8_t flags = decodedTrie->getFlags(index);
+    const bool isTerminal = (0 != (BinaryFormat::FLAG_IS_TERMINAL & flags));
+    const int childrenCount = decodedTrie->getChildrenCount(index);
+    childDicNodes->pushLeavingChild(dicNode, decodedTrie->getPosition(index), flags,
+            decodedTrie->getChildrenPosition(index), decodedTrie->getAttributesPosition(index),
+            decodedTrie->getSiblingPosition(index), nodeCodePoint, childrenCount,
+            isTerminal ? decodedTrie->getProbability(index) : -1, -1 /* bigramProbability */,
+            isTerminal, 0 != (BinaryFormat::FLAG_HAS_MULTIPLE_CHARS & flags),
+            BinaryFormat::hasChildrenInFlags(flags),
+            static_cast<uint16_t>(decodedTrie->getCodePointCount(index)), codePoints);
+}
+
 /* static */ bool DicNodeUtils::isDicNodeFilteredOut(const int nodeCodePoint,
         const ProximityInfo *const pInfo, const std::vector<int> *const codePointsFilter) {
     const int filterSize = codePointsFilter ? codePointsFilter->size() : 0;
@@ -147,11 +175,33 @@ namespace latinime {
 }
 
 /* static */ void DicNodeUtils::createAndGetAllLeavingChildNodes(DicNode *dicNode,
-        const uint8_t *const dicRoot, const ProximityInfoState *pInfoState, const int pointIndex,
-        const bool exactOnly, const std::vector<int> *const codePointsFilter,
+        const uint8_t *const dicRoot, const DecodedTrie *const decodedTrie,
+        const CharGroupJumpTable *const jumpTable, const ProximityInfoState *pInfoState,
+        const int pointIndex, const bool exactOnly, const std::vector<int> *const codePointsFilter,
         const ProximityInfo *const pInfo, DicNodeVector *childDicNodes) {
     const int terminalDepth = dicNode->getLeavingDepth();
     const int childCount = dicNode->getChildrenCount();
+    if (decodedTrie) {
+        // The children are consecutive in the decoded trie, and cheap enough to read that there
+        // is no need for the jump table.
+        const int firstChildIndex = decodedTrie->getCharGroupIndex(dicNode->getChildrenPos());
+        for (int i = 0; i < childCount; i++) {
+            const int filterSize = codePointsFilter ? codePointsFilter->size() : 0;
+            createAndGetDecodedLeavingChildNode(dicNode, decodedTrie, firstChildIndex + i,
+                    pInfoState, pointIndex, exactOnly, codePointsFilter, pInfo, childDicNodes);
+            if (!pInfo && filterSize > 0 && childDicNodes->exceeds(filterSize)) {
+                // All code points have been found.
+                break;
+            }
+        }
+        return;
+    }
+    if (jumpTable && pInfoState && !codePointsFilter
+            && CharGroupJumpTable::isWorthIndexing(childCount)
+            && createAndGetMatchedLeavingChildNodes(dicNode, dicRoot, jumpTable, terminalDepth,
+                    pInfoState, pointIndex, exactOnly, childDicNodes)) {
+        return;
+    }
     int nextPos = dicNode->getChildrenPos();
     for (int i = 0; i < childCount; i++) {
         const int filterSize = codePointsFilter ? codePointsFilter->size() : 0;
@@ -164,14 +214,62 @@ namespace latinime {
     }
 }
 
+// Same as createAndGetAllLeavingChildNodes() without a filter, but only reads the children that
+// may match the touch point, as found in the jump table. Returns false without creating any child
+// if the node isn't in the jump table or if there are too many of them, in which case all the
+// children have to be read instead.
+/* static */ bool DicNodeUtils::createAndGetMatchedLeavingChildNodes(DicNode *dicNode,
+        const uint8_t *const dicRoot, const CharGroupJumpTable *const jumpTable,
+        const int terminalDepth, const ProximityInfoState *pInfoState, const int pointIndex,
+        const bool exactOnly, DicNodeVector *childDicNodes) {
+    int baseLowerCodePoints[ProximityInfoState::MAX_PROXIMITY_BASE_LOWER_CODE_POINTS];
+    int baseLowerCodePointCount = 0;
+    if (exactOnly) {
+        baseLowerCodePoints[baseLowerCodePointCount++] =
+                toBaseLowerCase(pInfoState->getPrimaryCodePointAt(pointIndex));
+    } else {
+        baseLowerCodePointCount =
+                pInfoState->getProximityBaseLowerCodePoints(pointIndex, baseLowerCodePoints);
+    }
+    int distinctCodePointCount = 0;
+    for (int i = 0; i < baseLowerCodePointCount; ++i) {
+        bool isDuplicate = false;
+        for (int j = 0; j < distinctCodePointCount; ++j) {
+            if (baseLowerCodePoints[j] == baseLowerCodePoints[i]) {
+                isDuplicate = true;
+                break;
+            }
+        }
+        if (!isDuplicate) {
+            baseLowerCodePoints[distinctCodePointCount++] = baseLowerCodePoints[i];
+        }
+    }
+    int charGroupPositions[MAX_CHAR_GROUPS_READ_FROM_JUMP_TABLE];
+    // Children are returned in the order of the dictionary, as they are expected.
+    const int charGroupCount = jumpTable->getCharGroupPositions(dicNode->getChildrenPos(),
+            dicNode->getChildrenCount(), baseLowerCodePoints, distinctCodePointCount,
+            MAX_CHAR_GROUPS_READ_FROM_JUMP_TABLE, charGroupPositions);
+    if (NOT_AN_INDEX == charGroupCount) {
+        return false;
+    }
+    for (int i = 0; i < charGroupCount; ++i) {
+        createAndGetLeavingChildNode(dicNode, charGroupPositions[i], dicRoot, terminalDepth,
+                pInfoState, pointIndex, exactOnly, 0 /* codePointsFilter */, 0 /* pInfo */,
+                childDicNodes);
+    }
+    return true;
+}
+
 /* static */ void DicNodeUtils::getAllChildDicNodes(DicNode *dicNode, const uint8_t *const dicRoot,
-        DicNodeVector *childDicNodes) {
-    getProximityChildDicNodes(dicNode, dicRoot, 0, 0, false, childDicNodes);
+        const DecodedTrie *const decodedTrie, DicNodeVector *childDicNodes) {
+    getProximityChildDicNodes(dicNode, dicRoot, decodedTrie, 0 /* jumpTable */,
+            0 /* pInfoState */, 0 /* pointIndex */, false /* exactOnly */, childDicNodes);
 }
 
 /* static */ void DicNodeUtils::getProximityChildDicNodes(DicNode *dicNode,
-        const uint8_t *const dicRoot, const ProximityInfoState *pInfoState, const int pointIndex,
-        bool exactOnly, DicNodeVector *childDicNodes) {
+        const uint8_t *const dicRoot, const DecodedTrie *const decodedTrie,
+        const CharGroupJumpTable *const jumpTable, const ProximityInfoState *pInfoState,
+        const int pointIndex, bool exactOnly, DicNodeVector *childDicNodes) {
     if (dicNode->isTotalInputSizeExceedingLimit()) {
         return;
     }
@@ -179,8 +277,8 @@ namespace latinime {
         DicNodeUtils::createAndGetPassingChildNode(dicNode, pInfoState, pointIndex, exactOnly,
                 childDicNodes);
     } else {
-        DicNodeUtils::createAndGetAllLeavingChildNodes(dicNode, dicRoot, pInfoState, pointIndex,
-                exactOnly, 0 /* codePointsFilter */, 0 /* pInfo */,
+        DicNodeUtils::createAndGetAllLeavingChildNodes(dicNode, dicRoot, decodedTrie, jumpTable,
+                pInfoState, pointIndex, exactOnly, 0 /* codePointsFilter */, 0 /* pInfo */,
                 childDicNodes);
     }
 }
@@ -203,6 +301,26 @@ namespace latinime {
     return cost;
 }
 
+/**
+ * Computes a lower bound of the improbability of the words ending in the subtree of the given
+ * dicNode, itself included. Only valid for dictionaries storing the max probabilities of subtrees.
+ */
+/* static */ float DicNodeUtils::getMinBigramNodeImprobabilityInSubtree(
+        const uint8_t *const dicRoot, const DicNode *const node) {
+    int maxProbability = node->getProbability();
+    if (node->hasChildren()) {
+        maxProbability = max(maxProbability, BinaryFormat::readSubtreeMaxProbability(
+                dicRoot, node->getChildrenPos(), node->getChildrenCount()));
+    }
+    if (NOT_VALID_WORD != node->getPos() && NOT_VALID_WORD != node->getPrevWordPos()) {
+        // A bigram raises the probability by at most the highest encoded bigram probability.
+        maxProbability = BinaryFormat::computeProbabilityForBigram(
+                maxProbability, MAX_BIGRAM_ENCODED_PROBABILITY);
+    }
+    return static_cast<float>(MAX_PROBABILITY - maxProbability)
+            / static_cast<float>(MAX_PROBABILITY);
+}
+
 /* static */ int DicNodeUtils::getBigramNodeProbability(const uint8_t *const dicRoot,
         const DicNode *const node, MultiBigramMap *multiBigramMap) {
     const int unigramProbability = node->getProbability();
@@ -24,8 +24,11 @@
 
 namespace latinime {
 
+class CharGroupJumpTable;
+class DecodedTrie;
 class DicNode;
 class DicNodeVector;
+class DicNodeWordStore;
 class ProximityInfo;
 class ProximityInfoState;
 class MultiBigramMap;
@@ -35,18 +38,22 @@ class DicNodeUtils {
     static int appendTwoWords(const int *src0, const int16_t length0, const int *src1,
             const int16_t length1, int *dest);
     static void initAsRoot(const int rootPos, const uint8_t *const dicRoot,
-            const int prevWordNodePos, DicNode *newRootNode);
+            const int prevWordNodePos, DicNodeWordStore *const wordStore, DicNode *newRootNode);
     static void initAsRootWithPreviousWord(const int rootPos, const uint8_t *const dicRoot,
             DicNode *prevWordLastNode, DicNode *newRootNode);
     static void initByCopy(DicNode *srcNode, DicNode *destNode);
+    // Reads the children from decodedTrie if it's not null, or from the dictionary otherwise.
     static void getAllChildDicNodes(DicNode *dicNode, const uint8_t *const dicRoot,
-            DicNodeVector *childDicNodes);
+            const DecodedTrie *const decodedTrie, DicNodeVector *childDicNodes);
     static float getBigramNodeImprobability(const uint8_t *const dicRoot,
             const DicNode *const node, MultiBigramMap *const multiBigramMap);
+    static float getMinBigramNodeImprobabilityInSubtree(const uint8_t *const dicRoot,
+            const DicNode *const node);
     static bool isDicNodeFilteredOut(const int nodeCodePoint, const ProximityInfo *const pInfo,
             const std::vector<int> *const codePointsFilter);
     // TODO: Move to private
     static void getProximityChildDicNodes(DicNode *dicNode, const uint8_t *const dicRoot,
+            const DecodedTrie *const decodedTrie, const CharGroupJumpTable *const jumpTable,
             const ProximityInfoState *pInfoState, const int pointIndex, bool exactOnly,
             DicNodeVector *childDicNodes);
 
@@ -59,19 +66,31 @@ class DicNodeUtils {
     DISALLOW_IMPLICIT_CONSTRUCTORS(DicNodeUtils);
     // Max number of bigrams to look up
     static const int MAX_BIGRAMS_CONSIDERED_PER_CONTEXT = 500;
+    // Max number of children read from the jump table for a touch point
+    static const int MAX_CHAR_GROUPS_READ_FROM_JUMP_TABLE = 64;
 
     static int getBigramNodeProbability(const uint8_t *const dicRoot, const DicNode *const node,
             MultiBigramMap *multiBigramMap);
     static void createAndGetPassingChildNode(DicNode *dicNode, const ProximityInfoState *pInfoState,
             const int pointIndex, const bool exactOnly, DicNodeVector *childDicNodes);
     static void createAndGetAllLeavingChildNodes(DicNode *dicNode, const uint8_t *const dicRoot,
+            const DecodedTrie *const decodedTrie, const CharGroupJumpTable *const jumpTable,
             const ProximityInfoState *pInfoState, const int pointIndex, const bool exactOnly,
             const std::vector<int> *const codePointsFilter,
             const ProximityInfo *const pInfo, DicNodeVector *childDicNodes);
+    static bool createAndGetMatchedLeavingChildNodes(DicNode *dicNode,
+            const uint8_t *const dicRoot, const CharGroupJumpTable *const jumpTable,
+            const int terminalDepth, const ProximityInfoState *pInfoState, const int pointIndex,
+            const bool exactOnly, DicNodeVector *childDicNodes);
     static int createAndGetLeavingChildNode(DicNode *dicNode, int pos, const uint8_t *const dicRoot,
             const int terminalDepth, const ProximityInfoState *pInfoState, const int pointIndex,
             const bool exactOnly, const std::vector<int> *const codePointsFilter,
             const ProximityInfo *const pInfo, DicNodeVector *childDicNodes);
+    static void createAndGetDecodedLeavingChildNode(DicNode *dicNode,
+            const DecodedTrie *const decodedTrie, const int index,
+            const ProximityInfoState *pInfoState, const int pointIndex, const bool exactOnly,
+            const std::vector<int> *const codePointsFilter, const ProximityInfo *const pInfo,
+            DicNodeVector *childDicNodes);
 
     // TODO: Move to proximity info
     static bool isMatchedNodeCodePoint(const ProximityInfoState *pInfoState, const int pointIndex,
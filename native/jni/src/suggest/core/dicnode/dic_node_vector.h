@@ -17,49 +17,46 @@
 #ifndef LATINIME_DIC_NODE_VECTOR_H
 #define LATINIME_DIC_NODE_VECTOR_H
 
-#include <vector>
-
 #include "defines.h"
 #include "dic_node.h"
+#include "dic_node_arena.h"
 
 namespace latinime {
 
+/**
+ * Vector of child dicNodes. Its dicNodes are allocated from a DicNodeArena and initialized in
+ * place. Vectors sharing an arena must be destroyed in the reverse order of their creation.
+ */
 class DicNodeVector {
  public:
-#ifdef FLAG_DBG
-    // 0 will introduce resizing the vector.
-    static const int DEFAULT_NODES_SIZE_FOR_OPTIMIZATION = 0;
-#else
-    static const int DEFAULT_NODES_SIZE_FOR_OPTIMIZATION = 60;
-#endif
-    AK_FORCE_INLINE DicNodeVector() : mDicNodes(0), mLock(false), mEmptyNode() {}
-
-    // Specify the capacity of the vector
-    AK_FORCE_INLINE DicNodeVector(const int size) : mDicNodes(0), mLock(false), mEmptyNode() {
-        mDicNodes.reserve(size);
-    }
+    AK_FORCE_INLINE explicit DicNodeVector(DicNodeArena *const arena)
+            : mArena(arena), mArenaBlockIndex(arena->getBlockIndex()),
+              mArenaUsedSizeInBlock(arena->getUsedSizeInBlock()), mDicNodes(0), mSize(0),
+              mLock(false) {}
 
     // Non virtual inline destructor -- never inherit this class
-    AK_FORCE_INLINE ~DicNodeVector() {}
+    AK_FORCE_INLINE ~DicNodeVector() {
+        mArena->rollback(mArenaBlockIndex, mArenaUsedSizeInBlock);
+    }
 
     AK_FORCE_INLINE void clear() {
-        mDicNodes.clear();
+        mArena->rollback(mArenaBlockIndex, mArenaUsedSizeInBlock);
+        mSize = 0;
         mLock = false;
     }
 
     int getSizeAndLock() {
         mLock = true;
-        return static_cast<int>(mDicNodes.size());
+        return mSize;
     }
 
     bool exceeds(const size_t limit) const {
-        return mDicNodes.size() >= limit;
+        return static_cast<size_t>(mSize) >= limit;
     }
 
     void pushPassingChild(DicNode *dicNode) {
         ASSERT(!mLock);
-        mDicNodes.push_back(mEmptyNode);
-        mDicNodes.back().initAsPassingChild(dicNode);
+        allocate()->initAsPassingChild(dicNode);
     }
 
     void pushLeavingChild(DicNode *dicNode, const int pos, const uint8_t flags,
@@ -69,27 +66,37 @@ class DicNodeVector {
             const bool hasChildren, const uint16_t additionalSubwordLength,
             const int *additionalSubword) {
         ASSERT(!mLock);
-        mDicNodes.push_back(mEmptyNode);
-        mDicNodes.back().initAsChild(dicNode, pos, flags, childrenPos, attributesPos, siblingPos,
+        allocate()->initAsChild(dicNode, pos, flags, childrenPos, attributesPos, siblingPos,
                 nodeCodePoint, childrenCount, probability, -1 /* bigramProbability */, isTerminal,
                 hasMultipleChars, hasChildren, additionalSubwordLength, additionalSubword);
     }
 
     DicNode *operator[](const int id) {
-        ASSERT(id < static_cast<int>(mDicNodes.size()));
+        ASSERT(id < mSize);
         return &mDicNodes[id];
     }
 
     DicNode *front() {
-        ASSERT(1 <= static_cast<int>(mDicNodes.size()));
+        ASSERT(1 <= mSize);
         return &mDicNodes[0];
     }
 
  private:
-    DISALLOW_COPY_AND_ASSIGN(DicNodeVector);
-    std::vector<DicNode> mDicNodes;
+    DISALLOW_IMPLICIT_CONSTRUCTORS(DicNodeVector);
+
+    AK_FORCE_INLINE DicNode *allocate() {
+        DicNode *const dicNode = mArena->extend(&mDicNodes, mSize);
+        ++mSize;
+        return dicNode;
+    }
+
+    DicNodeArena *const mArena;
+    // Position of the arena when this vector was created
+    const int mArenaBlockIndex;
+    const int mArenaUsedSizeInBlock;
+    DicNode *mDicNodes;
+    int mSize;
     bool mLock;
-    DicNode mEmptyNode;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODE_VECTOR_H
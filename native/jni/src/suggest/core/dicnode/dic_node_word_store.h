@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_WORD_STORE_H
+#define LATINIME_DIC_NODE_WORD_STORE_H
+
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Store of the code points output by dicNodes, shared by all the dicNodes of a session.
+ * Each entry holds a code point and the handle of the entry preceding it, so a dicNode only
+ * keeps the handle of the last code point it output and children share the prefix of their
+ * parent instead of copying it. Words are materialized only when they are actually read.
+ * Entries are never removed during a search; the store is cleared when the search restarts
+ * from the root, and compacted by relocating the words of the dicNodes that survive a
+ * continued search.
+ * A store can also be used as an overlay of another one, its base store: the overlay reads the
+ * entries the base store had when the overlay was set up and appends new entries to itself, so
+ * several threads can extend the words of the base store without modifying it. The words are
+ * moved to the base store afterwards, once the threads are done.
+ */
+class DicNodeWordStore {
+ public:
+    static const int EMPTY_WORD_HANDLE = -1;
+
+    DicNodeWordStore()
+            : mEntries(), mRelocatingEntries(), mBaseStore(0), mBaseSize(0), mBaseHandles() {}
+
+    // Non virtual inline destructor -- never inherit this class
+    ~DicNodeWordStore() {}
+
+    void clear() {
+        mEntries.clear();
+    }
+
+    AK_FORCE_INLINE int append(const int parentHandle, const int codePoint) {
+        mEntries.push_back(Entry(codePoint, parentHandle));
+        return mBaseSize + static_cast<int>(mEntries.size()) - 1;
+    }
+
+    AK_FORCE_INLINE int append(int handle, const int *const codePoints, const int length) {
+        for (int i = 0; i < length; ++i) {
+            handle = append(handle, codePoints[i]);
+        }
+        return handle;
+    }
+
+    // Appends a copy of the last "length" code points of the word ending at "handle".
+    int appendCopy(const int handle, const int length, const int parentHandle) {
+        int codePoints[MAX_WORD_LENGTH];
+        getCodePoints(handle, 0 /* skipCount */, length, codePoints);
+        return append(parentHandle, codePoints, length);
+    }
+
+    // Returns the handle of the entry located "distance" entries before the one designated by
+    // "handle".
+    AK_FORCE_INLINE int getPrecedingHandle(int handle, const int distance) const {
+        for (int i = 0; i < distance; ++i) {
+            handle = getEntry(handle).mParentHandle;
+        }
+        return handle;
+    }
+
+    // Returns the code point located "distance" entries before the one designated by "handle".
+    AK_FORCE_INLINE int getCodePointAt(const int handle, const int distance) const {
+        return getEntry(getPrecedingHandle(handle, distance)).mCodePoint;
+    }
+
+    // Writes the "length" code points preceding the last "skipCount" ones of the word ending at
+    // "handle" to dest.
+    AK_FORCE_INLINE void getCodePoints(const int handle, const int skipCount, const int length,
+            int *const dest) const {
+        int currentHandle = getPrecedingHandle(handle, skipCount);
+        for (int i = length - 1; i >= 0; --i) {
+            const Entry &entry = getEntry(currentHandle);
+            dest[i] = entry.mCodePoint;
+            currentHandle = entry.mParentHandle;
+        }
+    }
+
+    // Compares the "length" code points ending at handle0 and handle1 in lexicographic order,
+    // and returns a negative value, 0 or a positive value like memcmp(). Words are walked from
+    // their ends until they join, so shared prefixes are never read.
+    AK_FORCE_INLINE int compareCodePoints(int handle0, int handle1, const int length) const {
+        int result = 0;
+        for (int i = 0; i < length && handle0 != handle1; ++i) {
+            const Entry &entry0 = getEntry(handle0);
+            const Entry &entry1 = getEntry(handle1);
+            if (entry0.mCodePoint != entry1.mCodePoint) {
+                result = entry0.mCodePoint - entry1.mCodePoint;
+            }
+            handle0 = entry0.mParentHandle;
+            handle1 = entry1.mParentHandle;
+        }
+        return result;
+    }
+
+    // Relocation moves the words that are still referenced to a fresh generation of entries so
+    // that the entries of discarded dicNodes can be dropped. Between beginRelocation() and
+    // endRelocation(), the handles of every word still in use must be passed to relocate() and
+    // replaced with the returned ones.
+    void beginRelocation() {
+        mRelocatingEntries.swap(mEntries);
+        mEntries.clear();
+    }
+
+    int relocate(const int handle, const int length, const int parentHandle) {
+        int codePoints[MAX_WORD_LENGTH];
+        int currentHandle = handle;
+        for (int i = length - 1; i >= 0; --i) {
+            const Entry &entry = mRelocatingEntries[currentHandle];
+            codePoints[i] = entry.mCodePoint;
+            currentHandle = entry.mParentHandle;
+        }
+        return append(parentHandle, codePoints, length);
+    }
+
+    void endRelocation() {
+        mRelocatingEntries.clear();
+    }
+
+    // Makes this store an empty overlay of baseStore, which must not be an overlay itself.
+    // baseStore must not be modified until the words of the overlay start being moved to it.
+    void setBaseStore(DicNodeWordStore *const baseStore) {
+        ASSERT(!baseStore->mBaseStore);
+        mEntries.clear();
+        mBaseHandles.clear();
+        mBaseStore = baseStore;
+        mBaseSize = static_cast<int>(baseStore->mEntries.size());
+    }
+
+    DicNodeWordStore *getBaseStore() const {
+        return mBaseStore;
+    }
+
+    // Copies the entries of the word ending at "handle" that belong to this overlay to the base
+    // store, and returns the handle of the word in the base store. Entries shared by several
+    // words are only copied once. Appending to the base store is allowed from the first call on.
+    int moveToBaseStore(const int handle) {
+        if (handle < mBaseSize) {
+            return handle;
+        }
+        if (mBaseHandles.size() < mEntries.size()) {
+            mBaseHandles.resize(mEntries.size(), EMPTY_WORD_HANDLE);
+        }
+        const int index = handle - mBaseSize;
+        if (mBaseHandles[index] == EMPTY_WORD_HANDLE) {
+            const Entry &entry = mEntries[index];
+            const int parentHandle = moveToBaseStore(entry.mParentHandle);
+            mBaseHandles[index] = mBaseStore->append(parentHandle, entry.mCodePoint);
+        }
+        return mBaseHandles[index];
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicNodeWordStore);
+
+    struct Entry {
+        Entry(const int codePoint, const int parentHandle)
+                : mCodePoint(codePoint), mParentHandle(parentHandle) {}
+        int mCodePoint;
+        int mParentHandle;
+    };
+
+    // Entries of the base store come first in the handle space of an overlay.
+    AK_FORCE_INLINE const Entry &getEntry(const int handle) const {
+        return handle < mBaseSize ? mBaseStore->mEntries[handle] : mEntries[handle - mBaseSize];
+    }
+
+    std::vector<Entry> mEntries;
+    std::vector<Entry> mRelocatingEntries;
+    DicNodeWordStore *mBaseStore;
+    // Number of entries of the base store, which the handles of this store start after.
+    int mBaseSize;
+    // Handles in the base store of the entries of this overlay that have been moved there.
+    std::vector<int> mBaseHandles;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_WORD_STORE_H
@@ -24,14 +24,17 @@
 namespace latinime {
 
 /**
- * Truncates all of the dicNodes so that they start at the given commit point.
+ * Truncates all of the dicNodes of the checkpoint taken at inputIndex so that they start at the
+ * given commit point.
  * Only called for multi-word typing input.
  */
-DicNode *DicNodesCache::setCommitPoint(int commitPoint) {
+DicNode *DicNodesCache::setCommitPoint(const int inputIndex, int commitPoint) {
+    DicNodePriorityQueue *const checkpointDicNodes =
+            mCheckpointDicNodes[getCheckpointIndex(inputIndex)];
     std::list<DicNode> dicNodesList;
-    while (mCachedDicNodesForContinuousSuggestion->getSize() > 0) {
+    while (checkpointDicNodes->getSize() > 0) {
         DicNode dicNode;
-        mCachedDicNodesForContinuousSuggestion->copyPop(&dicNode);
+        checkpointDicNodes->copyPop(&dicNode);
         dicNodesList.push_front(dicNode);
     }
 
@@ -46,7 +49,7 @@ DicNode *DicNodesCache::setCommitPoint(int commitPoint) {
     for (iter = dicNodesList.begin(); iter != dicNodesList.end(); iter++) {
         DicNode *dicNode = &*iter;
         if (dicNode->truncateNode(&topDicNodeCopy, commitPoint)) {
-            mCachedDicNodesForContinuousSuggestion->copyPush(dicNode);
+            checkpointDicNodes->copyPush(dicNode);
         } else {
             // Top dicNode should be reprocessed.
             ASSERT(dicNode != topDicNode);
@@ -20,13 +20,19 @@
 #include <stdint.h>
 
 #include "defines.h"
+#include "dic_node_pool.h"
 #include "dic_node_priority_queue.h"
+#include "dic_node_utils.h"
+#include "dic_node_word_store.h"
 
 #define INITIAL_QUEUE_ID_ACTIVE 0
 #define INITIAL_QUEUE_ID_NEXT_ACTIVE 1
 #define INITIAL_QUEUE_ID_TERMINAL 2
-#define INITIAL_QUEUE_ID_CACHE_FOR_CONTINUOUS_SUGGESTION 3
-#define PRIORITY_QUEUES_SIZE 4
+#define INITIAL_QUEUE_ID_CHECKPOINTS 3
+// The active dicNodes of the last input indices are kept to resume the next search from. Each
+// checkpoint holds at most the next active dicNodes of a search.
+#define MAX_DIC_NODES_CHECKPOINT_COUNT 8
+#define PRIORITY_QUEUES_SIZE (INITIAL_QUEUE_ID_CHECKPOINTS + MAX_DIC_NODES_CHECKPOINT_COUNT)
 
 namespace latinime {
 
@@ -38,28 +44,97 @@ class DicNode;
 class DicNodesCache {
  public:
     AK_FORCE_INLINE DicNodesCache()
-            : mActiveDicNodes(&mDicNodePriorityQueues[INITIAL_QUEUE_ID_ACTIVE]),
+            : mDicNodePool(), mActiveDicNodes(&mDicNodePriorityQueues[INITIAL_QUEUE_ID_ACTIVE]),
               mNextActiveDicNodes(&mDicNodePriorityQueues[INITIAL_QUEUE_ID_NEXT_ACTIVE]),
               mTerminalDicNodes(&mDicNodePriorityQueues[INITIAL_QUEUE_ID_TERMINAL]),
-              mCachedDicNodesForContinuousSuggestion(
-                      &mDicNodePriorityQueues[INITIAL_QUEUE_ID_CACHE_FOR_CONTINUOUS_SUGGESTION]),
-              mInputIndex(0), mLastCachedInputIndex(0) {
+              mCheckpointDicNodes(), mCheckpointInputIndices(), mCurrentCheckpointDicNodes(0),
+              mWordStore(), mInputIndex(0),
+              mTerminalPruningDistance(static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
+        for (int i = 0; i < PRIORITY_QUEUES_SIZE; ++i) {
+            mDicNodePriorityQueues[i].setDicNodePool(&mDicNodePool);
+        }
+        for (int i = 0; i < MAX_DIC_NODES_CHECKPOINT_COUNT; ++i) {
+            mCheckpointDicNodes[i] = &mDicNodePriorityQueues[INITIAL_QUEUE_ID_CHECKPOINTS + i];
+            mCheckpointInputIndices[i] = NOT_AN_INDEX;
+        }
     }
 
     AK_FORCE_INLINE virtual ~DicNodesCache() {}
 
     AK_FORCE_INLINE void reset(const int nextActiveSize, const int terminalSize) {
         mInputIndex = 0;
-        mLastCachedInputIndex = 0;
+        // The active queue is bounded by the capacity of a queue and the other queues by their
+        // own sizes, the checkpoints holding at most as many dicNodes as the next active queue.
+        // On top of that, the dicNode being expanded and a new dicNode that has yet to evict a
+        // queued one may be alive.
+        const int nextActiveMaxSize = min(nextActiveSize, MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY);
+        mDicNodePool.reset(MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY
+                + nextActiveMaxSize * (MAX_DIC_NODES_CHECKPOINT_COUNT + 1)
+                + min(terminalSize, MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY) + 2);
         mActiveDicNodes->reset();
+        mActiveDicNodes->setRecombinesDicNodes(false);
         mNextActiveDicNodes->clearAndResize(nextActiveSize);
+        mNextActiveDicNodes->setRecombinesDicNodes(true);
         mTerminalDicNodes->clearAndResize(terminalSize);
-        mCachedDicNodesForContinuousSuggestion->reset();
+        for (int i = 0; i < MAX_DIC_NODES_CHECKPOINT_COUNT; ++i) {
+            mCheckpointDicNodes[i]->clearAndResize(nextActiveMaxSize);
+            mCheckpointDicNodes[i]->setRecombinesDicNodes(false);
+            mCheckpointInputIndices[i] = NOT_AN_INDEX;
+        }
+        mCurrentCheckpointDicNodes = 0;
+        mWordStore.clear();
+        mTerminalPruningDistance = static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
     }
 
-    AK_FORCE_INLINE void continueSearch() {
+    // Resumes the search from the checkpoint taken at inputIndex, which has to be one returned
+    // by getLatestCheckpointInputIndex(). The later checkpoints are dropped as they were taken
+    // for an input that differs from now on.
+    AK_FORCE_INLINE void continueSearch(const int inputIndex) {
         resetTemporaryCaches();
-        restoreActiveDicNodesFromCache();
+        for (int i = 0; i < MAX_DIC_NODES_CHECKPOINT_COUNT; ++i) {
+            if (mCheckpointInputIndices[i] > inputIndex) {
+                discardCheckpoint(i);
+            }
+        }
+        restoreActiveDicNodesFromCheckpoint(inputIndex);
+        compactWordStore();
+    }
+
+    // Returns the largest input index up to maxInputIndex that a checkpoint was taken at, or
+    // NOT_AN_INDEX if there is none.
+    int getLatestCheckpointInputIndex(const int maxInputIndex) const {
+        int latestInputIndex = NOT_AN_INDEX;
+        for (int i = 0; i < MAX_DIC_NODES_CHECKPOINT_COUNT; ++i) {
+            const int inputIndex = mCheckpointInputIndices[i];
+            if (inputIndex != NOT_AN_INDEX && inputIndex <= maxInputIndex
+                    && inputIndex > latestInputIndex
+                    && mCheckpointDicNodes[i]->getSize() > 0) {
+                latestInputIndex = inputIndex;
+            }
+        }
+        return latestInputIndex;
+    }
+
+    // Drops all the checkpoints, for instance when the next search does not share its context
+    // with the previous one.
+    AK_FORCE_INLINE void discardCheckpoints() {
+        for (int i = 0; i < MAX_DIC_NODES_CHECKPOINT_COUNT; ++i) {
+            discardCheckpoint(i);
+        }
+    }
+
+    // Returns whether the current input index is far enough from the end of the input for the
+    // next search to resume from it.
+    AK_FORCE_INLINE bool canTakeCheckpoint(const int inputSize) const {
+        return mInputIndex <= inputSize - DIC_NODES_CHECKPOINT_BACK_LENGTH;
+    }
+
+    // Starts the checkpoint of the current input index, which replaces the oldest one.
+    AK_FORCE_INLINE void beginCheckpoint() {
+        const int checkpointIndex = mInputIndex % MAX_DIC_NODES_CHECKPOINT_COUNT;
+        discardCheckpoint(checkpointIndex);
+        mCheckpointInputIndices[checkpointIndex] = mInputIndex;
+        mCurrentCheckpointDicNodes = mCheckpointDicNodes[checkpointIndex];
     }
 
     AK_FORCE_INLINE void advanceActiveDicNodes() {
@@ -71,12 +146,33 @@ class DicNodesCache {
         }
         mNextActiveDicNodes =
                 moveNodesAndReturnReusableEmptyQueue(mNextActiveDicNodes, &mActiveDicNodes);
+        mActiveDicNodes->setRecombinesDicNodes(false);
+        mNextActiveDicNodes->setRecombinesDicNodes(true);
     }
 
-    DicNode *setCommitPoint(int commitPoint);
+    DicNode *setCommitPoint(const int inputIndex, int commitPoint);
 
+    DicNodeWordStore *getWordStore() { return &mWordStore; }
     int activeSize() const { return mActiveDicNodes->getSize(); }
     int terminalSize() const { return mTerminalDicNodes->getSize(); }
+
+    // Takes the distance above which a new terminal can't enter the full terminal queue. The
+    // distance is kept until the next call, so that the dicNodes expanded in between are all
+    // pruned against the same distance, whether they are expanded serially or in parallel.
+    AK_FORCE_INLINE void updateTerminalPruningDistance() {
+        if (mTerminalDicNodes->isFull() && mTerminalDicNodes->getSize() > 0) {
+            // Margin for the rounding errors of the distances, see DicNode::compare().
+            static const float MARGIN = 0.0001f;
+            mTerminalPruningDistance =
+                    mTerminalDicNodes->getWorst()->getNormalizedCompoundDistance() + MARGIN;
+        } else {
+            mTerminalPruningDistance = static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
+        }
+    }
+
+    float getTerminalPruningDistance() const {
+        return mTerminalPruningDistance;
+    }
     bool isLookAheadCorrectionInputIndex(const int inputIndex) const {
         return inputIndex == mInputIndex - 1;
     }
@@ -86,18 +182,47 @@ class DicNodesCache {
         }
     }
 
-    AK_FORCE_INLINE void copyPushTerminal(DicNode *dicNode) {
-        mTerminalDicNodes->copyPush(dicNode);
+    // Copies dicNode to the pool. The caller holds the only reference to the copy until it
+    // releases it.
+    AK_FORCE_INLINE DicNode *copyToPool(DicNode *dicNode) {
+        const int slot = mDicNodePool.allocate();
+        if (slot == DicNodePool::NOT_A_SLOT) {
+            return 0;
+        }
+        DicNode *const newDicNode = mDicNodePool.getDicNode(slot);
+        DicNodeUtils::initByCopy(dicNode, newDicNode);
+        return newDicNode;
+    }
+
+    // Releases the caller's reference to a dicNode of the pool.
+    AK_FORCE_INLINE void releaseDicNode(DicNode *dicNode) {
+        mDicNodePool.release(mDicNodePool.getSlot(dicNode));
+    }
+
+    // The push methods without "copy" share a dicNode of the pool between queues; the caller
+    // keeps its reference.
+    AK_FORCE_INLINE void pushTerminal(DicNode *dicNode) {
+        mTerminalDicNodes->push(dicNode);
     }
 
     AK_FORCE_INLINE void copyPushActive(DicNode *dicNode) {
         mActiveDicNodes->copyPush(dicNode);
     }
 
-    AK_FORCE_INLINE bool copyPushContinue(DicNode *dicNode) {
-        return mCachedDicNodesForContinuousSuggestion->copyPush(dicNode);
+    // Adds dicNode to the checkpoint started by the last call to beginCheckpoint().
+    AK_FORCE_INLINE bool pushContinue(DicNode *dicNode) {
+        if (!mCurrentCheckpointDicNodes) {
+            return false;
+        }
+        return mCurrentCheckpointDicNodes->push(dicNode);
+    }
+
+    AK_FORCE_INLINE void pushNextActive(DicNode *dicNode) {
+        mNextActiveDicNodes->push(dicNode);
     }
 
+    // The next active queue recombines its dicNodes: of the dicNodes that reached the same
+    // position of the lexicon and of the input in the same context, only the best one is kept.
     AK_FORCE_INLINE void copyPushNextActive(DicNode *dicNode) {
         DicNode *pushedDicNode = mNextActiveDicNodes->copyPush(dicNode);
         if (!pushedDicNode) {
@@ -110,46 +235,50 @@ class DicNodesCache {
     }
 
     void popTerminal(DicNode *dest) {
-        mTerminalDicNodes->copyPop(dest);
+        mTerminalDicNodes->copyPopBest(dest);
     }
 
-    void popActive(DicNode *dest) {
-        mActiveDicNodes->copyPop(dest);
+    // Pops the worst active dicNode, which the caller has to release.
+    DicNode *popActive() {
+        return mActiveDicNodes->pop();
     }
 
-    bool hasCachedDicNodesForContinuousSuggestion() const {
-        return mCachedDicNodesForContinuousSuggestion
-                && mCachedDicNodesForContinuousSuggestion->getSize() > 0;
-    }
+    // The dicNodes of the last input points may still change as more points come, so the
+    // checkpoints are taken at least this many points before the end of the input.
+    static const int DIC_NODES_CHECKPOINT_BACK_LENGTH = 3;
 
-    AK_FORCE_INLINE bool isCacheBorderForTyping(const int inputSize) const {
-        // TODO: Move this variable to header
-        static const int CACHE_BACK_LENGTH = 3;
-        const int cacheInputIndex = inputSize - CACHE_BACK_LENGTH;
-        const bool shouldCache = (cacheInputIndex == mInputIndex)
-                && (cacheInputIndex != mLastCachedInputIndex);
-        return shouldCache;
-    }
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicNodesCache);
 
-    AK_FORCE_INLINE void updateLastCachedInputIndex() {
-        mLastCachedInputIndex = mInputIndex;
+    AK_FORCE_INLINE int getCheckpointIndex(const int inputIndex) const {
+        const int checkpointIndex = inputIndex % MAX_DIC_NODES_CHECKPOINT_COUNT;
+        return mCheckpointInputIndices[checkpointIndex] == inputIndex
+                ? checkpointIndex : NOT_AN_INDEX;
     }
 
- private:
-    DISALLOW_COPY_AND_ASSIGN(DicNodesCache);
+    AK_FORCE_INLINE void discardCheckpoint(const int checkpointIndex) {
+        mCheckpointDicNodes[checkpointIndex]->clear();
+        mCheckpointInputIndices[checkpointIndex] = NOT_AN_INDEX;
+    }
 
-    AK_FORCE_INLINE void restoreActiveDicNodesFromCache() {
+    AK_FORCE_INLINE void restoreActiveDicNodesFromCheckpoint(const int inputIndex) {
+        const int checkpointIndex = getCheckpointIndex(inputIndex);
+        ASSERT(checkpointIndex != NOT_AN_INDEX);
         if (DEBUG_DICT) {
             AKLOGI("Restore %d nodes. inputIndex = %d.",
-                    mCachedDicNodesForContinuousSuggestion->getSize(), mLastCachedInputIndex);
+                    mCheckpointDicNodes[checkpointIndex]->getSize(), inputIndex);
         }
         if (DEBUG_DICT_FULL || DEBUG_CACHE) {
-            mCachedDicNodesForContinuousSuggestion->dump();
+            mCheckpointDicNodes[checkpointIndex]->dump();
         }
-        mInputIndex = mLastCachedInputIndex;
-        mCachedDicNodesForContinuousSuggestion =
-                moveNodesAndReturnReusableEmptyQueue(
-                        mCachedDicNodesForContinuousSuggestion, &mActiveDicNodes);
+        mInputIndex = inputIndex;
+        // The checkpoint is taken again when the search reaches inputIndex.
+        mCheckpointDicNodes[checkpointIndex] = moveNodesAndReturnReusableEmptyQueue(
+                mCheckpointDicNodes[checkpointIndex], &mActiveDicNodes);
+        mActiveDicNodes->setRecombinesDicNodes(false);
+        mCheckpointDicNodes[checkpointIndex]->setRecombinesDicNodes(false);
+        mCheckpointInputIndices[checkpointIndex] = NOT_AN_INDEX;
+        mCurrentCheckpointDicNodes = 0;
     }
 
     AK_FORCE_INLINE static DicNodePriorityQueue *moveNodesAndReturnReusableEmptyQueue(
@@ -163,12 +292,23 @@ class DicNodesCache {
         return tmp;
     }
 
+    // Drops the words of the dicNodes that did not survive. Only the restored active dicNodes
+    // and the remaining checkpoints are alive at this point, and they may share dicNodes.
+    AK_FORCE_INLINE void compactWordStore() {
+        mWordStore.beginRelocation();
+        mDicNodePool.relocateOutputWords();
+        mWordStore.endRelocation();
+    }
+
     AK_FORCE_INLINE void resetTemporaryCaches() {
         mActiveDicNodes->clear();
         mNextActiveDicNodes->clear();
         mTerminalDicNodes->clear();
+        mTerminalPruningDistance = static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
     }
 
+    // Storage of the dicNodes of all the queues below.
+    DicNodePool mDicNodePool;
     DicNodePriorityQueue mDicNodePriorityQueues[PRIORITY_QUEUES_SIZE];
     // Active dicNodes currently being expanded.
     DicNodePriorityQueue *mActiveDicNodes;
@@ -176,10 +316,17 @@ class DicNodesCache {
     DicNodePriorityQueue *mNextActiveDicNodes;
     // Current top terminal dicNodes.
     DicNodePriorityQueue *mTerminalDicNodes;
-    // Cached dicNodes used for continuous suggestion.
-    DicNodePriorityQueue *mCachedDicNodesForContinuousSuggestion;
+    // Ring of the dicNodes active at the last input indices, used to resume the next search.
+    // A checkpoint is in the ring at the index of its input index modulo the ring size.
+    DicNodePriorityQueue *mCheckpointDicNodes[MAX_DIC_NODES_CHECKPOINT_COUNT];
+    // Input index of each checkpoint, or NOT_AN_INDEX if it's empty.
+    int mCheckpointInputIndices[MAX_DIC_NODES_CHECKPOINT_COUNT];
+    // Checkpoint of the current input index if it's being taken.
+    DicNodePriorityQueue *mCurrentCheckpointDicNodes;
+    // Code points output by the dicNodes of all the queues above.
+    DicNodeWordStore mWordStore;
     int mInputIndex;
-    int mLastCachedInputIndex;
+    float mTerminalPruningDistance;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODES_CACHE_H
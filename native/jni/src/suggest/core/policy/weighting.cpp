@@ -93,6 +93,23 @@ static inline void profile(const CorrectionType correctionType, DicNode *const n
             inputSize, errorType);
 }
 
+/* static */ bool Weighting::isSubtreeBeyondCompoundDistance(const Weighting *const weighting,
+        const DicTraverseSession *const traverseSession, const DicNode *const dicNode,
+        const float maxCompoundDistance) {
+    if (weighting->needsToNormalizeCompoundDistance()) {
+        // Normalized distances may decrease as the input is consumed.
+        return false;
+    }
+    // All costs are non-negative, so the distance of any word of the subtree is at least the
+    // current distance plus the lowest terminal language cost.
+    const float minLanguageImprobability = DicNodeUtils::getMinBigramNodeImprobabilityInSubtree(
+            traverseSession->getOffsetDict(), dicNode);
+    const float minCompoundDistance = dicNode->getCompoundDistance()
+            + weighting->getTerminalLanguageCost(traverseSession, dicNode,
+                    minLanguageImprobability);
+    return minCompoundDistance > maxCompoundDistance;
+}
+
 /* static */ float Weighting::getSpatialCost(const Weighting *const weighting,
         const CorrectionType correctionType, const DicTraverseSession *const traverseSession,
         const DicNode *const parentDicNode, const DicNode *const dicNode,
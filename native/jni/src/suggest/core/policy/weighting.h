@@ -34,6 +34,13 @@ class Weighting {
             const DicNode *const parentDicNode, DicNode *const dicNode,
             MultiBigramMap *const multiBigramMap);
 
+    // Returns whether all the words ending in the subtree of dicNode will have a compound
+    // distance above maxCompoundDistance. Only valid for dictionaries storing the max
+    // probabilities of subtrees.
+    static bool isSubtreeBeyondCompoundDistance(const Weighting *const weighting,
+            const DicTraverseSession *const traverseSession, const DicNode *const dicNode,
+            const float maxCompoundDistance);
+
  protected:
     virtual float getTerminalSpatialCost(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const = 0;
@@ -16,17 +16,26 @@
 
 #include "suggest/core/session/dic_traverse_session.h"
 
+#include <time.h>
+
 #include "binary_format.h"
 #include "defines.h"
 #include "dictionary.h"
 #include "dic_traverse_wrapper.h"
 #include "jni.h"
 #include "suggest/core/dicnode/dic_node_utils.h"
+#include "word_position_index.h"
 
 namespace latinime {
 
 const int DicTraverseSession::CACHE_START_INPUT_LENGTH_THRESHOLD = 20;
 
+static int64_t getMonotonicTimeMicros() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
+
 // A factory method for DicTraverseSession
 static void *getSessionInstance(JNIEnv *env, jstring localeStr) {
     return new DicTraverseSession(env, localeStr);
@@ -46,6 +55,32 @@ static void releaseSessionInstance(void *traverseSession) {
     delete static_cast<DicTraverseSession *>(traverseSession);
 }
 
+static void setSessionSearchBudget(void *traverseSession, const int timeBudgetMicros,
+        const int maxExpandedDicNodeCount) {
+    if (traverseSession) {
+        static_cast<DicTraverseSession *>(traverseSession)->setSearchBudget(
+                timeBudgetMicros, maxExpandedDicNodeCount);
+    }
+}
+
+static bool isSessionLastSearchPartial(const void *traverseSession) {
+    return traverseSession
+            && static_cast<const DicTraverseSession *>(traverseSession)->isLastSearchPartial();
+}
+
+static StreamedInput *getSessionStreamedInput(void *traverseSession) {
+    return traverseSession
+            ? static_cast<DicTraverseSession *>(traverseSession)->getStreamedInput() : 0;
+}
+
+static void getSessionBigramMapCounts(const void *traverseSession, int *const hitCount,
+        int *const missCount) {
+    const DicTraverseSession *const tSession =
+            static_cast<const DicTraverseSession *>(traverseSession);
+    *hitCount = tSession ? tSession->getBigramMapHitCount() : 0;
+    *missCount = tSession ? tSession->getBigramMapMissCount() : 0;
+}
+
 // An ad-hoc internal class to register the factory method defined above
 class TraverseSessionFactoryRegisterer {
  public:
@@ -53,6 +88,11 @@ class TraverseSessionFactoryRegisterer {
         DicTraverseWrapper::setTraverseSessionFactoryMethod(getSessionInstance);
         DicTraverseWrapper::setTraverseSessionInitMethod(initSessionInstance);
         DicTraverseWrapper::setTraverseSessionReleaseMethod(releaseSessionInstance);
+        DicTraverseWrapper::setTraverseSessionSearchBudgetMethod(setSessionSearchBudget);
+        DicTraverseWrapper::setTraverseSessionIsLastSearchPartialMethod(
+                isSessionLastSearchPartial);
+        DicTraverseWrapper::setTraverseSessionStreamedInputMethod(getSessionStreamedInput);
+        DicTraverseWrapper::setTraverseSessionBigramMapCountsMethod(getSessionBigramMapCounts);
     }
  private:
     DISALLOW_COPY_AND_ASSIGN(TraverseSessionFactoryRegisterer);
@@ -61,34 +101,65 @@ class TraverseSessionFactoryRegisterer {
 // To invoke the TraverseSessionFactoryRegisterer constructor in the global constructor.
 static TraverseSessionFactoryRegisterer traverseSessionFactoryRegisterer;
 
+static int findPrevWordPos(const Dictionary *const dictionary, const int *const prevWord,
+        const int prevWordLength) {
+    if (!prevWord) {
+        return NOT_VALID_WORD;
+    }
+    const WordPositionIndex *const wordPositionIndex = dictionary->getWordPositionIndex();
+    // TODO: merge following similar calls to getTerminalPosition into one case-insensitive call.
+    const int prevWordPos = wordPositionIndex
+            ? wordPositionIndex->getTerminalPosition(prevWord, prevWordLength,
+                    false /* forceLowerCaseSearch */)
+            : BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), prevWord,
+                    prevWordLength, false /* forceLowerCaseSearch */);
+    if (prevWordPos != NOT_VALID_WORD) {
+        return prevWordPos;
+    }
+    // Check bigrams for lower-cased previous word if original was not found. Useful for
+    // auto-capitalized words like "The [current_word]".
+    return wordPositionIndex
+            ? wordPositionIndex->getTerminalPosition(prevWord, prevWordLength,
+                    true /* forceLowerCaseSearch */)
+            : BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), prevWord,
+                    prevWordLength, true /* forceLowerCaseSearch */);
+}
+
 void DicTraverseSession::init(const Dictionary *const dictionary, const int *prevWord,
         int prevWordLength) {
+    const int prevWordPos = findPrevWordPos(dictionary, prevWord, prevWordLength);
+    if (dictionary != mDictionary) {
+        for (int i = 0; i < getExpansionThreadCount(); ++i) {
+            getWorker(i)->getMultiBigramMap()->clear();
+            getWorker(i)->getMultiBigramMap()->setBigramIndex(dictionary->getBigramIndex());
+        }
+    }
+    if (dictionary != mDictionary || prevWordPos != mPrevWordPos) {
+        // The dicNodes of the checkpoints were scored in another context.
+        mDicNodesCache.discardCheckpoints();
+    }
     mDictionary = dictionary;
     mMultiWordCostMultiplier = BinaryFormat::getMultiWordCostMultiplier(mDictionary->getDict(),
             mDictionary->getDictSize());
-    if (!prevWord) {
-        mPrevWordPos = NOT_VALID_WORD;
-        return;
-    }
-    // TODO: merge following similar calls to getTerminalPosition into one case-insensitive call.
-    mPrevWordPos = BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), prevWord,
-            prevWordLength, false /* forceLowerCaseSearch */);
-    if (mPrevWordPos == NOT_VALID_WORD) {
-        // Check bigrams for lower-cased previous word if original was not found. Useful for
-        // auto-capitalized words like "The [current_word]".
-        mPrevWordPos = BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), prevWord,
-                prevWordLength, true /* forceLowerCaseSearch */);
-    }
+    mPrevWordPos = prevWordPos;
 }
 
 void DicTraverseSession::setupForGetSuggestions(const ProximityInfo *pInfo,
         const int *inputCodePoints, const int inputSize, const int *const inputXs,
         const int *const inputYs, const int *const times, const int *const pointerIds,
         const float maxSpatialDistance, const int maxPointerCount) {
+    if (pInfo != mProximityInfo) {
+        mDicNodesCache.discardCheckpoints();
+    }
     mProximityInfo = pInfo;
     mMaxPointerCount = maxPointerCount;
+    // The search reads the streamed input in place when it is its input. Then the touch points
+    // that the proximity info states can reuse are known without comparing the input with theirs.
+    const bool isStreamedInput = inputXs && inputXs == mStreamedInput.getXCoordinates();
     initializeProximityInfoStates(inputCodePoints, inputXs, inputYs, times, pointerIds, inputSize,
-            maxSpatialDistance, maxPointerCount);
+            maxSpatialDistance, maxPointerCount,
+            isStreamedInput ? mStreamedInput.getUnchangedSize() : NOT_AN_INDEX);
+    mStreamedInput.setSearched(isStreamedInput);
 }
 
 const uint8_t *DicTraverseSession::getOffsetDict() const {
@@ -99,23 +170,112 @@ int DicTraverseSession::getDictFlags() const {
     return mDictionary->getDictFlags();
 }
 
+const CharGroupJumpTable *DicTraverseSession::getCharGroupJumpTable() const {
+    return mDictionary->getCharGroupJumpTable();
+}
+
+const DecodedTrie *DicTraverseSession::getDecodedTrie() const {
+    return mDictionary->getDecodedTrie();
+}
+
+void DicTraverseSession::setExpansionThreadCount(const int threadCount) {
+    mThreadPool.setThreadCount(threadCount);
+    // Each running thread gets a worker, so a session expanding dicNodes with a single thread
+    // only has the first one. The workers are created after the threads as the threads only use
+    // them when they are given dicNodes to expand.
+    const int workerCount = mThreadPool.getThreadCount();
+    for (int i = 1; i < MAX_DIC_TRAVERSE_THREAD_COUNT; ++i) {
+        DicTraverseWorker *&worker = mAdditionalWorkers[i - 1];
+        if (i < workerCount && !worker) {
+            worker = new DicTraverseWorker();
+            worker->setDicNodesCache(&mDicNodesCache);
+            if (mDictionary) {
+                worker->getMultiBigramMap()->setBigramIndex(mDictionary->getBigramIndex());
+            }
+        } else if (i >= workerCount && worker) {
+            mReleasedWorkersBigramMapHitCount += worker->getMultiBigramMap()->getHitCount();
+            mReleasedWorkersBigramMapMissCount += worker->getMultiBigramMap()->getMissCount();
+            delete worker;
+            worker = 0;
+        }
+    }
+}
+
 void DicTraverseSession::resetCache(const int nextActiveCacheSize, const int maxWords) {
+    // The bigram maps only depend on the dictionary, so they are kept across searches.
     mDicNodesCache.reset(nextActiveCacheSize, maxWords);
-    mMultiBigramMap.clear();
     mPartiallyCommited = false;
 }
 
+void DicTraverseSession::beginSearch() {
+    mSearchDeadlineMicros =
+            mTimeBudgetMicros > 0 ? getMonotonicTimeMicros() + mTimeBudgetMicros : 0;
+    mExpandedDicNodeCount = 0;
+    mIsLastSearchPartial = false;
+}
+
+int DicTraverseSession::getBigramMapHitCount() const {
+    int hitCount = mReleasedWorkersBigramMapHitCount;
+    for (int i = 0; i < getExpansionThreadCount(); ++i) {
+        hitCount += getWorker(i)->getMultiBigramMap()->getHitCount();
+    }
+    return hitCount;
+}
+
+int DicTraverseSession::getBigramMapMissCount() const {
+    int missCount = mReleasedWorkersBigramMapMissCount;
+    for (int i = 0; i < getExpansionThreadCount(); ++i) {
+        missCount += getWorker(i)->getMultiBigramMap()->getMissCount();
+    }
+    return missCount;
+}
+
+bool DicTraverseSession::isSearchBudgetExhausted(const int dicNodeCount) {
+    mExpandedDicNodeCount += dicNodeCount;
+    if (mMaxExpandedDicNodeCount > 0 && mExpandedDicNodeCount > mMaxExpandedDicNodeCount) {
+        mIsLastSearchPartial = true;
+    } else if (mSearchDeadlineMicros > 0 && getMonotonicTimeMicros() >= mSearchDeadlineMicros) {
+        mIsLastSearchPartial = true;
+    }
+    if (DEBUG_DICT && mIsLastSearchPartial) {
+        AKLOGI("Search budget exhausted after %d dicNodes.",
+                mExpandedDicNodeCount - dicNodeCount);
+    }
+    return mIsLastSearchPartial;
+}
+
+/**
+ * Returns the input index of the latest checkpoint of the previous searches that the search for
+ * the current input can resume from, or NOT_AN_INDEX if it has to start over. The checkpoint has
+ * to be taken early enough in the part of the input that did not change, so that backspaces and
+ * edits in the middle of a word only redo the search from the edited point on.
+ */
+int DicTraverseSession::getResumableInputIndex() const {
+    ASSERT(mMaxPointerCount <= MAX_POINTER_COUNT_G);
+    int sharedInputPrefixLength = mInputSize;
+    for (int i = 0; i < mMaxPointerCount; ++i) {
+        const ProximityInfoState *const pInfoState = getProximityInfoState(i);
+        if (pInfoState->isUsed()) {
+            sharedInputPrefixLength =
+                    min(sharedInputPrefixLength, pInfoState->getSharedInputPrefixLength());
+        }
+    }
+    return mDicNodesCache.getLatestCheckpointInputIndex(
+            sharedInputPrefixLength - DicNodesCache::DIC_NODES_CHECKPOINT_BACK_LENGTH);
+}
+
 void DicTraverseSession::initializeProximityInfoStates(const int *const inputCodePoints,
         const int *const inputXs, const int *const inputYs, const int *const times,
         const int *const pointerIds, const int inputSize, const float maxSpatialDistance,
-        const int maxPointerCount) {
+        const int maxPointerCount, const int knownSharedInputPrefixLength) {
     ASSERT(1 <= maxPointerCount && maxPointerCount <= MAX_POINTER_COUNT_G);
     mInputSize = 0;
     for (int i = 0; i < maxPointerCount; ++i) {
         mProximityInfoStates[i].initInputParams(i, maxSpatialDistance, getProximityInfo(),
                 inputCodePoints, inputSize, inputXs, inputYs, times, pointerIds,
                 maxPointerCount == MAX_POINTER_COUNT_G
-                /* TODO: this is a hack. fix proximity info state */);
+                /* TODO: this is a hack. fix proximity info state */,
+                knownSharedInputPrefixLength);
         mInputSize += mProximityInfoStates[i].size();
     }
 }
@@ -22,12 +22,16 @@
 
 #include "defines.h"
 #include "jni.h"
-#include "multi_bigram_map.h"
 #include "proximity_info_state.h"
 #include "suggest/core/dicnode/dic_nodes_cache.h"
+#include "suggest/core/session/dic_traverse_thread_pool.h"
+#include "suggest/core/session/dic_traverse_worker.h"
+#include "suggest/core/session/streamed_input.h"
 
 namespace latinime {
 
+class CharGroupJumpTable;
+class DecodedTrie;
 class Dictionary;
 class ProximityInfo;
 
@@ -35,15 +39,26 @@ class DicTraverseSession {
  public:
     AK_FORCE_INLINE DicTraverseSession(JNIEnv *env, jstring localeStr)
             : mPrevWordPos(NOT_VALID_WORD), mProximityInfo(0),
-              mDictionary(0), mDicNodesCache(), mMultiBigramMap(),
+              mDictionary(0), mDicNodesCache(), mWorker(), mAdditionalWorkers(), mThreadPool(),
+              mStreamedInput(), mReleasedWorkersBigramMapHitCount(0),
+              mReleasedWorkersBigramMapMissCount(0),
               mInputSize(0), mPartiallyCommited(false), mMaxPointerCount(1),
+              mTimeBudgetMicros(0), mMaxExpandedDicNodeCount(0), mSearchDeadlineMicros(0),
+              mExpandedDicNodeCount(0), mIsLastSearchPartial(false),
               mMultiWordCostMultiplier(1.0f) {
         // NOTE: mProximityInfoStates is an array of instances.
         // No need to initialize it explicitly here.
+        mWorker.setDicNodesCache(&mDicNodesCache);
     }
 
     // Non virtual inline destructor -- never inherit this class
-    AK_FORCE_INLINE ~DicTraverseSession() {}
+    AK_FORCE_INLINE ~DicTraverseSession() {
+        // The threads that use the additional workers stop first.
+        mThreadPool.setThreadCount(1);
+        for (int i = 0; i < MAX_DIC_TRAVERSE_THREAD_COUNT - 1; ++i) {
+            delete mAdditionalWorkers[i];
+        }
+    }
 
     void init(const Dictionary *dictionary, const int *prevWord, int prevWordLength);
     // TODO: Remove and merge into init
@@ -53,9 +68,31 @@ class DicTraverseSession {
             const int maxPointerCount);
     void resetCache(const int nextActiveCacheSize, const int maxWords);
 
+    // Bounds the time and the number of dicNodes expanded by each search, 0 meaning no bound.
+    // A search that runs out of budget stops expanding and outputs the terminal dicNodes found
+    // so far. The budget is checked before each input index is processed, so it can be overrun
+    // by the expansion of one input index.
+    void setSearchBudget(const int timeBudgetMicros, const int maxExpandedDicNodeCount) {
+        mTimeBudgetMicros = max(0, timeBudgetMicros);
+        mMaxExpandedDicNodeCount = max(0, maxExpandedDicNodeCount);
+    }
+    void beginSearch();
+    // Counts dicNodeCount dicNodes about to be expanded, and returns whether the budget of the
+    // search is exceeded. If so, the search is marked as partial.
+    bool isSearchBudgetExhausted(const int dicNodeCount);
+    // Returns whether the last search stopped before expanding all its dicNodes.
+    bool isLastSearchPartial() const { return mIsLastSearchPartial; }
+    // Numbers of the bigram lookups of the workers that found the bigrams of the previous word
+    // cached, and that had to read them from the dictionary, since the creation of the session.
+    // They tell how well MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP fits the input.
+    int getBigramMapHitCount() const;
+    int getBigramMapMissCount() const;
+
     // TODO: Remove
     const uint8_t *getOffsetDict() const;
     int getDictFlags() const;
+    const CharGroupJumpTable *getCharGroupJumpTable() const;
+    const DecodedTrie *getDecodedTrie() const;
 
     //--------------------
     // getters and setters
@@ -67,7 +104,22 @@ class DicTraverseSession {
     // TODO: Use proper parameter when changed
     int getDicRootPos() const { return 0; }
     DicNodesCache *getDicTraverseCache() { return &mDicNodesCache; }
-    MultiBigramMap *getMultiBigramMap() { return &mMultiBigramMap; }
+    // Worker of each thread expanding dicNodes, for threadIndex below the expansion thread
+    // count. The first one is also used when the dicNodes are expanded by a single thread.
+    DicTraverseWorker *getWorker(const int threadIndex) {
+        return threadIndex == 0 ? &mWorker : mAdditionalWorkers[threadIndex - 1];
+    }
+    const DicTraverseWorker *getWorker(const int threadIndex) const {
+        return threadIndex == 0 ? &mWorker : mAdditionalWorkers[threadIndex - 1];
+    }
+    DicTraverseThreadPool *getThreadPool() { return &mThreadPool; }
+    // Expanding the active dicNodes with several threads produces the same suggestions as
+    // expanding them with one. It only pays off when there are many active dicNodes.
+    void setExpansionThreadCount(const int threadCount);
+    int getExpansionThreadCount() const { return mThreadPool.getThreadCount(); }
+    // The touch points streamed to the session. The searches on them reuse the computations of
+    // the previous search for the points that did not change.
+    StreamedInput *getStreamedInput() { return &mStreamedInput; }
     const ProximityInfoState *getProximityInfoState(int id) const {
         return &mProximityInfoStates[id];
     }
@@ -124,29 +176,11 @@ class DicTraverseSession {
         return proximityType;
     }
 
-    AK_FORCE_INLINE bool isCacheBorderForTyping(const int inputSize) const {
-        return mDicNodesCache.isCacheBorderForTyping(inputSize);
+    AK_FORCE_INLINE bool canTakeCheckpointForTyping(const int inputSize) const {
+        return mDicNodesCache.canTakeCheckpoint(inputSize);
     }
 
-    /**
-     * Returns whether or not it is possible to continue suggestion from the previous search.
-     */
-    // TODO: Remove. No need to check once the session is fully implemented.
-    bool isContinuousSuggestionPossible() const {
-        if (!mDicNodesCache.hasCachedDicNodesForContinuousSuggestion()) {
-            return false;
-        }
-        ASSERT(mMaxPointerCount <= MAX_POINTER_COUNT_G);
-        for (int i = 0; i < mMaxPointerCount; ++i) {
-            const ProximityInfoState *const pInfoState = getProximityInfoState(i);
-            // If a proximity info state is not continuous suggestion possible,
-            // do not continue searching.
-            if (pInfoState->isUsed() && !pInfoState->isContinuousSuggestionPossible()) {
-                return false;
-            }
-        }
-        return true;
-    }
+    int getResumableInputIndex() const;
 
     bool isTouchPositionCorrectionEnabled() const {
         return mProximityInfoStates[0].touchPositionCorrectionEnabled();
@@ -162,21 +196,34 @@ class DicTraverseSession {
     static const int CACHE_START_INPUT_LENGTH_THRESHOLD;
     void initializeProximityInfoStates(const int *const inputCodePoints, const int *const inputXs,
             const int *const inputYs, const int *const times, const int *const pointerIds,
-            const int inputSize, const float maxSpatialDistance, const int maxPointerCount);
+            const int inputSize, const float maxSpatialDistance, const int maxPointerCount,
+            const int knownSharedInputPrefixLength);
 
     int mPrevWordPos;
     const ProximityInfo *mProximityInfo;
     const Dictionary *mDictionary;
 
     DicNodesCache mDicNodesCache;
-    // Temporary cache for bigram frequencies
-    MultiBigramMap mMultiBigramMap;
+    DicTraverseWorker mWorker;
+    // The workers of the other expansion threads, which only exist while the threads run.
+    DicTraverseWorker *mAdditionalWorkers[MAX_DIC_TRAVERSE_THREAD_COUNT - 1];
+    DicTraverseThreadPool mThreadPool;
     ProximityInfoState mProximityInfoStates[MAX_POINTER_COUNT_G];
+    StreamedInput mStreamedInput;
+    // The bigram map lookups of the additional workers already released.
+    int mReleasedWorkersBigramMapHitCount;
+    int mReleasedWorkersBigramMapMissCount;
 
     int mInputSize;
     bool mPartiallyCommited;
     int mMaxPointerCount;
 
+    int mTimeBudgetMicros;
+    int mMaxExpandedDicNodeCount;
+    int64_t mSearchDeadlineMicros;
+    int mExpandedDicNodeCount;
+    bool mIsLastSearchPartial;
+
     /////////////////////////////////
     // Configuration per dictionary
     float mMultiWordCostMultiplier;
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "suggest/core/session/dic_traverse_thread_pool.h"
+
+#include "defines.h"
+
+namespace latinime {
+
+DicTraverseThreadPool::DicTraverseThreadPool()
+        : mThreadCount(1), mThreads(), mThreadArgs(), mMutex(), mTaskCondition(),
+          mDoneCondition(), mTask(0), mTaskArg(0), mTaskId(0), mRunningThreadCount(0),
+          mIsStopping(false) {
+    pthread_mutex_init(&mMutex, 0);
+    pthread_cond_init(&mTaskCondition, 0);
+    pthread_cond_init(&mDoneCondition, 0);
+}
+
+DicTraverseThreadPool::~DicTraverseThreadPool() {
+    stopThreads();
+    pthread_cond_destroy(&mDoneCondition);
+    pthread_cond_destroy(&mTaskCondition);
+    pthread_mutex_destroy(&mMutex);
+}
+
+void DicTraverseThreadPool::setThreadCount(const int threadCount) {
+    const int newThreadCount = max(1, min(threadCount, MAX_DIC_TRAVERSE_THREAD_COUNT));
+    if (newThreadCount == mThreadCount) {
+        return;
+    }
+    stopThreads();
+    for (int i = 1; i < newThreadCount; ++i) {
+        mThreadArgs[i].mThreadPool = this;
+        mThreadArgs[i].mThreadIndex = i;
+        mThreadArgs[i].mLastTaskId = mTaskId;
+        if (pthread_create(&mThreads[i], 0, threadMain, &mThreadArgs[i]) != 0) {
+            AKLOGE("Can't create a thread to traverse the dictionary.");
+            break;
+        }
+        mThreadCount = i + 1;
+    }
+}
+
+void DicTraverseThreadPool::run(const TaskFunction task, void *const arg) {
+    if (mThreadCount > 1) {
+        pthread_mutex_lock(&mMutex);
+        mTask = task;
+        mTaskArg = arg;
+        ++mTaskId;
+        mRunningThreadCount = mThreadCount - 1;
+        pthread_cond_broadcast(&mTaskCondition);
+        pthread_mutex_unlock(&mMutex);
+    }
+    task(arg, 0 /* threadIndex */);
+    if (mThreadCount > 1) {
+        pthread_mutex_lock(&mMutex);
+        while (mRunningThreadCount > 0) {
+            pthread_cond_wait(&mDoneCondition, &mMutex);
+        }
+        pthread_mutex_unlock(&mMutex);
+    }
+}
+
+/* static */ void *DicTraverseThreadPool::threadMain(void *arg) {
+    ThreadArg *const threadArg = static_cast<ThreadArg *>(arg);
+    threadArg->mThreadPool->runThread(threadArg->mThreadIndex, threadArg->mLastTaskId);
+    return 0;
+}
+
+void DicTraverseThreadPool::runThread(const int threadIndex, uint32_t lastTaskId) {
+    pthread_mutex_lock(&mMutex);
+    while (true) {
+        while (!mIsStopping && mTaskId == lastTaskId) {
+            pthread_cond_wait(&mTaskCondition, &mMutex);
+        }
+        if (mIsStopping) {
+            break;
+        }
+        lastTaskId = mTaskId;
+        const TaskFunction task = mTask;
+        void *const taskArg = mTaskArg;
+        pthread_mutex_unlock(&mMutex);
+        task(taskArg, threadIndex);
+        pthread_mutex_lock(&mMutex);
+        if (--mRunningThreadCount == 0) {
+            pthread_cond_signal(&mDoneCondition);
+        }
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+void DicTraverseThreadPool::stopThreads() {
+    if (mThreadCount <= 1) {
+        return;
+    }
+    pthread_mutex_lock(&mMutex);
+    mIsStopping = true;
+    pthread_cond_broadcast(&mTaskCondition);
+    pthread_mutex_unlock(&mMutex);
+    for (int i = 1; i < mThreadCount; ++i) {
+        pthread_join(mThreads[i], 0);
+    }
+    mIsStopping = false;
+    mThreadCount = 1;
+}
+} // namespace latinime
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_TRAVERSE_THREAD_POOL_H
+#define LATINIME_DIC_TRAVERSE_THREAD_POOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "defines.h"
+
+#define MAX_DIC_TRAVERSE_THREAD_COUNT 4
+
+namespace latinime {
+
+/**
+ * Small pool of threads that run one task at a time together with the thread submitting it.
+ * The threads are kept alive between tasks so that a task can be run for each input index
+ * without creating threads.
+ */
+class DicTraverseThreadPool {
+ public:
+    // Called with the index of the thread running it, which is 0 for the submitting thread.
+    typedef void (*TaskFunction)(void *arg, const int threadIndex);
+
+    DicTraverseThreadPool();
+    // Non virtual inline destructor -- never inherit this class
+    ~DicTraverseThreadPool();
+
+    // Sets the number of threads running each task, including the submitting thread. The count
+    // is clamped to [1, MAX_DIC_TRAVERSE_THREAD_COUNT], and is lowered when threads can't be
+    // created.
+    void setThreadCount(const int threadCount);
+
+    int getThreadCount() const {
+        return mThreadCount;
+    }
+
+    // Runs task on every thread and returns once all of them have returned.
+    void run(const TaskFunction task, void *const arg);
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicTraverseThreadPool);
+
+    struct ThreadArg {
+        DicTraverseThreadPool *mThreadPool;
+        int mThreadIndex;
+        // Id of the last task submitted before the thread was created
+        uint32_t mLastTaskId;
+    };
+
+    static void *threadMain(void *arg);
+    void runThread(const int threadIndex, uint32_t lastTaskId);
+    void stopThreads();
+
+    int mThreadCount;
+    pthread_t mThreads[MAX_DIC_TRAVERSE_THREAD_COUNT];
+    ThreadArg mThreadArgs[MAX_DIC_TRAVERSE_THREAD_COUNT];
+    pthread_mutex_t mMutex;
+    // Signaled when a task is submitted or when the threads have to stop.
+    pthread_cond_t mTaskCondition;
+    // Signaled when the last thread finishes the current task.
+    pthread_cond_t mDoneCondition;
+    TaskFunction mTask;
+    void *mTaskArg;
+    // Incremented for each task so that threads can tell a new task from the one they ran.
+    uint32_t mTaskId;
+    int mRunningThreadCount;
+    bool mIsStopping;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_TRAVERSE_THREAD_POOL_H
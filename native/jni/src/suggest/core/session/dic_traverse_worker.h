@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_TRAVERSE_WORKER_H
+#define LATINIME_DIC_TRAVERSE_WORKER_H
+
+#include <vector>
+
+#include "defines.h"
+#include "multi_bigram_map.h"
+#include "suggest/core/dicnode/dic_node.h"
+#include "suggest/core/dicnode/dic_node_arena.h"
+#include "suggest/core/dicnode/dic_node_word_store.h"
+#include "suggest/core/dicnode/dic_nodes_cache.h"
+
+namespace latinime {
+
+/**
+ * What a thread needs to expand active dicNodes: storage for the child dicNodes, a bigram cache
+ * and a destination for the dicNodes the expansion produces.
+ * By default the produced dicNodes are pushed to the queues of the session right away. When the
+ * active dicNodes are expanded by several threads, each worker records them instead, together
+ * with the code points they add in an overlay of the word store of the session. The recorded
+ * pushes are then replayed on the queues in the order of the expanded dicNodes, which makes the
+ * queues end up exactly as if the dicNodes had been expanded one by one.
+ */
+class DicTraverseWorker {
+ public:
+    DicTraverseWorker()
+            : mDicNodesCache(0), mIsRecording(false), mDicNodeArena(), mMultiBigramMap(),
+              mOverlayWordStore(), mRecordTypes(), mRecordedDicNodes(),
+              mRecordedDicNodeCount(0), mRecordEnds(), mReplayedRecordCount(0),
+              mReplayedDicNodeCount(0), mReplayedExpansionCount(0) {}
+
+    // Non virtual inline destructor -- never inherit this class
+    ~DicTraverseWorker() {}
+
+    void setDicNodesCache(DicNodesCache *const dicNodesCache) {
+        mDicNodesCache = dicNodesCache;
+    }
+
+    DicNodeArena *getDicNodeArena() {
+        return &mDicNodeArena;
+    }
+
+    MultiBigramMap *getMultiBigramMap() {
+        return &mMultiBigramMap;
+    }
+
+    const MultiBigramMap *getMultiBigramMap() const {
+        return &mMultiBigramMap;
+    }
+
+    // Starts expanding dicNodes directly into the queues.
+    void beginPushing() {
+        mIsRecording = false;
+        mDicNodeArena.reset();
+    }
+
+    // Starts recording the dicNodes produced by expanding dicNodes. The dicNodes to expand have
+    // to be given setOverlayWordStore(getOverlayWordStore()) first.
+    void beginRecording() {
+        mIsRecording = true;
+        mDicNodeArena.reset();
+        mOverlayWordStore.setBaseStore(mDicNodesCache->getWordStore());
+        mRecordTypes.clear();
+        mRecordedDicNodeCount = 0;
+        mRecordEnds.clear();
+        mReplayedRecordCount = 0;
+        mReplayedDicNodeCount = 0;
+        mReplayedExpansionCount = 0;
+    }
+
+    DicNodeWordStore *getOverlayWordStore() {
+        return &mOverlayWordStore;
+    }
+
+    // Marks the end of the records of the dicNode being expanded.
+    void endExpansion() {
+        mRecordEnds.push_back(static_cast<int>(mRecordTypes.size()));
+    }
+
+    AK_FORCE_INLINE void copyPushNextActive(DicNode *dicNode) {
+        if (mIsRecording) {
+            record(RECORD_TYPE_NEXT_ACTIVE, dicNode);
+        } else {
+            mDicNodesCache->copyPushNextActive(dicNode);
+        }
+    }
+
+    // Pushes the dicNode being expanded, which is one of the pool, without copying it.
+    AK_FORCE_INLINE void pushExpandedDicNodeToNextActive(DicNode *expandedDicNode) {
+        if (mIsRecording) {
+            mRecordTypes.push_back(RECORD_TYPE_EXPANDED_DIC_NODE_NEXT_ACTIVE);
+        } else {
+            mDicNodesCache->pushNextActive(expandedDicNode);
+        }
+    }
+
+    // Returns a copy of dicNode that has to be weighted as a terminal and then be passed to
+    // pushTerminal(), or 0 if there is no room for it.
+    AK_FORCE_INLINE DicNode *copyTerminal(DicNode *dicNode) {
+        if (mIsRecording) {
+            return record(RECORD_TYPE_TERMINAL, dicNode);
+        }
+        return mDicNodesCache->copyToPool(dicNode);
+    }
+
+    AK_FORCE_INLINE void pushTerminal(DicNode *terminalDicNode) {
+        if (!mIsRecording) {
+            mDicNodesCache->pushTerminal(terminalDicNode);
+            mDicNodesCache->releaseDicNode(terminalDicNode);
+        }
+    }
+
+    // Replays the pushes recorded while expanding the next dicNode this worker expanded, which
+    // is expandedDicNode.
+    void replayNextExpansion(DicNode *expandedDicNode) {
+        const int recordEnd = mRecordEnds[mReplayedExpansionCount++];
+        for (; mReplayedRecordCount < recordEnd; ++mReplayedRecordCount) {
+            if (mRecordTypes[mReplayedRecordCount] == RECORD_TYPE_EXPANDED_DIC_NODE_NEXT_ACTIVE) {
+                mDicNodesCache->pushNextActive(expandedDicNode);
+                continue;
+            }
+            DicNode *const dicNode = &mRecordedDicNodes[mReplayedDicNodeCount++];
+            dicNode->moveWordsToBaseStore();
+            if (mRecordTypes[mReplayedRecordCount] == RECORD_TYPE_NEXT_ACTIVE) {
+                mDicNodesCache->copyPushNextActive(dicNode);
+                continue;
+            }
+            DicNode *const terminalDicNode = mDicNodesCache->copyToPool(dicNode);
+            if (terminalDicNode) {
+                mDicNodesCache->pushTerminal(terminalDicNode);
+                mDicNodesCache->releaseDicNode(terminalDicNode);
+            }
+        }
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicTraverseWorker);
+
+    enum RecordType {
+        RECORD_TYPE_NEXT_ACTIVE,
+        RECORD_TYPE_EXPANDED_DIC_NODE_NEXT_ACTIVE,
+        RECORD_TYPE_TERMINAL
+    };
+
+    // The recorded dicNodes are kept across passes, so they are copied in place instead of
+    // being pushed back.
+    AK_FORCE_INLINE DicNode *record(const RecordType recordType, DicNode *dicNode) {
+        mRecordTypes.push_back(recordType);
+        if (mRecordedDicNodeCount == static_cast<int>(mRecordedDicNodes.size())) {
+            // max() takes references, so the constant is passed as a temporary not to need a
+            // definition.
+            mRecordedDicNodes.resize(max(static_cast<int>(MIN_RECORDED_DIC_NODES_SIZE),
+                    mRecordedDicNodeCount * 2));
+        }
+        DicNode *const recordedDicNode = &mRecordedDicNodes[mRecordedDicNodeCount++];
+        DicNodeUtils::initByCopy(dicNode, recordedDicNode);
+        return recordedDicNode;
+    }
+
+    static const int MIN_RECORDED_DIC_NODES_SIZE = 256;
+
+    DicNodesCache *mDicNodesCache;
+    bool mIsRecording;
+    // Storage of the child dicNodes created while expanding dicNodes
+    DicNodeArena mDicNodeArena;
+    // Cache for bigram frequencies, kept across searches
+    MultiBigramMap mMultiBigramMap;
+    // Code points of the recorded dicNodes, over the word store of the session
+    DicNodeWordStore mOverlayWordStore;
+    std::vector<RecordType> mRecordTypes;
+    std::vector<DicNode> mRecordedDicNodes;
+    int mRecordedDicNodeCount;
+    // End of the records of each expanded dicNode
+    std::vector<int> mRecordEnds;
+    int mReplayedRecordCount;
+    int mReplayedDicNodeCount;
+    int mReplayedExpansionCount;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_TRAVERSE_WORKER_H
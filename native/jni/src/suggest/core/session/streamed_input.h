@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_STREAMED_INPUT_H
+#define LATINIME_STREAMED_INPUT_H
+
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Touch points streamed to a session one input at a time, a key press or a part of a gesture,
+ * instead of being sent again in full for each search. As the changes are known, the searches
+ * on this input don't need to compare it with the previous input to find the points they can
+ * reuse: the points before getUnchangedSize() are the ones of the previous search.
+ */
+class StreamedInput {
+ public:
+    StreamedInput()
+            : mCodePoints(), mXCoordinates(), mYCoordinates(), mTimes(), mPointerIds(),
+              mInputEnds(), mUnchangedSize(0) {}
+    // Non virtual inline destructor -- never inherit this class
+    ~StreamedInput() {}
+
+    // Appends count touch points as one input. codePoints may be null for gestures, whose points
+    // are not given code points.
+    void appendTouchPoints(const int *const codePoints, const int *const xCoordinates,
+            const int *const yCoordinates, const int *const times, const int *const pointerIds,
+            const int count) {
+        if (count <= 0) {
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            mCodePoints.push_back(codePoints ? codePoints[i] : NOT_A_CODE_POINT);
+        }
+        mXCoordinates.insert(mXCoordinates.end(), xCoordinates, xCoordinates + count);
+        mYCoordinates.insert(mYCoordinates.end(), yCoordinates, yCoordinates + count);
+        mTimes.insert(mTimes.end(), times, times + count);
+        mPointerIds.insert(mPointerIds.end(), pointerIds, pointerIds + count);
+        mInputEnds.push_back(getSize());
+    }
+
+    // Removes the touch points of the last input, if any.
+    void removeLastInput() {
+        if (mInputEnds.empty()) {
+            return;
+        }
+        mInputEnds.pop_back();
+        resize(mInputEnds.empty() ? 0 : mInputEnds.back());
+    }
+
+    void resetInput() {
+        mInputEnds.clear();
+        resize(0);
+    }
+
+    int getSize() const {
+        return static_cast<int>(mXCoordinates.size());
+    }
+
+    // Number of leading touch points that are the same as in the last search on this input.
+    int getUnchangedSize() const {
+        return mUnchangedSize;
+    }
+
+    // Called after each search of the session: the next search on this input can reuse all of
+    // it if it was the input of the search, and none of it otherwise.
+    void setSearched(const bool isSearchedInput) {
+        mUnchangedSize = isSearchedInput ? getSize() : 0;
+    }
+
+    // The arrays of the touch points, which are null while there are none.
+    int *getCodePoints() { return getData(&mCodePoints); }
+    int *getXCoordinates() { return getData(&mXCoordinates); }
+    int *getYCoordinates() { return getData(&mYCoordinates); }
+    int *getTimes() { return getData(&mTimes); }
+    int *getPointerIds() { return getData(&mPointerIds); }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(StreamedInput);
+
+    static int *getData(std::vector<int> *const values) {
+        return values->empty() ? 0 : &(*values)[0];
+    }
+
+    void resize(const int size) {
+        mCodePoints.resize(size);
+        mXCoordinates.resize(size);
+        mYCoordinates.resize(size);
+        mTimes.resize(size);
+        mPointerIds.resize(size);
+        mUnchangedSize = min(mUnchangedSize, size);
+    }
+
+    std::vector<int> mCodePoints;
+    std::vector<int> mXCoordinates;
+    std::vector<int> mYCoordinates;
+    std::vector<int> mTimes;
+    std::vector<int> mPointerIds;
+    // The end of each input in the touch points.
+    std::vector<int> mInputEnds;
+    int mUnchangedSize;
+};
+} // namespace latinime
+#endif // LATINIME_STREAMED_INPUT_H
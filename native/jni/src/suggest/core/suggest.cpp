@@ -16,6 +16,9 @@
 
 #include "suggest/core/suggest.h"
 
+#include <vector>
+
+#include "binary_format.h"
 #include "char_utils.h"
 #include "dictionary.h"
 #include "digraph_utils.h"
@@ -28,6 +31,7 @@
 #include "suggest/core/policy/traversal.h"
 #include "suggest/core/policy/weighting.h"
 #include "suggest/core/session/dic_traverse_session.h"
+#include "suggest/core/session/dic_traverse_worker.h"
 #include "terminal_attributes.h"
 
 namespace latinime {
@@ -42,8 +46,10 @@ const float Suggest::AUTOCORRECT_CLASSIFICATION_THRESHOLD = 0.33f;
  * whether to prematurely commit the suggested words up to the given point for sentence-level
  * suggestion.
  *
- * Note: Currently does not support concurrent calls across threads. Continuous suggestion is
- * automatically activated for sequential calls that share the same starting input.
+ * Note: Calls on different traverse sessions may run concurrently, as all the state of a search
+ * lives in its session and the dictionary is only read. A session must not be used by two calls
+ * at the same time. Continuous suggestion is automatically activated for sequential calls that
+ * share the same starting input.
  * TODO: Stop detecting continuous suggestion. Start using traverseSession instead.
  */
 int Suggest::getSuggestions(ProximityInfo *pInfo, void *traverseSession,
@@ -58,12 +64,17 @@ int Suggest::getSuggestions(ProximityInfo *pInfo, void *traverseSession,
             pointerIds, maxSpatialDistance, TRAVERSAL->getMaxPointerCount());
     // TODO: Add the way to evaluate cache
 
+    tSession->beginSearch();
     initializeSearch(tSession, commitPoint);
     PROF_END(0);
     PROF_START(1);
 
-    // keep expanding search dicNodes until all have terminated.
+    // keep expanding search dicNodes until all have terminated, or until the budget of the
+    // search runs out.
     while (tSession->getDicTraverseCache()->activeSize() > 0) {
+        if (tSession->isSearchBudgetExhausted(tSession->getDicTraverseCache()->activeSize())) {
+            break;
+        }
         expandCurrentDicNodes(tSession);
         tSession->getDicTraverseCache()->advanceActiveDicNodes();
         tSession->getDicTraverseCache()->advanceInputIndex(inputSize);
@@ -72,13 +83,17 @@ int Suggest::getSuggestions(ProximityInfo *pInfo, void *traverseSession,
     PROF_START(2);
     const int size = outputSuggestions(tSession, frequencies, outWords, outputIndices, outputTypes);
     PROF_END(2);
+    if (DEBUG_CACHE) {
+        AKLOGI("Bigram map hits = %d, misses = %d", tSession->getBigramMapHitCount(),
+                tSession->getBigramMapMissCount());
+    }
     PROF_CLOSE;
     return size;
 }
 
 /**
  * Initializes the search at the root of the lexicon trie. Note that when possible the search will
- * continue suggestion from where it left off during the last call.
+ * resume from the latest checkpoint of the previous calls that the input did not change since.
  */
 void Suggest::initializeSearch(DicTraverseSession *traverseSession, int commitPoint) const {
     if (!traverseSession->getProximityInfoState(0)->isUsed()) {
@@ -88,17 +103,18 @@ void Suggest::initializeSearch(DicTraverseSession *traverseSession, int commitPo
         commitPoint = 0;
     }
 
+    const int resumableInputIndex = traverseSession->getResumableInputIndex();
     if (traverseSession->getInputSize() > MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE
-            && traverseSession->isContinuousSuggestionPossible()) {
+            && resumableInputIndex != NOT_AN_INDEX) {
         if (commitPoint == 0) {
             // Continue suggestion
-            traverseSession->getDicTraverseCache()->continueSearch();
+            traverseSession->getDicTraverseCache()->continueSearch(resumableInputIndex);
         } else {
             // Continue suggestion after partial commit.
-            DicNode *topDicNode =
-                    traverseSession->getDicTraverseCache()->setCommitPoint(commitPoint);
+            DicNode *topDicNode = traverseSession->getDicTraverseCache()->setCommitPoint(
+                    resumableInputIndex, commitPoint);
             traverseSession->setPrevWordPos(topDicNode->getPrevWordNodePos());
-            traverseSession->getDicTraverseCache()->continueSearch();
+            traverseSession->getDicTraverseCache()->continueSearch(resumableInputIndex);
             traverseSession->setPartiallyCommited();
         }
     } else {
@@ -107,7 +123,8 @@ void Suggest::initializeSearch(DicTraverseSession *traverseSession, int commitPo
         // Create a new dic node here
         DicNode rootNode;
         DicNodeUtils::initAsRoot(traverseSession->getDicRootPos(),
-                traverseSession->getOffsetDict(), traverseSession->getPrevWordPos(), &rootNode);
+                traverseSession->getOffsetDict(), traverseSession->getPrevWordPos(),
+                traverseSession->getDicTraverseCache()->getWordStore(), &rootNode);
         traverseSession->getDicTraverseCache()->copyPushActive(&rootNode);
     }
 }
@@ -125,7 +142,8 @@ int Suggest::outputSuggestions(DicTraverseSession *traverseSession, int *frequen
 #endif
     DicNode terminals[MAX_RESULTS]; // Avoiding non-POD variable length array
 
-    for (int index = terminalSize - 1; index >= 0; --index) {
+    // Terminals are popped best first
+    for (int index = 0; index < terminalSize; ++index) {
         traverseSession->getDicTraverseCache()->popTerminal(&terminals[index]);
     }
 
@@ -224,128 +242,236 @@ int Suggest::outputSuggestions(DicTraverseSession *traverseSession, int *frequen
  * nodes based on the next touch point(s) (or no touch points for lookahead)
  */
 void Suggest::expandCurrentDicNodes(DicTraverseSession *traverseSession) const {
-    const int inputSize = traverseSession->getInputSize();
-    DicNodeVector childDicNodes(TRAVERSAL->getDefaultExpandDicNodeSize());
-    DicNode correctionDicNode;
-
-    // TODO: Find more efficient caching
     const bool shouldDepthLevelCache = TRAVERSAL->shouldDepthLevelCache(traverseSession);
+    traverseSession->getDicTraverseCache()->updateTerminalPruningDistance();
     if (shouldDepthLevelCache) {
-        traverseSession->getDicTraverseCache()->updateLastCachedInputIndex();
+        traverseSession->getDicTraverseCache()->beginCheckpoint();
     }
     if (DEBUG_CACHE) {
         AKLOGI("expandCurrentDicNodes depth level cache = %d, inputSize = %d",
-                shouldDepthLevelCache, inputSize);
+                shouldDepthLevelCache, traverseSession->getInputSize());
     }
+    if (traverseSession->getExpansionThreadCount() > 1) {
+        expandCurrentDicNodesInParallel(traverseSession, shouldDepthLevelCache);
+        return;
+    }
+    DicTraverseWorker *const worker = traverseSession->getWorker(0);
+    worker->beginPushing();
     while (traverseSession->getDicTraverseCache()->activeSize() > 0) {
-        DicNode dicNode;
-        traverseSession->getDicTraverseCache()->popActive(&dicNode);
-        if (dicNode.isTotalInputSizeExceedingLimit()) {
+        // The popped dicNode may also be held by the checkpoint being taken, so it is
+        // never modified in place.
+        DicNode *const dicNode = traverseSession->getDicTraverseCache()->popActive();
+        if (dicNode->isTotalInputSizeExceedingLimit()) {
+            traverseSession->getDicTraverseCache()->releaseDicNode(dicNode);
             return;
         }
-        childDicNodes.clear();
-        const int point0Index = dicNode.getInputIndex(0);
-        const bool canDoLookAheadCorrection =
-                TRAVERSAL->canDoLookAheadCorrection(traverseSession, &dicNode);
-        const bool isLookAheadCorrection = canDoLookAheadCorrection
-                && traverseSession->getDicTraverseCache()->
-                        isLookAheadCorrectionInputIndex(static_cast<int>(point0Index));
-        const bool isCompletion = dicNode.isCompletion(inputSize);
-
-        const bool shouldNodeLevelCache =
-                TRAVERSAL->shouldNodeLevelCache(traverseSession, &dicNode);
-        if (shouldDepthLevelCache || shouldNodeLevelCache) {
-            if (DEBUG_CACHE) {
-                dicNode.dump("PUSH_CACHE");
-            }
-            traverseSession->getDicTraverseCache()->copyPushContinue(&dicNode);
-            dicNode.setCached();
+        if (shouldCacheDicNode(traverseSession, dicNode, shouldDepthLevelCache)) {
+            traverseSession->getDicTraverseCache()->pushContinue(dicNode);
+            dicNode->setCached();
         }
+        expandDicNode(traverseSession, worker, dicNode);
+        traverseSession->getDicTraverseCache()->releaseDicNode(dicNode);
+    }
+}
 
-        if (dicNode.isInDigraph()) {
-            // Finish digraph handling if the node is in the middle of a digraph expansion.
-            processDicNodeAsDigraph(traverseSession, &dicNode);
-        } else if (isLookAheadCorrection) {
-            // The algorithm maintains a small set of "deferred" nodes that have not consumed the
-            // latest touch point yet. These are needed to apply look-ahead correction operations
-            // that require special handling of the latest touch point. For example, with insertions
-            // (e.g., "thiis" -> "this") the latest touch point should not be consumed at all.
-            processDicNodeAsTransposition(traverseSession, &dicNode);
-            processDicNodeAsInsertion(traverseSession, &dicNode);
-        } else { // !isLookAheadCorrection
-            // Only consider typing error corrections if the normalized compound distance is
-            // below a spatial distance threshold.
-            // NOTE: the threshold may need to be updated if scoring model changes.
-            // TODO: Remove. Do not prune node here.
-            const bool allowsErrorCorrections = TRAVERSAL->allowsErrorCorrections(&dicNode);
-            // Process for handling space substitution (e.g., hevis => he is)
-            if (allowsErrorCorrections
-                    && TRAVERSAL->isSpaceSubstitutionTerminal(traverseSession, &dicNode)) {
-                createNextWordDicNode(traverseSession, &dicNode, true /* spaceSubstitution */);
-            }
+struct Suggest::ParallelExpansion {
+    const Suggest *mSuggest;
+    DicTraverseSession *mTraverseSession;
+    const std::vector<DicNode *> *mDicNodes;
+};
 
-            DicNodeUtils::getAllChildDicNodes(
-                    &dicNode, traverseSession->getOffsetDict(), &childDicNodes);
-
-            const int childDicNodesSize = childDicNodes.getSizeAndLock();
-            for (int i = 0; i < childDicNodesSize; ++i) {
-                DicNode *const childDicNode = childDicNodes[i];
-                if (isCompletion) {
-                    // Handle forward lookahead when the lexicon letter exceeds the input size.
-                    processDicNodeAsMatch(traverseSession, childDicNode);
-                    continue;
-                }
-                if (DigraphUtils::hasDigraphForCodePoint(traverseSession->getDictFlags(),
-                        childDicNode->getNodeCodePoint())) {
-                    correctionDicNode.initByCopy(childDicNode);
-                    correctionDicNode.advanceDigraphIndex();
-                    processDicNodeAsDigraph(traverseSession, &correctionDicNode);
-                }
-                if (TRAVERSAL->isOmission(traverseSession, &dicNode, childDicNode,
-                        allowsErrorCorrections)) {
-                    // TODO: (Gesture) Change weight between omission and substitution errors
-                    // TODO: (Gesture) Terminal node should not be handled as omission
-                    correctionDicNode.initByCopy(childDicNode);
-                    processDicNodeAsOmission(traverseSession, &correctionDicNode);
-                }
-                const ProximityType proximityType = TRAVERSAL->getProximityType(
-                        traverseSession, &dicNode, childDicNode);
-                switch (proximityType) {
-                    // TODO: Consider the difference of proximityType here
-                    case MATCH_CHAR:
-                    case PROXIMITY_CHAR:
-                        processDicNodeAsMatch(traverseSession, childDicNode);
-                        break;
-                    case ADDITIONAL_PROXIMITY_CHAR:
-                        if (allowsErrorCorrections) {
-                            processDicNodeAsAdditionalProximityChar(traverseSession, &dicNode,
-                                    childDicNode);
-                        }
-                        break;
-                    case SUBSTITUTION_CHAR:
-                        if (allowsErrorCorrections) {
-                            processDicNodeAsSubstitution(traverseSession, &dicNode, childDicNode);
-                        }
-                        break;
-                    case UNRELATED_CHAR:
-                        // Just drop this node and do nothing.
-                        break;
-                    default:
-                        // Just drop this node and do nothing.
-                        break;
-                }
-            }
+/**
+ * Expands the active dicNodes with the threads of the session. The i-th dicNode is expanded by
+ * the thread (i % threadCount), which records the pushes its expansion makes. The pushes are
+ * then replayed dicNode by dicNode, interleaved with what the serial expansion does between two
+ * dicNodes, so that the suggestions are exactly the ones of the serial expansion.
+ */
+void Suggest::expandCurrentDicNodesInParallel(DicTraverseSession *traverseSession,
+        const bool shouldDepthLevelCache) const {
+    DicNodesCache *const dicNodesCache = traverseSession->getDicTraverseCache();
+    std::vector<DicNode *> dicNodes;
+    dicNodes.reserve(dicNodesCache->activeSize());
+    std::vector<bool> shouldCacheDicNodes;
+    shouldCacheDicNodes.reserve(dicNodesCache->activeSize());
+    DicNode *exceedingDicNode = 0;
+    while (dicNodesCache->activeSize() > 0) {
+        DicNode *const dicNode = dicNodesCache->popActive();
+        if (dicNode->isTotalInputSizeExceedingLimit()) {
+            // The serial expansion stops here and leaves the remaining dicNodes queued.
+            exceedingDicNode = dicNode;
+            break;
+        }
+        const bool shouldCache =
+                shouldCacheDicNode(traverseSession, dicNode, shouldDepthLevelCache);
+        if (shouldCache) {
+            // Children inherit the flag, so it has to be set before expanding.
+            dicNode->setCached();
+        }
+        dicNodes.push_back(dicNode);
+        shouldCacheDicNodes.push_back(shouldCache);
+    }
+
+    ParallelExpansion parallelExpansion;
+    parallelExpansion.mSuggest = this;
+    parallelExpansion.mTraverseSession = traverseSession;
+    parallelExpansion.mDicNodes = &dicNodes;
+    traverseSession->getThreadPool()->run(expandDicNodesOfThread, &parallelExpansion);
+
+    const int threadCount = traverseSession->getExpansionThreadCount();
+    for (int i = 0; i < static_cast<int>(dicNodes.size()); ++i) {
+        if (shouldCacheDicNodes[i]) {
+            dicNodesCache->pushContinue(dicNodes[i]);
+        }
+        traverseSession->getWorker(i % threadCount)->replayNextExpansion(dicNodes[i]);
+        dicNodesCache->releaseDicNode(dicNodes[i]);
+    }
+    if (exceedingDicNode) {
+        dicNodesCache->releaseDicNode(exceedingDicNode);
+    }
+}
+
+/* static */ void Suggest::expandDicNodesOfThread(void *arg, const int threadIndex) {
+    const ParallelExpansion *const parallelExpansion = static_cast<ParallelExpansion *>(arg);
+    DicTraverseSession *const traverseSession = parallelExpansion->mTraverseSession;
+    const std::vector<DicNode *> *const dicNodes = parallelExpansion->mDicNodes;
+    const int threadCount = traverseSession->getExpansionThreadCount();
+    DicTraverseWorker *const worker = traverseSession->getWorker(threadIndex);
+    worker->beginRecording();
+    DicNode dicNode;
+    for (int i = threadIndex; i < static_cast<int>(dicNodes->size()); i += threadCount) {
+        // The dicNodes of the pool are shared between threads, so each thread expands a copy
+        // whose code points go to its own overlay of the word store.
+        dicNode.initByCopy((*dicNodes)[i]);
+        dicNode.setOverlayWordStore(worker->getOverlayWordStore());
+        parallelExpansion->mSuggest->expandDicNode(traverseSession, worker, &dicNode);
+        worker->endExpansion();
+    }
+}
 
-            // Push the node for look-ahead correction
-            if (allowsErrorCorrections && canDoLookAheadCorrection) {
-                traverseSession->getDicTraverseCache()->copyPushNextActive(&dicNode);
+bool Suggest::shouldCacheDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
+        const bool shouldDepthLevelCache) const {
+    const bool shouldNodeLevelCache = TRAVERSAL->shouldNodeLevelCache(traverseSession, dicNode);
+    if ((shouldDepthLevelCache || shouldNodeLevelCache) && DEBUG_CACHE) {
+        dicNode->dump("PUSH_CACHE");
+    }
+    return shouldDepthLevelCache || shouldNodeLevelCache;
+}
+
+void Suggest::expandDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+        DicNode *dicNode) const {
+    const int inputSize = traverseSession->getInputSize();
+    DicNodeVector childDicNodes(worker->getDicNodeArena());
+    DicNode correctionDicNode;
+    const int point0Index = dicNode->getInputIndex(0);
+    const bool canDoLookAheadCorrection =
+            TRAVERSAL->canDoLookAheadCorrection(traverseSession, dicNode);
+    const bool isLookAheadCorrection = canDoLookAheadCorrection
+            && traverseSession->getDicTraverseCache()->
+                    isLookAheadCorrectionInputIndex(static_cast<int>(point0Index));
+    const bool isCompletion = dicNode->isCompletion(inputSize);
+
+    if (dicNode->isInDigraph()) {
+        // Finish digraph handling if the node is in the middle of a digraph expansion.
+        correctionDicNode.initByCopy(dicNode);
+        processDicNodeAsDigraph(traverseSession, worker, &correctionDicNode);
+    } else if (isLookAheadCorrection) {
+        // The algorithm maintains a small set of "deferred" nodes that have not consumed the
+        // latest touch point yet. These are needed to apply look-ahead correction operations
+        // that require special handling of the latest touch point. For example, with insertions
+        // (e.g., "thiis" -> "this") the latest touch point should not be consumed at all.
+        processDicNodeAsTransposition(traverseSession, worker, dicNode);
+        processDicNodeAsInsertion(traverseSession, worker, dicNode);
+    } else { // !isLookAheadCorrection
+        // Only consider typing error corrections if the normalized compound distance is
+        // below a spatial distance threshold.
+        // NOTE: the threshold may need to be updated if scoring model changes.
+        // TODO: Remove. Do not prune node here.
+        const bool allowsErrorCorrections = TRAVERSAL->allowsErrorCorrections(dicNode);
+        // Process for handling space substitution (e.g., hevis => he is)
+        if (allowsErrorCorrections
+                && TRAVERSAL->isSpaceSubstitutionTerminal(traverseSession, dicNode)) {
+            createNextWordDicNode(traverseSession, worker, dicNode,
+                    true /* spaceSubstitution */);
+        }
+
+        DicNodeUtils::getAllChildDicNodes(dicNode, traverseSession->getOffsetDict(),
+                traverseSession->getDecodedTrie(), &childDicNodes);
+
+        const int childDicNodesSize = childDicNodes.getSizeAndLock();
+        for (int i = 0; i < childDicNodesSize; ++i) {
+            DicNode *const childDicNode = childDicNodes[i];
+            if (isPrunedBySubtreeProbability(traverseSession, childDicNode)) {
+                continue;
+            }
+            if (isCompletion) {
+                // Handle forward lookahead when the lexicon letter exceeds the input size.
+                processDicNodeAsMatch(traverseSession, worker, childDicNode);
+                continue;
+            }
+            if (DigraphUtils::hasDigraphForCodePoint(traverseSession->getDictFlags(),
+                    childDicNode->getNodeCodePoint())) {
+                correctionDicNode.initByCopy(childDicNode);
+                correctionDicNode.advanceDigraphIndex();
+                processDicNodeAsDigraph(traverseSession, worker, &correctionDicNode);
+            }
+            if (TRAVERSAL->isOmission(traverseSession, dicNode, childDicNode,
+                    allowsErrorCorrections)) {
+                // TODO: (Gesture) Change weight between omission and substitution errors
+                // TODO: (Gesture) Terminal node should not be handled as omission
+                correctionDicNode.initByCopy(childDicNode);
+                processDicNodeAsOmission(traverseSession, worker, &correctionDicNode);
+            }
+            const ProximityType proximityType = TRAVERSAL->getProximityType(
+                    traverseSession, dicNode, childDicNode);
+            switch (proximityType) {
+                // TODO: Consider the difference of proximityType here
+                case MATCH_CHAR:
+                case PROXIMITY_CHAR:
+                    processDicNodeAsMatch(traverseSession, worker, childDicNode);
+                    break;
+                case ADDITIONAL_PROXIMITY_CHAR:
+                    if (allowsErrorCorrections) {
+                        processDicNodeAsAdditionalProximityChar(traverseSession, worker,
+                                dicNode, childDicNode);
+                    }
+                    break;
+                case SUBSTITUTION_CHAR:
+                    if (allowsErrorCorrections) {
+                        processDicNodeAsSubstitution(traverseSession, worker, dicNode,
+                                childDicNode);
+                    }
+                    break;
+                case UNRELATED_CHAR:
+                    // Just drop this node and do nothing.
+                    break;
+                default:
+                    // Just drop this node and do nothing.
+                    break;
             }
         }
+
+        // Push the node for look-ahead correction
+        if (allowsErrorCorrections && canDoLookAheadCorrection) {
+            worker->pushExpandedDicNodeToNextActive(dicNode);
+        }
+    }
+}
+
+/**
+ * Returns whether none of the words below childDicNode can enter the terminal queue any more,
+ * using the max probabilities of subtrees stored in the dictionary.
+ */
+bool Suggest::isPrunedBySubtreeProbability(DicTraverseSession *traverseSession,
+        DicNode *childDicNode) const {
+    if (!(traverseSession->getDictFlags() & BinaryFormat::CONTAINS_SUBTREE_MAX_PROBABILITIES)) {
+        return false;
     }
+    return Weighting::isSubtreeBeyondCompoundDistance(WEIGHTING, traverseSession, childDicNode,
+            traverseSession->getDicTraverseCache()->getTerminalPruningDistance());
 }
 
-void Suggest::processTerminalDicNode(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
+void Suggest::processTerminalDicNode(DicTraverseSession *traverseSession,
+        DicTraverseWorker *worker, DicNode *dicNode) const {
     if (dicNode->getCompoundDistance() >= static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
         return;
     }
@@ -361,65 +487,68 @@ void Suggest::processTerminalDicNode(
         return;
     }
     // Create a non-cached node here.
-    DicNode terminalDicNode;
-    DicNodeUtils::initByCopy(dicNode, &terminalDicNode);
+    DicNode *const terminalDicNode = worker->copyTerminal(dicNode);
+    if (!terminalDicNode) {
+        return;
+    }
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_TERMINAL, traverseSession, 0,
-            &terminalDicNode, traverseSession->getMultiBigramMap());
-    traverseSession->getDicTraverseCache()->copyPushTerminal(&terminalDicNode);
+            terminalDicNode, worker->getMultiBigramMap());
+    worker->pushTerminal(terminalDicNode);
 }
 
 /**
  * Adds the expanded dicNode to the next search priority queue. Also creates an additional next word
  * (by the space omission error correction) search path if input dicNode is on a terminal node.
  */
-void Suggest::processExpandedDicNode(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
-    processTerminalDicNode(traverseSession, dicNode);
+void Suggest::processExpandedDicNode(DicTraverseSession *traverseSession,
+        DicTraverseWorker *worker, DicNode *dicNode) const {
+    processTerminalDicNode(traverseSession, worker, dicNode);
     if (dicNode->getCompoundDistance() < static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
         if (TRAVERSAL->isSpaceOmissionTerminal(traverseSession, dicNode)) {
-            createNextWordDicNode(traverseSession, dicNode, false /* spaceSubstitution */);
+            createNextWordDicNode(traverseSession, worker, dicNode,
+                    false /* spaceSubstitution */);
         }
         const int allowsLookAhead = !(dicNode->hasMultipleWords()
                 && dicNode->isCompletion(traverseSession->getInputSize()));
         if (dicNode->hasChildren() && allowsLookAhead) {
-            traverseSession->getDicTraverseCache()->copyPushNextActive(dicNode);
+            worker->copyPushNextActive(dicNode);
         }
     }
     DicNode::managedDelete(dicNode);
 }
 
 void Suggest::processDicNodeAsMatch(DicTraverseSession *traverseSession,
-        DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *childDicNode) const {
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 void Suggest::processDicNodeAsAdditionalProximityChar(DicTraverseSession *traverseSession,
-        DicNode *dicNode, DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const {
     // Note: Most types of corrections don't need to look up the bigram information since they do
     // not treat the node as a terminal. There is no need to pass the bigram map in these cases.
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_ADDITIONAL_PROXIMITY,
             traverseSession, dicNode, childDicNode, 0 /* multiBigramMap */);
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 void Suggest::processDicNodeAsSubstitution(DicTraverseSession *traverseSession,
-        DicNode *dicNode, DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const {
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_SUBSTITUTION, traverseSession,
             dicNode, childDicNode, 0 /* multiBigramMap */);
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 // Process the node codepoint as a digraph. This means that composite glyphs like the German
 // u-umlaut is expanded to the transliteration "ue". Note that this happens in parallel with
 // the normal non-digraph traversal, so both "uber" and "ueber" can be corrected to "[u-umlaut]ber".
 void Suggest::processDicNodeAsDigraph(DicTraverseSession *traverseSession,
-        DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *childDicNode) const {
     weightChildNode(traverseSession, childDicNode);
     childDicNode->advanceDigraphIndex();
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 /**
@@ -429,10 +558,11 @@ void Suggest::processDicNodeAsDigraph(DicTraverseSession *traverseSession,
  * the possible *next* letters after the omission to better limit search to plausible omissions.
  * Note that apostrophes are handled as omissions.
  */
-void Suggest::processDicNodeAsOmission(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
-    DicNodeVector childDicNodes;
-    DicNodeUtils::getAllChildDicNodes(dicNode, traverseSession->getOffsetDict(), &childDicNodes);
+void Suggest::processDicNodeAsOmission(DicTraverseSession *traverseSession,
+        DicTraverseWorker *worker, DicNode *dicNode) const {
+    DicNodeVector childDicNodes(worker->getDicNodeArena());
+    DicNodeUtils::getAllChildDicNodes(dicNode, traverseSession->getOffsetDict(),
+            traverseSession->getDecodedTrie(), &childDicNodes);
 
     const int size = childDicNodes.getSizeAndLock();
     for (int i = 0; i < size; i++) {
@@ -445,7 +575,7 @@ void Suggest::processDicNodeAsOmission(
         if (!TRAVERSAL->isPossibleOmissionChildNode(traverseSession, dicNode, childDicNode)) {
             continue;
         }
-        processExpandedDicNode(traverseSession, childDicNode);
+        processExpandedDicNode(traverseSession, worker, childDicNode);
     }
 }
 
@@ -454,17 +584,18 @@ void Suggest::processDicNodeAsOmission(
  * consider matches for the next touch point.
  */
 void Suggest::processDicNodeAsInsertion(DicTraverseSession *traverseSession,
-        DicNode *dicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode) const {
     const int16_t pointIndex = dicNode->getInputIndex(0);
-    DicNodeVector childDicNodes;
+    DicNodeVector childDicNodes(worker->getDicNodeArena());
     DicNodeUtils::getProximityChildDicNodes(dicNode, traverseSession->getOffsetDict(),
+            traverseSession->getDecodedTrie(), traverseSession->getCharGroupJumpTable(),
             traverseSession->getProximityInfoState(0), pointIndex + 1, true, &childDicNodes);
     const int size = childDicNodes.getSizeAndLock();
     for (int i = 0; i < size; i++) {
         DicNode *const childDicNode = childDicNodes[i];
         Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_INSERTION, traverseSession,
                 dicNode, childDicNode, 0 /* multiBigramMap */);
-        processExpandedDicNode(traverseSession, childDicNode);
+        processExpandedDicNode(traverseSession, worker, childDicNode);
     }
 }
 
@@ -472,24 +603,26 @@ void Suggest::processDicNodeAsInsertion(DicTraverseSession *traverseSession,
  * Handle the dicNode as a transposition error (e.g., thsi => this). Swap the next two touch points.
  */
 void Suggest::processDicNodeAsTransposition(DicTraverseSession *traverseSession,
-        DicNode *dicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode) const {
     const int16_t pointIndex = dicNode->getInputIndex(0);
-    DicNodeVector childDicNodes1;
+    DicNodeVector childDicNodes1(worker->getDicNodeArena());
     DicNodeUtils::getProximityChildDicNodes(dicNode, traverseSession->getOffsetDict(),
+            traverseSession->getDecodedTrie(), traverseSession->getCharGroupJumpTable(),
             traverseSession->getProximityInfoState(0), pointIndex + 1, false, &childDicNodes1);
     const int childSize1 = childDicNodes1.getSizeAndLock();
     for (int i = 0; i < childSize1; i++) {
         if (childDicNodes1[i]->hasChildren()) {
-            DicNodeVector childDicNodes2;
+            DicNodeVector childDicNodes2(worker->getDicNodeArena());
             DicNodeUtils::getProximityChildDicNodes(
                     childDicNodes1[i], traverseSession->getOffsetDict(),
+                    traverseSession->getDecodedTrie(), traverseSession->getCharGroupJumpTable(),
                     traverseSession->getProximityInfoState(0), pointIndex, false, &childDicNodes2);
             const int childSize2 = childDicNodes2.getSizeAndLock();
             for (int j = 0; j < childSize2; j++) {
                 DicNode *const childDicNode2 = childDicNodes2[j];
                 Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_TRANSPOSITION,
                         traverseSession, childDicNodes1[i], childDicNode2, 0 /* multiBigramMap */);
-                processExpandedDicNode(traverseSession, childDicNode2);
+                processExpandedDicNode(traverseSession, worker, childDicNode2);
             }
         }
         DicNode::managedDelete(childDicNodes1[i]);
@@ -514,8 +647,8 @@ void Suggest::weightChildNode(DicTraverseSession *traverseSession, DicNode *dicN
  * Creates a new dicNode that represents a space insertion at the end of the input dicNode. Also
  * incorporates the unigram / bigram score for the ending word into the new dicNode.
  */
-void Suggest::createNextWordDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
-        const bool spaceSubstitution) const {
+void Suggest::createNextWordDicNode(DicTraverseSession *traverseSession,
+        DicTraverseWorker *worker, DicNode *dicNode, const bool spaceSubstitution) const {
     if (!TRAVERSAL->isGoodToTraverseNextWord(dicNode)) {
         return;
     }
@@ -527,7 +660,7 @@ void Suggest::createNextWordDicNode(DicTraverseSession *traverseSession, DicNode
     const CorrectionType correctionType = spaceSubstitution ?
             CT_NEW_WORD_SPACE_SUBSTITUTION : CT_NEW_WORD_SPACE_OMITTION;
     Weighting::addCostAndForwardInputIndex(WEIGHTING, correctionType, traverseSession, dicNode,
-            &newDicNode, traverseSession->getMultiBigramMap());
-    traverseSession->getDicTraverseCache()->copyPushNextActive(&newDicNode);
+            &newDicNode, worker->getMultiBigramMap());
+    worker->copyPushNextActive(&newDicNode);
 }
 } // namespace latinime
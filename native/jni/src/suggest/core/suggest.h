@@ -34,6 +34,7 @@ namespace latinime {
 
 class DicNode;
 class DicTraverseSession;
+class DicTraverseWorker;
 class ProximityInfo;
 class Scoring;
 class Traversal;
@@ -52,28 +53,45 @@ class Suggest : public SuggestInterface {
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(Suggest);
-    void createNextWordDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
-            const bool spaceSubstitution) const;
+    // Argument of the tasks expanding the active dicNodes in parallel
+    struct ParallelExpansion;
+
+    void createNextWordDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode, const bool spaceSubstitution) const;
     int outputSuggestions(DicTraverseSession *traverseSession, int *frequencies,
             int *outputCodePoints, int *outputIndices, int *outputTypes) const;
     void initializeSearch(DicTraverseSession *traverseSession, int commitPoint) const;
     void expandCurrentDicNodes(DicTraverseSession *traverseSession) const;
-    void processTerminalDicNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processExpandedDicNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
+    void expandCurrentDicNodesInParallel(DicTraverseSession *traverseSession,
+            const bool shouldDepthLevelCache) const;
+    static void expandDicNodesOfThread(void *arg, const int threadIndex);
+    bool shouldCacheDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
+            const bool shouldDepthLevelCache) const;
+    void expandDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
+    bool isPrunedBySubtreeProbability(DicTraverseSession *traverseSession,
+            DicNode *childDicNode) const;
+    void processTerminalDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
+    void processExpandedDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
     void weightChildNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
     float getAutocorrectScore(DicTraverseSession *traverseSession, DicNode *dicNode) const;
     void generateFeatures(
             DicTraverseSession *traverseSession, DicNode *dicNode, float *features) const;
-    void processDicNodeAsOmission(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processDicNodeAsDigraph(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processDicNodeAsTransposition(DicTraverseSession *traverseSession,
+    void processDicNodeAsOmission(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
+    void processDicNodeAsDigraph(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
             DicNode *dicNode) const;
-    void processDicNodeAsInsertion(DicTraverseSession *traverseSession, DicNode *dicNode) const;
+    void processDicNodeAsTransposition(DicTraverseSession *traverseSession,
+            DicTraverseWorker *worker, DicNode *dicNode) const;
+    void processDicNodeAsInsertion(DicTraverseSession *traverseSession,
+            DicTraverseWorker *worker, DicNode *dicNode) const;
     void processDicNodeAsAdditionalProximityChar(DicTraverseSession *traverseSession,
-            DicNode *dicNode, DicNode *childDicNode) const;
-    void processDicNodeAsSubstitution(DicTraverseSession *traverseSession, DicNode *dicNode,
-            DicNode *childDicNode) const;
-    void processDicNodeAsMatch(DicTraverseSession *traverseSession,
+            DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const;
+    void processDicNodeAsSubstitution(DicTraverseSession *traverseSession,
+            DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const;
+    void processDicNodeAsMatch(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
             DicNode *childDicNode) const;
 
     // Inputs longer than this will autocorrect if the suggestion is multi-word
@@ -23,6 +23,8 @@ namespace latinime {
 
 class SuggestPolicy;
 
+// Like the typing policy, the gesture policy is a stateless singleton shared by all the
+// dictionaries. Its factory method is set while the library is loaded and only read afterwards.
 class GestureSuggestPolicyFactory {
  public:
     static void setGestureSuggestPolicyFactoryMethod(const SuggestPolicy *(*factoryMethod)()) {
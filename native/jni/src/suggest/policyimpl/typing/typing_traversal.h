@@ -23,7 +23,7 @@
 #include "defines.h"
 #include "proximity_info_state.h"
 #include "suggest/core/dicnode/dic_node.h"
-#include "suggest/core/dicnode/dic_node_vector.h"
+#include "suggest/core/dicnode/dic_node_utils.h"
 #include "suggest/core/policy/traversal.h"
 #include "suggest/core/session/dic_traverse_session.h"
 #include "suggest/policyimpl/typing/scoring_params.h"
@@ -106,7 +106,7 @@ class TypingTraversal : public Traversal {
     AK_FORCE_INLINE bool shouldDepthLevelCache(
             const DicTraverseSession *const traverseSession) const {
         const int inputSize = traverseSession->getInputSize();
-        return traverseSession->isCacheBorderForTyping(inputSize);
+        return traverseSession->canTakeCheckpointForTyping(inputSize);
     }
 
     AK_FORCE_INLINE bool shouldNodeLevelCache(
@@ -140,14 +140,12 @@ class TypingTraversal : public Traversal {
         return true;
     }
 
-    AK_FORCE_INLINE int getDefaultExpandDicNodeSize() const {
-        return DicNodeVector::DEFAULT_NODES_SIZE_FOR_OPTIMIZATION;
-    }
-
     AK_FORCE_INLINE bool sameAsTyped(
             const DicTraverseSession *const traverseSession, const DicNode *const dicNode) const {
+        int codePoints[MAX_WORD_LENGTH];
+        dicNode->outputCurrentWord(codePoints);
         return traverseSession->getProximityInfoState(0)->sameAsTyped(
-                dicNode->getOutputWordBuf(), dicNode->getDepth());
+                codePoints, dicNode->getDepth());
     }
 
     AK_FORCE_INLINE int getMaxCacheSize() const {
@@ -170,7 +168,7 @@ class TypingTraversal : public Traversal {
         if (probability < ScoringParams::THRESHOLD_NEXT_WORD_PROBABILITY) {
             return false;
         }
-        const int c = dicNode->getOutputWordBuf()[0];
+        const int c = dicNode->getOutputWordCodePointAt(0);
         const bool shortCappedWord = dicNode->getDepth()
                 < ScoringParams::THRESHOLD_SHORT_WORD_LENGTH && isAsciiUpper(c);
         return !shortCappedWord
@@ -26,15 +26,18 @@
 #include "proximity_info.h"
 #include "terminal_attributes.h"
 #include "unigram_dictionary.h"
+#include "word_position_index.h"
 #include "words_priority_queue.h"
 #include "words_priority_queue_pool.h"
 
 namespace latinime {
 
 // TODO: check the header
-UnigramDictionary::UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags)
+UnigramDictionary::UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags,
+        const WordPositionIndex *const wordPositionIndex)
         : DICT_ROOT(streamStart), ROOT_POS(0),
-          MAX_DIGRAPH_SEARCH_DEPTH(DEFAULT_MAX_DIGRAPH_SEARCH_DEPTH), DICT_FLAGS(dictFlags) {
+          MAX_DIGRAPH_SEARCH_DEPTH(DEFAULT_MAX_DIGRAPH_SEARCH_DEPTH), DICT_FLAGS(dictFlags),
+          mWordPositionIndex(wordPositionIndex) {
     if (DEBUG_DICT) {
         AKLOGI("UnigramDictionary - constructor");
     }
@@ -806,8 +809,11 @@ int UnigramDictionary::getMostProbableWordLikeInner(const int *const inWord, con
 
 int UnigramDictionary::getProbability(const int *const inWord, const int length) const {
     const uint8_t *const root = DICT_ROOT;
-    int pos = BinaryFormat::getTerminalPosition(root, inWord, length,
-            false /* forceLowerCaseSearch */);
+    int pos = mWordPositionIndex
+            ? mWordPositionIndex->getTerminalPosition(inWord, length,
+                    false /* forceLowerCaseSearch */)
+            : BinaryFormat::getTerminalPosition(root, inWord, length,
+                    false /* forceLowerCaseSearch */);
     if (NOT_VALID_WORD == pos) {
         return NOT_A_PROBABILITY;
     }
@@ -27,6 +27,7 @@ namespace latinime {
 class Correction;
 class ProximityInfo;
 class TerminalAttributes;
+class WordPositionIndex;
 class WordsPriorityQueuePool;
 
 class UnigramDictionary {
@@ -38,7 +39,8 @@ class UnigramDictionary {
     static const int FLAG_MULTIPLE_SUGGEST_ABORT = 0;
     static const int FLAG_MULTIPLE_SUGGEST_SKIP = 1;
     static const int FLAG_MULTIPLE_SUGGEST_CONTINUE = 2;
-    UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags);
+    UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags,
+            const WordPositionIndex *const wordPositionIndex);
     int getProbability(const int *const inWord, const int length) const;
     int getBigramPosition(int pos, int *word, int offset, int length) const;
     int getSuggestions(ProximityInfo *proximityInfo, const int *xcoordinates,
@@ -111,6 +113,8 @@ class UnigramDictionary {
     const int ROOT_POS;
     const int MAX_DIGRAPH_SEARCH_DEPTH;
     const int DICT_FLAGS;
+    // Positions of the words, or 0 if the words have to be looked up in the dictionary
+    const WordPositionIndex *const mWordPositionIndex;
 };
 } // namespace latinime
 #endif // LATINIME_UNIGRAM_DICTIONARY_H
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: word_position_index.cpp"
+
+#include "word_position_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "binary_format.h"
+#include "char_utils.h"
+#include "defines.h"
+
+namespace latinime {
+
+namespace {
+// Node to read, with the hash of the code points of its parent char groups.
+struct NodeToRead {
+    int mPos;
+    uint64_t mHash;
+};
+
+const uint64_t EMPTY_WORD_HASH = 0xCBF29CE484222325ULL;
+} // namespace
+
+WordPositionIndex::WordPositionIndex(const uint8_t *const dicRoot)
+        : mDicRoot(dicRoot), mBuildMutex(), mIsBuilt(false), mWordCount(0),
+          mBucketDisplacements(), mSlots() {
+    pthread_mutex_init(&mBuildMutex, 0);
+}
+
+void WordPositionIndex::build() const {
+    pthread_mutex_lock(&mBuildMutex);
+    if (mIsBuilt) {
+        pthread_mutex_unlock(&mBuildMutex);
+        return;
+    }
+    std::vector<uint64_t> hashes;
+    std::vector<int> terminalPositions;
+    std::vector<NodeToRead> nodesToRead;
+    const NodeToRead root = { 0, EMPTY_WORD_HASH };
+    nodesToRead.push_back(root);
+    while (!nodesToRead.empty()) {
+        const NodeToRead node = nodesToRead.back();
+        nodesToRead.pop_back();
+        int pos = node.mPos;
+        const int groupCount = BinaryFormat::getGroupCountAndForwardPointer(mDicRoot, &pos);
+        for (int i = 0; i < groupCount; ++i) {
+            const int groupPos = pos;
+            const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(mDicRoot, &pos);
+            int codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &pos);
+            uint64_t hash = addToHash(node.mHash, codePoint);
+            if (flags & BinaryFormat::FLAG_HAS_MULTIPLE_CHARS) {
+                codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &pos);
+                while (NOT_A_CODE_POINT != codePoint) {
+                    hash = addToHash(hash, codePoint);
+                    codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &pos);
+                }
+            }
+            if (flags & BinaryFormat::FLAG_IS_TERMINAL) {
+                hashes.push_back(finishHash(hash));
+                terminalPositions.push_back(groupPos);
+            }
+            pos = BinaryFormat::skipProbability(flags, pos);
+            if (BinaryFormat::hasChildrenInFlags(flags)) {
+                const NodeToRead children =
+                        { BinaryFormat::readChildrenPosition(mDicRoot, flags, pos), hash };
+                nodesToRead.push_back(children);
+            }
+            pos = BinaryFormat::skipChildrenPosAndAttributes(mDicRoot, flags, pos);
+        }
+    }
+    if (placeWords(hashes, terminalPositions)) {
+        mWordCount = static_cast<int>(hashes.size());
+    } else {
+        AKLOGE("WordPositionIndex: could not place %d words",
+                static_cast<int>(hashes.size()));
+    }
+    if (DEBUG_DICT) {
+        AKLOGI("WordPositionIndex: %d words, %d slots", mWordCount,
+                static_cast<int>(mSlots.size()));
+    }
+    // Makes the slots visible to the threads that read mIsBuilt without locking.
+    __sync_synchronize();
+    mIsBuilt = true;
+    pthread_mutex_unlock(&mBuildMutex);
+}
+
+bool WordPositionIndex::placeWords(const std::vector<uint64_t> &hashes,
+        const std::vector<int> &terminalPositions) const {
+    const int wordCount = static_cast<int>(hashes.size());
+    if (wordCount == 0) {
+        return false;
+    }
+    const int bucketCount = (wordCount + WORDS_PER_BUCKET - 1) / WORDS_PER_BUCKET;
+    mBucketDisplacements.assign(bucketCount, 0);
+    const Slot emptySlot = { 0, NOT_VALID_WORD };
+    mSlots.assign(wordCount + wordCount / SLOT_SLACK_RATIO + 1, emptySlot);
+
+    // Words by bucket.
+    std::vector<int> bucketStarts(bucketCount + 1, 0);
+    for (int i = 0; i < wordCount; ++i) {
+        ++bucketStarts[getBucketIndex(hashes[i]) + 1];
+    }
+    for (int i = 0; i < bucketCount; ++i) {
+        bucketStarts[i + 1] += bucketStarts[i];
+    }
+    std::vector<int> bucketWords(wordCount);
+    std::vector<int> bucketEnds(bucketStarts.begin(), bucketStarts.end() - 1);
+    for (int i = 0; i < wordCount; ++i) {
+        bucketWords[bucketEnds[getBucketIndex(hashes[i])]++] = i;
+    }
+
+    // The largest buckets are placed first, while most slots are free.
+    std::vector<std::pair<int, int> > bucketsBySize;
+    bucketsBySize.reserve(bucketCount);
+    for (int i = 0; i < bucketCount; ++i) {
+        const int size = bucketStarts[i + 1] - bucketStarts[i];
+        if (size > 0) {
+            bucketsBySize.push_back(std::pair<int, int>(-size, i));
+        }
+    }
+    std::sort(bucketsBySize.begin(), bucketsBySize.end());
+    std::vector<int> slotIndices;
+    for (size_t i = 0; i < bucketsBySize.size(); ++i) {
+        const int bucketIndex = bucketsBySize[i].second;
+        const int *const words = &bucketWords[0] + bucketStarts[bucketIndex];
+        const int size = -bucketsBySize[i].first;
+        bool isPlaced = false;
+        for (int displacement = 0; displacement <= MAX_DISPLACEMENT && !isPlaced;
+                ++displacement) {
+            slotIndices.clear();
+            for (int j = 0; j < size; ++j) {
+                const int slotIndex = getSlotIndex(hashes[words[j]], displacement);
+                if (mSlots[slotIndex].mTerminalPosition != NOT_VALID_WORD
+                        || std::find(slotIndices.begin(), slotIndices.end(), slotIndex)
+                                != slotIndices.end()) {
+                    break;
+                }
+                slotIndices.push_back(slotIndex);
+            }
+            if (static_cast<int>(slotIndices.size()) == size) {
+                mBucketDisplacements[bucketIndex] = static_cast<uint16_t>(displacement);
+                for (int j = 0; j < size; ++j) {
+                    mSlots[slotIndices[j]].mFingerprint = getFingerprint(hashes[words[j]]);
+                    mSlots[slotIndices[j]].mTerminalPosition = terminalPositions[words[j]];
+                }
+                isPlaced = true;
+            }
+        }
+        if (!isPlaced) {
+            // Only words with the same hash can't be told apart by any displacement.
+            mBucketDisplacements.clear();
+            mSlots.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+int WordPositionIndex::getTerminalPosition(const int *const inWord, const int length,
+        const bool forceLowerCaseSearch) const {
+    if (length <= 0) {
+        return NOT_VALID_WORD;
+    }
+    buildIfNeeded();
+    if (mSlots.empty()) {
+        return BinaryFormat::getTerminalPosition(mDicRoot, inWord, length,
+                forceLowerCaseSearch);
+    }
+    uint64_t hash = EMPTY_WORD_HASH;
+    if (forceLowerCaseSearch) {
+        // The dictionary search only lowers the first code point of each char group. The first
+        // code point of the word always starts one, so the word is looked up with only that code
+        // point lowered when the others are already in lower case.
+        hash = addToHash(hash, toLowerCase(inWord[0]));
+        for (int i = 1; i < length; ++i) {
+            if (toLowerCase(inWord[i]) != inWord[i]) {
+                return BinaryFormat::getTerminalPosition(mDicRoot, inWord, length,
+                        true /* forceLowerCaseSearch */);
+            }
+            hash = addToHash(hash, inWord[i]);
+        }
+    } else {
+        for (int i = 0; i < length; ++i) {
+            hash = addToHash(hash, inWord[i]);
+        }
+    }
+    hash = finishHash(hash);
+    const Slot &slot = mSlots[getSlotIndex(hash, mBucketDisplacements[getBucketIndex(hash)])];
+    if (slot.mFingerprint != getFingerprint(hash)
+            || !isCharGroupAtEndOfWord(slot.mTerminalPosition, inWord, length,
+                    forceLowerCaseSearch)) {
+        // The word of the dictionary in the slot of the word isn't the word, so the word isn't
+        // in the dictionary.
+        return NOT_VALID_WORD;
+    }
+    return slot.mTerminalPosition;
+}
+
+bool WordPositionIndex::isCharGroupAtEndOfWord(const int pos, const int *const word,
+        const int length, const bool forceLowerCaseSearch) const {
+    int codePoints[MAX_WORD_LENGTH];
+    int codePointCount = 0;
+    int readPos = pos;
+    const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(mDicRoot, &readPos);
+    int codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &readPos);
+    while (NOT_A_CODE_POINT != codePoint) {
+        if (codePointCount >= length || codePointCount >= MAX_WORD_LENGTH) {
+            return false;
+        }
+        codePoints[codePointCount++] = codePoint;
+        if (!(flags & BinaryFormat::FLAG_HAS_MULTIPLE_CHARS)) {
+            break;
+        }
+        codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &readPos);
+    }
+    const int start = length - codePointCount;
+    for (int i = 0; i < codePointCount; ++i) {
+        const int wordCodePoint = (forceLowerCaseSearch && start + i == 0)
+                ? toLowerCase(word[0]) : word[start + i];
+        if (codePoints[i] != wordCodePoint) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace latinime
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_WORD_POSITION_INDEX_H
+#define LATINIME_WORD_POSITION_INDEX_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Perfect hash of the words of a dictionary to the positions of their terminal char groups, so
+ * that looking up a word hashes its code points once instead of reading the char groups of every
+ * node on its path. The words are hashed into buckets of a few words, and each bucket stores the
+ * displacement that sends its words to free slots, so a lookup reads one bucket and one slot. A
+ * slot only keeps a 32-bit fingerprint of its word, so a hit is checked against the char group it
+ * points to. Reading every word of the dictionary takes a while, so the index is built on the
+ * first lookup rather than when the dictionary is opened. It is read-only afterwards, so it can
+ * be shared by all the sessions.
+ */
+class WordPositionIndex {
+ public:
+    explicit WordPositionIndex(const uint8_t *const dicRoot);
+    // Non virtual inline destructor -- never inherit this class
+    ~WordPositionIndex() {
+        pthread_mutex_destroy(&mBuildMutex);
+    }
+
+    // Returns the position of the terminal char group of word, or NOT_VALID_WORD, like
+    // BinaryFormat::getTerminalPosition(). The lower case searches that don't only lower the
+    // first code point read the dictionary.
+    int getTerminalPosition(const int *const inWord, const int length,
+            const bool forceLowerCaseSearch) const;
+
+    int getWordCount() const {
+        buildIfNeeded();
+        return mWordCount;
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(WordPositionIndex);
+
+    struct Slot {
+        uint32_t mFingerprint;
+        int mTerminalPosition;
+    };
+
+    // Average number of words in a bucket.
+    static const int WORDS_PER_BUCKET = 4;
+    // The slots outnumber the words by 1/SLOT_SLACK_RATIO so that the last buckets to place
+    // still find free slots quickly.
+    static const int SLOT_SLACK_RATIO = 16;
+    static const int MAX_DISPLACEMENT = 0xFFFF;
+
+    static AK_FORCE_INLINE uint64_t addToHash(const uint64_t hash, const int codePoint) {
+        // 64-bit FNV-1a on the code points.
+        return (hash ^ static_cast<uint32_t>(codePoint)) * 0x100000001B3ULL;
+    }
+
+    static AK_FORCE_INLINE uint64_t finishHash(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        return hash ^ (hash >> 33);
+    }
+
+    AK_FORCE_INLINE int getBucketIndex(const uint64_t hash) const {
+        return static_cast<int>(static_cast<uint32_t>(hash >> 32) % mBucketDisplacements.size());
+    }
+
+    AK_FORCE_INLINE int getSlotIndex(const uint64_t hash, const int displacement) const {
+        const uint64_t slotHash =
+                finishHash(hash + static_cast<uint64_t>(displacement + 1) * 0x9E3779B97F4A7C15ULL);
+        return static_cast<int>(static_cast<uint32_t>(slotHash >> 32) % mSlots.size());
+    }
+
+    static AK_FORCE_INLINE uint32_t getFingerprint(const uint64_t hash) {
+        return static_cast<uint32_t>(hash);
+    }
+
+    AK_FORCE_INLINE void buildIfNeeded() const {
+        if (mIsBuilt) {
+            // Pairs with the barrier in build(), so that the slots are read after mIsBuilt.
+            __sync_synchronize();
+            return;
+        }
+        build();
+    }
+
+    // Hashes the words of the dictionary into the slots, unless another thread already did.
+    void build() const;
+
+    // Places the words of hashes and terminalPositions in the slots. Returns false if some bucket
+    // can't be placed, which leaves the index empty.
+    bool placeWords(const std::vector<uint64_t> &hashes,
+            const std::vector<int> &terminalPositions) const;
+
+    // Returns whether the code points of the char group at pos end word, so that a word with the
+    // fingerprint of another one isn't found at its position.
+    bool isCharGroupAtEndOfWord(const int pos, const int *const word, const int length,
+            const bool forceLowerCaseSearch) const;
+
+    const uint8_t *const mDicRoot;
+    // The index is built by the first lookup, so the members below are set by const methods
+    // while mBuildMutex is held.
+    mutable pthread_mutex_t mBuildMutex;
+    mutable volatile bool mIsBuilt;
+    mutable int mWordCount;
+    mutable std::vector<uint16_t> mBucketDisplacements;
+    mutable std::vector<Slot> mSlots;
+};
+} // namespace latinime
+#endif // LATINIME_WORD_POSITION_INDEX_H
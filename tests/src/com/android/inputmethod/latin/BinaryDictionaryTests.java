@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.inputmethod.latin;
+
+import android.test.suitebuilder.annotation.LargeTest;
+import android.util.Log;
+
+import com.android.inputmethod.keyboard.Keyboard;
+import com.android.inputmethod.keyboard.ProximityInfo;
+import com.android.inputmethod.latin.SuggestedWords.SuggestedWordInfo;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Locale;
+
+/**
+ * Tests for the native API of BinaryDictionary on the main English dictionary.
+ */
+@LargeTest
+public class BinaryDictionaryTests extends InputTestsBase {
+    private static final String TAG = BinaryDictionaryTests.class.getSimpleName();
+    private static final int SESSION_ID = 1;
+    private static final int REFERENCE_SESSION_ID = 2;
+    private static final String WORD = "accomodate";
+    private static final String PREV_WORD = "to";
+    private static final int GESTURE_POINTS_PER_KEY = 4;
+    private static final int GESTURE_POINT_INTERVAL = 10;
+    private static final int GESTURE_PART_COUNT = 3;
+
+    // For the concurrency tests.
+    private static final int THREAD_COUNT = 4;
+    private static final int ROUNDS = 20;
+    private static final int THROUGHPUT_ATTEMPTS = 3;
+    private static final float MIN_SPEEDUP = 1.5f;
+    private static final String[] CONCURRENT_WORDS = { "the", "hello", "thsi", "wprld",
+            "becuase", "definately", "recieve", "accomodate", "keybaord", "tommorow", "youre",
+            "seperate" };
+    private static final String[] CONCURRENT_PREV_WORDS = { null, "the", "of", "I" };
+
+    // For the batch lookup tests.
+    private static final String[] BATCH_WORDS = {
+        "the", "The", "THE", "accommodate", "accomodate", "", null, "about", "xqzv"
+    };
+    private static final String[] BATCH_NEXT_WORDS = {
+        "first", "same", "", "to", "the", "of", "is", null, "the"
+    };
+
+    private BinaryDictionary mDictionary;
+    private ProximityInfo mProximityInfo;
+
+    @Override
+    protected void setUp() throws Exception {
+        super.setUp();
+        mDictionary = DictionaryFactory.createBinaryDictionary(mLatinIME, Locale.US);
+        assertNotNull("main dictionary", mDictionary);
+        mProximityInfo = mKeyboard.getProximityInfo();
+    }
+
+    @Override
+    protected void tearDown() throws Exception {
+        mDictionary.close();
+        super.tearDown();
+    }
+
+    private WordComposer getComposer(final String word) {
+        return getComposer(word, mKeyboard);
+    }
+
+    private static WordComposer getComposer(final String word, final Keyboard keyboard) {
+        final WordComposer composer = new WordComposer();
+        composer.setComposingWord(word, keyboard);
+        return composer;
+    }
+
+    private ArrayList<SuggestedWordInfo> getSuggestions(final WordComposer composer,
+            final String prevWord, final int sessionId) {
+        return mDictionary.getSuggestionsWithSessionId(composer, prevWord, mProximityInfo,
+                false /* blockOffensiveWords */, sessionId);
+    }
+
+    private static String toString(final ArrayList<SuggestedWordInfo> suggestions) {
+        final StringBuilder sb = new StringBuilder();
+        for (final SuggestedWordInfo info : suggestions) {
+            sb.append(info.mWord).append('/').append(info.mScore).append(' ');
+        }
+        return sb.toString();
+    }
+
+    // Concurrent sessions
+
+    private String getConcurrentSuggestions(final WordComposer[] composers, final int index,
+            final int sessionId) {
+        return toString(getSuggestions(composers[index % composers.length],
+                CONCURRENT_PREV_WORDS[index / composers.length], sessionId));
+    }
+
+    // Runs ROUNDS rounds of suggestions on each of threadCount threads, each thread using its
+    // own session, checks they match the suggestions of a single session, and returns the
+    // number of rounds per second.
+    private float runRounds(final int threadCount) throws InterruptedException {
+        final WordComposer[] composers = new WordComposer[CONCURRENT_WORDS.length];
+        for (int i = 0; i < CONCURRENT_WORDS.length; ++i) {
+            composers[i] = getComposer(CONCURRENT_WORDS[i]);
+        }
+        final String[] expectedSuggestions =
+                new String[CONCURRENT_WORDS.length * CONCURRENT_PREV_WORDS.length];
+        for (int i = 0; i < expectedSuggestions.length; ++i) {
+            expectedSuggestions[i] = getConcurrentSuggestions(composers, i, 0 /* sessionId */);
+        }
+        final Thread[] threads = new Thread[threadCount];
+        final String[] errors = new String[threadCount];
+        for (int t = 0; t < threadCount; ++t) {
+            final int threadIndex = t;
+            threads[t] = new Thread() {
+                @Override
+                public void run() {
+                    for (int round = 0; round < ROUNDS; ++round) {
+                        for (int i = 0; i < expectedSuggestions.length; ++i) {
+                            final String suggestions =
+                                    getConcurrentSuggestions(composers, i, threadIndex + 1);
+                            if (!expectedSuggestions[i].equals(suggestions)) {
+                                errors[threadIndex] = "suggestions #" + i + " on thread "
+                                        + threadIndex + ": " + suggestions;
+                                return;
+                            }
+                        }
+                    }
+                }
+            };
+        }
+        final long startTime = System.nanoTime();
+        for (final Thread thread : threads) {
+            thread.start();
+        }
+        for (final Thread thread : threads) {
+            thread.join();
+        }
+        final long elapsedTime = System.nanoTime() - startTime;
+        for (final String error : errors) {
+            assertNull(error, error);
+        }
+        return threadCount * ROUNDS * 1e9f / elapsedTime;
+    }
+
+    public void testConcurrentSessionsGiveSerialResults() throws InterruptedException {
+        runRounds(THREAD_COUNT);
+    }
+
+    // Checks that the throughput goes up with the sessions on devices with a core per session.
+    // The bound is loose and the best of a few attempts counts, so that a busy device doesn't
+    // fail the test.
+    public void testThroughputScalesWithSessions() throws InterruptedException {
+        final int processorCount = Runtime.getRuntime().availableProcessors();
+        float bestSpeedup = 0.0f;
+        for (int attempt = 0; attempt < THROUGHPUT_ATTEMPTS; ++attempt) {
+            final float serialThroughput = runRounds(1);
+            final float parallelThroughput = runRounds(THREAD_COUNT);
+            Log.d(TAG, "rounds per second: " + serialThroughput + " with 1 session, "
+                    + parallelThroughput + " with " + THREAD_COUNT + " sessions on "
+                    + processorCount + " processors");
+            bestSpeedup = Math.max(bestSpeedup, parallelThroughput / serialThroughput);
+            if (processorCount < THREAD_COUNT || bestSpeedup > MIN_SPEEDUP) {
+                break;
+            }
+        }
+        if (processorCount >= THREAD_COUNT) {
+            assertTrue("speedup with " + THREAD_COUNT + " sessions: " + bestSpeedup,
+                    bestSpeedup > MIN_SPEEDUP);
+        }
+    }
+
+    // Search budget
+
+    public void testUnboundedSearchIsComplete() {
+        mDictionary.setSearchBudget(SESSION_ID, 0 /* timeBudgetMicros */,
+                0 /* maxExpandedDicNodeCount */);
+        assertFalse("suggestions",
+                getSuggestions(getComposer(WORD), null /* prevWord */, SESSION_ID).isEmpty());
+        assertFalse("partial search", mDictionary.isLastSearchPartial(SESSION_ID));
+    }
+
+    public void testExhaustedSearchIsPartial() {
+        final WordComposer composer = getComposer(WORD);
+        mDictionary.setSearchBudget(SESSION_ID, 0 /* timeBudgetMicros */,
+                1 /* maxExpandedDicNodeCount */);
+        assertNotNull("suggestions", getSuggestions(composer, null /* prevWord */, SESSION_ID));
+        assertTrue("partial search", mDictionary.isLastSearchPartial(SESSION_ID));
+        mDictionary.setSearchBudget(SESSION_ID, 0 /* timeBudgetMicros */,
+                0 /* maxExpandedDicNodeCount */);
+        getSuggestions(composer, null /* prevWord */, SESSION_ID);
+        assertFalse("partial search after lifting the budget",
+                mDictionary.isLastSearchPartial(SESSION_ID));
+    }
+
+    // Bigram maps
+
+    public void testBigramMapCounts() {
+        final int[] initialCounts = mDictionary.getBigramMapCounts(SESSION_ID);
+        assertEquals("initial hit count", 0, initialCounts[0]);
+        assertEquals("initial miss count", 0, initialCounts[1]);
+        getSuggestions(getComposer(WORD), PREV_WORD, SESSION_ID);
+        final int[] counts = mDictionary.getBigramMapCounts(SESSION_ID);
+        assertTrue("bigram lookups", counts[0] + counts[1] > 0);
+    }
+
+    // Shared buffer
+
+    // Checks that the suggestions with the input in the shared buffer of a session are the ones
+    // with the input in arrays.
+    private void assertSameSuggestionsWithoutSharedBuffer(final String message,
+            final WordComposer composer, final String prevWord) {
+        final ArrayList<SuggestedWordInfo> expected =
+                mDictionary.getSuggestionsWithoutSharedBuffer(composer, prevWord, mProximityInfo,
+                        false /* blockOffensiveWords */, REFERENCE_SESSION_ID);
+        final ArrayList<SuggestedWordInfo> actual = getSuggestions(composer, prevWord, SESSION_ID);
+        assertFalse("suggestions for " + message, expected.isEmpty());
+        assertEquals("suggestions for " + message, toString(expected), toString(actual));
+    }
+
+    public void testSharedBufferWithPrevWord() {
+        assertSameSuggestionsWithoutSharedBuffer(WORD + " after " + PREV_WORD, getComposer(WORD),
+                PREV_WORD);
+    }
+
+    public void testSharedBufferWithEmptyInput() {
+        // Only the bigrams of the previous word are suggested.
+        assertSameSuggestionsWithoutSharedBuffer("no input after " + PREV_WORD, getComposer(""),
+                PREV_WORD);
+    }
+
+    public void testGestureTooLongForSharedBuffer() {
+        // Gestures need the gesture policy, which is only in the builds enabling gesture input.
+        if (!Settings.readFromBuildConfigIfGestureInputEnabled(mLatinIME.getResources())) {
+            return;
+        }
+        final InputPointers pointers = getGesturePointers(WORD,
+                DicTraverseSession.MAX_SHARED_INPUT_POINT_COUNT / (WORD.length() - 1) + 1);
+        final int size = pointers.getPointerSize();
+        assertTrue("gesture point count", size > DicTraverseSession.MAX_SHARED_INPUT_POINT_COUNT);
+        assertSameSuggestionsWithoutSharedBuffer("gesture of " + size + " points",
+                getGestureComposer(pointers, size), PREV_WORD);
+    }
+
+    // Batch suggestions
+
+    public void testSuggestionsBatchMatchesSuggestions() {
+        final StringBuilder longWord = new StringBuilder();
+        while (longWord.length() < Constants.Dictionary.MAX_WORD_LENGTH + 2) {
+            longWord.append(WORD);
+        }
+        final String[] words = { "the", WORD, "", longWord.toString(), "thsi", "" };
+        final String[] prevWords = { "of", null, PREV_WORD, null, PREV_WORD, null };
+        final WordComposer[] composers = new WordComposer[words.length];
+        for (int i = 0; i < words.length; ++i) {
+            composers[i] = getComposer(words[i]);
+        }
+        final ArrayList<ArrayList<SuggestedWordInfo>> suggestionsList =
+                mDictionary.getSuggestionsBatch(composers, prevWords, mProximityInfo,
+                        false /* blockOffensiveWords */, SESSION_ID);
+        assertEquals("suggestion list count", words.length, suggestionsList.size());
+        for (int i = 0; i < words.length; ++i) {
+            final ArrayList<SuggestedWordInfo> expected =
+                    getSuggestions(composers[i], prevWords[i], REFERENCE_SESSION_ID);
+            final String message = "suggestions for \"" + words[i] + "\" after " + prevWords[i];
+            if (null == expected) {
+                assertNull(message, suggestionsList.get(i));
+            } else {
+                assertEquals(message, toString(expected), toString(suggestionsList.get(i)));
+            }
+        }
+    }
+
+    public void testSuggestionsBatchRejectsGestures() {
+        final WordComposer gesture = new WordComposer();
+        gesture.setBatchInputWord(WORD);
+        final WordComposer[] composers = { getComposer(WORD), gesture };
+        try {
+            mDictionary.getSuggestionsBatch(composers, new String[composers.length],
+                    mProximityInfo, false /* blockOffensiveWords */, SESSION_ID);
+            fail("gesture in a batch of suggestions");
+        } catch (final IllegalArgumentException e) {
+            // Expected.
+        }
+    }
+
+    // Batch lookups
+
+    public void testGetFrequenciesMatchesGetFrequency() {
+        final int[] frequencies = mDictionary.getFrequencies(BATCH_WORDS);
+        assertEquals("frequency count", BATCH_WORDS.length, frequencies.length);
+        for (int i = 0; i < BATCH_WORDS.length; ++i) {
+            assertEquals("frequency of " + BATCH_WORDS[i],
+                    mDictionary.getFrequency(BATCH_WORDS[i]), frequencies[i]);
+        }
+    }
+
+    public void testIsValidBigramsMatchesIsValidBigram() {
+        final boolean[] results = mDictionary.isValidBigrams(BATCH_WORDS, BATCH_NEXT_WORDS);
+        assertEquals("result count", BATCH_WORDS.length, results.length);
+        for (int i = 0; i < BATCH_WORDS.length; ++i) {
+            assertEquals("bigram " + BATCH_WORDS[i] + " " + BATCH_NEXT_WORDS[i],
+                    mDictionary.isValidBigram(BATCH_WORDS[i], BATCH_NEXT_WORDS[i]), results[i]);
+        }
+    }
+
+    public void testEmptyBatches() {
+        assertEquals("frequency count", 0, mDictionary.getFrequencies(new String[0]).length);
+        assertEquals("result count", 0,
+                mDictionary.isValidBigrams(new String[0], new String[0]).length);
+    }
+
+    // Streamed input
+
+    // Appends the touch points of composer from index start to end, one key press at a time.
+    private void appendKeyPresses(final WordComposer composer, final int start, final int end) {
+        final InputPointers ips = composer.getInputPointers();
+        for (int i = start; i < end; ++i) {
+            final int[] codePoint = { composer.getCodeAt(i) };
+            final int[] x = { ips.getXCoordinates()[i] };
+            final int[] y = { ips.getYCoordinates()[i] };
+            final int[] time = { ips.getTimes()[i] };
+            final int[] pointerId = { ips.getPointerIds()[i] };
+            mDictionary.appendTouchPoints(SESSION_ID, codePoint, x, y, time, pointerId, 1);
+        }
+    }
+
+    // Appends the touch points of word from index start on, one key press at a time.
+    private void appendKeyPresses(final String word, final int start) {
+        final WordComposer composer = getComposer(word);
+        appendKeyPresses(composer, start, composer.size());
+    }
+
+    private InputPointers getGesturePointers(final String word) {
+        return getGesturePointers(word, GESTURE_POINTS_PER_KEY);
+    }
+
+    // Returns a gesture through the keys of word, with pointsPerKey points from each key to the
+    // next one.
+    private InputPointers getGesturePointers(final String word, final int pointsPerKey) {
+        final InputPointers keys = getComposer(word).getInputPointers();
+        final int keyCount = keys.getPointerSize();
+        final int[] xs = keys.getXCoordinates();
+        final int[] ys = keys.getYCoordinates();
+        final InputPointers pointers = new InputPointers(keyCount * pointsPerKey);
+        int index = 0;
+        for (int i = 0; i < keyCount; ++i) {
+            final int next = Math.min(i + 1, keyCount - 1);
+            final int steps = (next == i) ? 1 : pointsPerKey;
+            for (int step = 0; step < steps; ++step) {
+                pointers.addPointer(index, xs[i] + (xs[next] - xs[i]) * step / steps,
+                        ys[i] + (ys[next] - ys[i]) * step / steps, 0 /* pointerId */,
+                        index * GESTURE_POINT_INTERVAL);
+                ++index;
+            }
+        }
+        return pointers;
+    }
+
+    // Appends the touch points of pointers from index start to end as one part of a gesture.
+    private void appendGesturePart(final InputPointers pointers, final int start, final int end) {
+        mDictionary.appendTouchPoints(SESSION_ID, null /* codePoints */,
+                Arrays.copyOfRange(pointers.getXCoordinates(), start, end),
+                Arrays.copyOfRange(pointers.getYCoordinates(), start, end),
+                Arrays.copyOfRange(pointers.getTimes(), start, end),
+                Arrays.copyOfRange(pointers.getPointerIds(), start, end), end - start);
+    }
+
+    // Returns a composer whose input is the gesture of the first size touch points of pointers.
+    private static WordComposer getGestureComposer(final InputPointers pointers, final int size) {
+        final InputPointers gesture = new InputPointers(size);
+        for (int i = 0; i < size; ++i) {
+            gesture.addPointer(i, pointers.getXCoordinates()[i], pointers.getYCoordinates()[i],
+                    pointers.getPointerIds()[i], pointers.getTimes()[i]);
+        }
+        final WordComposer composer = new WordComposer();
+        composer.setBatchInputPointers(gesture);
+        return composer;
+    }
+
+    // Checks that the suggestions for the input of the session are the ones for the whole input
+    // of composer on another session.
+    private void assertSameSuggestions(final String message, final WordComposer composer) {
+        final ArrayList<SuggestedWordInfo> expected =
+                getSuggestions(composer, PREV_WORD, REFERENCE_SESSION_ID);
+        final ArrayList<SuggestedWordInfo> actual = mDictionary.getSuggestionsForSessionInput(
+                SESSION_ID, PREV_WORD, mProximityInfo, composer.isBatchMode(),
+                false /* blockOffensiveWords */);
+        assertEquals("suggestions for " + message, toString(expected), toString(actual));
+    }
+
+    private void assertSameSuggestions(final String word) {
+        assertSameSuggestions(word, getComposer(word));
+    }
+
+    public void testStreamedKeyPressesMatchWholeInput() {
+        mDictionary.resetInput(SESSION_ID);
+        for (int i = 0; i < WORD.length(); ++i) {
+            appendKeyPresses(WORD.substring(0, i + 1), i);
+            assertSameSuggestions(WORD.substring(0, i + 1));
+        }
+    }
+
+    public void testRemoveLastInput() {
+        mDictionary.resetInput(SESSION_ID);
+        appendKeyPresses(WORD + "x", 0);
+        assertSameSuggestions(WORD + "x");
+        mDictionary.removeLastInput(SESSION_ID);
+        assertSameSuggestions(WORD);
+        mDictionary.removeLastInput(SESSION_ID);
+        mDictionary.removeLastInput(SESSION_ID);
+        assertSameSuggestions(WORD.substring(0, WORD.length() - 2));
+    }
+
+    public void testResetInput() {
+        mDictionary.resetInput(SESSION_ID);
+        appendKeyPresses(WORD, 0);
+        assertSameSuggestions(WORD);
+        mDictionary.resetInput(SESSION_ID);
+        appendKeyPresses("the", 0);
+        assertSameSuggestions("the");
+        mDictionary.resetInput(SESSION_ID);
+        assertSameSuggestions("");
+    }
+
+    public void testStreamedGestureMatchesWholeInput() {
+        // Gestures need the gesture policy, which is only in the builds enabling gesture input.
+        if (!Settings.readFromBuildConfigIfGestureInputEnabled(mLatinIME.getResources())) {
+            return;
+        }
+        final InputPointers pointers = getGesturePointers(WORD);
+        final int size = pointers.getPointerSize();
+        mDictionary.resetInput(SESSION_ID);
+        int end = 0;
+        for (int part = 1; part <= GESTURE_PART_COUNT; ++part) {
+            final int start = end;
+            end = size * part / GESTURE_PART_COUNT;
+            appendGesturePart(pointers, start, end);
+            assertSameSuggestions("gesture part " + part, getGestureComposer(pointers, end));
+        }
+        mDictionary.removeLastInput(SESSION_ID);
+        assertSameSuggestions("gesture without its last part", getGestureComposer(pointers,
+                size * (GESTURE_PART_COUNT - 1) / GESTURE_PART_COUNT));
+    }
+
+    public void testKeyboardSwitch() {
+        final Keyboard keyboard = mKeyboard;
+        final WordComposer composer = getComposer(WORD);
+        final int switchIndex = WORD.length() / 2;
+        mDictionary.resetInput(SESSION_ID);
+        appendKeyPresses(composer, 0, switchIndex);
+        assertSameSuggestions(WORD.substring(0, switchIndex));
+        // The touch points already appended are searched again with the other keyboard.
+        changeLanguage("fr");
+        mProximityInfo = mKeyboard.getProximityInfo();
+        assertNotSame("proximity info", keyboard.getProximityInfo(), mProximityInfo);
+        final String prefix = WORD.substring(0, switchIndex);
+        assertSameSuggestions(prefix + " on the other keyboard", getComposer(prefix, keyboard));
+        appendKeyPresses(composer, switchIndex, composer.size());
+        assertSameSuggestions(WORD + " on the other keyboard", composer);
+    }
+
+    public void testWholeInputBetweenStreamedInputs() {
+        final int splitIndex = WORD.length() / 2;
+        mDictionary.resetInput(SESSION_ID);
+        appendKeyPresses(WORD.substring(0, splitIndex), 0);
+        assertSameSuggestions(WORD.substring(0, splitIndex));
+        // A search on another input in between resets what the session reuses of its input.
+        getSuggestions(getComposer("the"), PREV_WORD, SESSION_ID);
+        assertSameSuggestions(WORD.substring(0, splitIndex));
+        getSuggestions(getComposer("the"), PREV_WORD, SESSION_ID);
+        appendKeyPresses(WORD, splitIndex);
+        assertSameSuggestions(WORD);
+    }
+}
@@ -71,6 +71,12 @@ public class BinaryDictIOTests extends AndroidTestCase {
             new FormatSpec.FormatOptions(3, false /* supportsDynamicUpdate */);
     private static final FormatSpec.FormatOptions VERSION3_WITH_DYNAMIC_UPDATE =
             new FormatSpec.FormatOptions(3, true /* supportsDynamicUpdate */);
+    private static final FormatSpec.FormatOptions VERSION2_WITH_SUBTREE_MAX_FREQUENCIES =
+            new FormatSpec.FormatOptions(2, false /* supportsDynamicUpdate */,
+                    true /* containsSubtreeMaxFrequencies */);
+    private static final FormatSpec.FormatOptions VERSION2_WITH_CHILD_TABLES =
+            new FormatSpec.FormatOptions(2, false /* supportsDynamicUpdate */,
+                    false /* containsSubtreeMaxFrequencies */, true /* containsChildTables */);
 
     public BinaryDictIOTests() {
         super();
@@ -243,7 +249,10 @@ public class BinaryDictIOTests extends AndroidTestCase {
         String result = " : buffer type = "
                 + ((bufferType == USE_BYTE_BUFFER) ? "byte buffer" : "byte array");
         result += " : version = " + formatOptions.mVersion;
-        return result + ", supportsDynamicUpdate = " + formatOptions.mSupportsDynamicUpdate;
+        result += ", supportsDynamicUpdate = " + formatOptions.mSupportsDynamicUpdate;
+        result += ", containsSubtreeMaxFrequencies = "
+                + formatOptions.mContainsSubtreeMaxFrequencies;
+        return result + ", containsChildTables = " + formatOptions.mContainsChildTables;
     }
 
     // Tests for readDictionaryBinary and writeDictionaryBinary
@@ -312,6 +321,9 @@ public class BinaryDictIOTests extends AndroidTestCase {
         runReadAndWriteTests(results, USE_BYTE_BUFFER, VERSION2);
         runReadAndWriteTests(results, USE_BYTE_BUFFER, VERSION3_WITHOUT_DYNAMIC_UPDATE);
         runReadAndWriteTests(results, USE_BYTE_BUFFER, VERSION3_WITH_DYNAMIC_UPDATE);
+        runReadAndWriteTests(results, USE_BYTE_BUFFER,
+                VERSION2_WITH_SUBTREE_MAX_FREQUENCIES);
+        runReadAndWriteTests(results, USE_BYTE_BUFFER, VERSION2_WITH_CHILD_TABLES);
 
         for (final String result : results) {
             Log.d(TAG, result);
@@ -324,6 +336,9 @@ public class BinaryDictIOTests extends AndroidTestCase {
         runReadAndWriteTests(results, USE_BYTE_ARRAY, VERSION2);
         runReadAndWriteTests(results, USE_BYTE_ARRAY, VERSION3_WITHOUT_DYNAMIC_UPDATE);
         runReadAndWriteTests(results, USE_BYTE_ARRAY, VERSION3_WITH_DYNAMIC_UPDATE);
+        runReadAndWriteTests(results, USE_BYTE_ARRAY,
+                VERSION2_WITH_SUBTREE_MAX_FREQUENCIES);
+        runReadAndWriteTests(results, USE_BYTE_ARRAY, VERSION2_WITH_CHILD_TABLES);
 
         for (final String result : results) {
             Log.d(TAG, result);
@@ -457,6 +472,9 @@ public class BinaryDictIOTests extends AndroidTestCase {
         runReadUnigramsAndBigramsTests(results, USE_BYTE_BUFFER, VERSION2);
         runReadUnigramsAndBigramsTests(results, USE_BYTE_BUFFER, VERSION3_WITHOUT_DYNAMIC_UPDATE);
         runReadUnigramsAndBigramsTests(results, USE_BYTE_BUFFER, VERSION3_WITH_DYNAMIC_UPDATE);
+        runReadUnigramsAndBigramsTests(results, USE_BYTE_BUFFER,
+                VERSION2_WITH_SUBTREE_MAX_FREQUENCIES);
+        runReadUnigramsAndBigramsTests(results, USE_BYTE_BUFFER, VERSION2_WITH_CHILD_TABLES);
 
         for (final String result : results) {
             Log.d(TAG, result);
@@ -469,6 +487,9 @@ public class BinaryDictIOTests extends AndroidTestCase {
         runReadUnigramsAndBigramsTests(results, USE_BYTE_ARRAY, VERSION2);
         runReadUnigramsAndBigramsTests(results, USE_BYTE_ARRAY, VERSION3_WITHOUT_DYNAMIC_UPDATE);
         runReadUnigramsAndBigramsTests(results, USE_BYTE_ARRAY, VERSION3_WITH_DYNAMIC_UPDATE);
+        runReadUnigramsAndBigramsTests(results, USE_BYTE_ARRAY,
+                VERSION2_WITH_SUBTREE_MAX_FREQUENCIES);
+        runReadUnigramsAndBigramsTests(results, USE_BYTE_ARRAY, VERSION2_WITH_CHILD_TABLES);
 
         for (final String result : results) {
             Log.d(TAG, result);
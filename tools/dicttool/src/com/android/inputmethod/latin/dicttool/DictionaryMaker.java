@@ -47,6 +47,8 @@ public class DictionaryMaker {
         private static final String OPTION_VERSION_1 = "-1";
         private static final String OPTION_VERSION_2 = "-2";
         private static final String OPTION_VERSION_3 = "-3";
+        private static final String OPTION_SUBTREE_MAX_FREQUENCIES = "-m";
+        private static final String OPTION_CHILD_TABLES = "-t";
         private static final String OPTION_INPUT_SOURCE = "-s";
         private static final String OPTION_INPUT_BIGRAM_XML = "-b";
         private static final String OPTION_INPUT_SHORTCUT_XML = "-c";
@@ -63,6 +65,8 @@ public class DictionaryMaker {
         public final String mOutputXml;
         public final String mOutputCombined;
         public final int mOutputBinaryFormatVersion;
+        public final boolean mOutputSubtreeMaxFrequencies;
+        public final boolean mOutputChildTables;
 
         private void checkIntegrity() throws IOException {
             checkHasExactlyOneInput();
@@ -127,13 +131,19 @@ public class DictionaryMaker {
                     + "| [-s <combined format input]"
                     + "| [-s <binary input>] [-d <binary output>] [-x <xml output>] "
                     + " [-o <combined output>]"
-                    + "[-1] [-2] [-3]\n"
+                    + "[-1] [-2] [-3] [-m] [-t]\n"
                     + "\n"
                     + "  Converts a source dictionary file to one or several outputs.\n"
                     + "  Source can be an XML file, with an optional XML bigrams file, or a\n"
                     + "  binary dictionary file.\n"
                     + "  Binary version 1 (Ice Cream Sandwich), 2 (Jelly Bean), 3, XML and\n"
-                    + "  combined format outputs are supported.";
+                    + "  combined format outputs are supported.\n"
+                    + "  With -m, the binary output stores the max frequency of each subtree,\n"
+                    + "  which lets the suggestion search prune the subtrees without good words\n"
+                    + "  (versions 2 and 3).\n"
+                    + "  With -t, the binary output stores a table of the first characters of\n"
+                    + "  the children of each large node, which lets the suggestion search\n"
+                    + "  jump to the matching children (versions 2 and 3).";
         }
 
         public Arguments(String[] argsArray) throws IOException {
@@ -150,6 +160,8 @@ public class DictionaryMaker {
             String outputXml = null;
             String outputCombined = null;
             int outputBinaryFormatVersion = 2; // the default version is 2.
+            boolean outputSubtreeMaxFrequencies = false;
+            boolean outputChildTables = false;
 
             while (!args.isEmpty()) {
                 final String arg = args.get(0);
@@ -161,6 +173,10 @@ public class DictionaryMaker {
                         outputBinaryFormatVersion = 3;
                     } else if (OPTION_VERSION_1.equals(arg)) {
                         outputBinaryFormatVersion = 1;
+                    } else if (OPTION_SUBTREE_MAX_FREQUENCIES.equals(arg)) {
+                        outputSubtreeMaxFrequencies = true;
+                    } else if (OPTION_CHILD_TABLES.equals(arg)) {
+                        outputChildTables = true;
                     } else if (OPTION_HELP.equals(arg)) {
                         displayHelp();
                     } else {
@@ -222,6 +238,8 @@ public class DictionaryMaker {
             mOutputXml = outputXml;
             mOutputCombined = outputCombined;
             mOutputBinaryFormatVersion = outputBinaryFormatVersion;
+            mOutputSubtreeMaxFrequencies = outputSubtreeMaxFrequencies;
+            mOutputChildTables = outputChildTables;
             checkIntegrity();
         }
     }
@@ -347,7 +365,8 @@ public class DictionaryMaker {
             throws FileNotFoundException, IOException, UnsupportedFormatException,
             IllegalArgumentException {
         if (null != args.mOutputBinary) {
-            writeBinaryDictionary(args.mOutputBinary, dict, args.mOutputBinaryFormatVersion);
+            writeBinaryDictionary(args.mOutputBinary, dict, args.mOutputBinaryFormatVersion,
+                    args.mOutputSubtreeMaxFrequencies, args.mOutputChildTables);
         }
         if (null != args.mOutputXml) {
             writeXmlDictionary(args.mOutputXml, dict);
@@ -363,14 +382,19 @@ public class DictionaryMaker {
      * @param outputFilename the name of the file to write to.
      * @param dict the dictionary to write.
      * @param version the binary format version to use.
+     * @param containsSubtreeMaxFrequencies whether to store the max frequency of each subtree.
+     * @param containsChildTables whether to store the child tables of the large nodes.
      * @throws FileNotFoundException if the output file can't be created.
      * @throws IOException if the output file can't be written to.
      */
     private static void writeBinaryDictionary(final String outputFilename,
-            final FusionDictionary dict, final int version)
+            final FusionDictionary dict, final int version,
+            final boolean containsSubtreeMaxFrequencies, final boolean containsChildTables)
             throws FileNotFoundException, IOException, UnsupportedFormatException {
         final File outputFile = new File(outputFilename);
-        final FormatSpec.FormatOptions formatOptions = new FormatSpec.FormatOptions(version);
+        final FormatSpec.FormatOptions formatOptions = new FormatSpec.FormatOptions(version,
+                false /* supportsDynamicUpdate */, containsSubtreeMaxFrequencies,
+                containsChildTables);
         BinaryDictInputOutput.writeDictionaryBinary(new FileOutputStream(outputFilename), dict,
                 formatOptions);
     }